@@ -0,0 +1,138 @@
+#ifndef ZELDATRACKER_GAMEANIMATION_H
+#define ZELDATRACKER_GAMEANIMATION_H
+
+/*
+ * Animation as a function of time instead of something stepped along: a looping path of
+ * keyframes walked at a constant speed, and holds that freeze it for a while (link stopping to
+ * stab). Where something is at any moment comes straight out of the elapsed time, so an hour
+ * of stall costs the same to catch up on as one frame, and whatever the renderer is handed is
+ * exactly where it should be at that instant.
+ */
+
+#define GAN_MAX_KEYS 16
+
+struct PathKey {
+    int x;
+    int y;
+    int facing;             // held from this key to the next
+};
+
+struct Path {
+    struct PathKey keys[GAN_MAX_KEYS];
+    double at[GAN_MAX_KEYS + 1];    // distance along the loop each key is reached at, at[total_keys] = length
+    int total_keys;
+    double length;                  // once around, in px
+    double px_per_ms;
+};
+
+struct Hold {
+    double held_ms;         // time spent in holds that are over
+    double from;            // start of the latest hold, ms
+    double until;           // its end, from == until for none
+};
+
+
+/********************************************//**
+ * @brief
+ * Sets up a closed loop through keys, walked at px_per_ms. Segments should be straight lines
+ * along x or y, the last key leads back to the first.
+ * @param path struct Path*
+ * @param keys const struct PathKey*
+ * @param total_keys int no more than GAN_MAX_KEYS
+ * @param px_per_ms double
+ * @return int
+ * 0 on success, -1 if there are too many keys or the loop has no length
+ ***********************************************/
+int GAN_InitPath(struct Path *path, const struct PathKey *keys, int total_keys, double px_per_ms) {
+    if (total_keys < 1 || total_keys > GAN_MAX_KEYS || px_per_ms <= 0)
+        return -1;
+
+    path->total_keys = total_keys;
+    path->px_per_ms = px_per_ms;
+    path->at[0] = 0;
+    for (int k = 0; k < total_keys; k++) {
+        const struct PathKey *from = &keys[k];
+        const struct PathKey *to = &keys[(k + 1) % total_keys];
+
+        path->keys[k] = *from;
+        path->at[k + 1] = path->at[k] + SDL_abs(to->x - from->x) + SDL_abs(to->y - from->y);
+    }
+    path->length = path->at[total_keys];
+
+    return (path->length > 0) ? 0 : -1;
+}
+
+/********************************************//**
+ * @brief
+ * Where the path is after walking for ms
+ * @param path const struct Path*
+ * @param ms double
+ * @param at SDL_Point* receives the position, whole px
+ * @return int
+ * facing there
+ ***********************************************/
+int GAN_EvalPath(const struct Path *path, double ms, SDL_Point *at) {
+    double walked = SDL_fmod(ms * path->px_per_ms, path->length);
+    int k = 0;
+
+    if (walked < 0)
+        walked += path->length;
+
+    // A handful of keys at most, the cost doesn't depend on ms
+    while (k + 1 < path->total_keys && walked >= path->at[k + 1])
+        k++;
+
+    const struct PathKey *from = &path->keys[k];
+    const struct PathKey *to = &path->keys[(k + 1) % path->total_keys];
+    double along = walked - path->at[k];
+
+    at->x = from->x + (int)(along) * ((to->x > from->x) - (to->x < from->x));
+    at->y = from->y + (int)(along) * ((to->y > from->y) - (to->y < from->y));
+    return from->facing;
+}
+
+/********************************************//**
+ * @brief
+ * Starts holding at now for ms, unless a hold is still running
+ * @param hold struct Hold*
+ * @param now double ms
+ * @param ms double
+ * @return int
+ * 1 if it started, 0 if the last one isn't over yet
+ ***********************************************/
+int GAN_StartHold(struct Hold *hold, double now, double ms) {
+    if (now < hold->until)
+        return 0;
+
+    hold->held_ms += hold->until - hold->from;
+    hold->from = now;
+    hold->until = now + ms;
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * Whether a hold is running at now
+ * @param hold const struct Hold*
+ * @param now double ms
+ * @return int
+ ***********************************************/
+int GAN_Holding(const struct Hold *hold, double now) {
+    return now >= hold->from && now < hold->until;
+}
+
+/********************************************//**
+ * @brief
+ * How long whatever the holds pause has been going at now, every hold taken out
+ * @param hold const struct Hold*
+ * @param now double ms
+ * @return double
+ * ms
+ ***********************************************/
+double GAN_Unheld(const struct Hold *hold, double now) {
+    double latest = ((now < hold->until) ? now : hold->until) - hold->from;
+
+    return now - hold->held_ms - ((latest > 0) ? latest : 0);
+}
+
+#endif //ZELDATRACKER_GAMEANIMATION_H
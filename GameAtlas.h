@@ -0,0 +1,501 @@
+#ifndef ZELDATRACKER_GAMEATLAS_H
+#define ZELDATRACKER_GAMEATLAS_H
+
+/*
+ * The sprite atlas is packed at build time (tools/AtlasPack) from sprites-link.png, atlas.cfg and
+ * sprites.cfg, and compiled in as SpriteAtlas.h: raw RGBA pixels plus one AtlasRect per named
+ * rect / sprites.cfg entry. Startup is a single texture upload, no PNG decode and no file I/O.
+ *
+ * sprites.cfg can still be edited without a rebuild. A cell the build didn't pack is copied out
+ * of the sheet (loaded on first use) into the spare rows below the packed ones.
+ *
+ * The sheet can be edited too: GA_ReloadSheet compares every rect against a CPU copy of the
+ * texture and re-uploads only the ones whose pixels moved.
+ *
+ * Drawing a 16px cell 48px wide every frame is a stretch the GPU (or worse, the software
+ * renderer) pays each time, so GA_ScaledTexture keeps a few nearest-neighbour copies of the atlas
+ * blown up by whole factors. Rects in a copy are the atlas rects times the factor, and anything
+ * written to the atlas is written to every copy as well.
+ *
+ * Software rendering has no textures at all, it blits out of an ARGB8888 copy of the pixels
+ * (the window surface's order) that is kept up to date the same way.
+ */
+struct AtlasRect {
+    const char *name;
+    int sheet_x;        // where it came from in sprites-link.png
+    int sheet_y;
+    int w;
+    int h;
+    int x;              // where it lives in the atlas
+    int y;
+};
+
+#include "SpriteAtlas.h"
+
+#define GA_MAX_EXTRA_CELLS 64
+#define GA_MAX_VARIANTS 4
+
+const char *GA_SHEET_PATH = "sprites-link.png";
+const int GA_CELL_SIZE = 16;                // a grid cell, as drawn
+const int GA_EXTRA_ROWS = 4;                // spare shelves for cells the build didn't pack
+
+struct AtlasVariant {
+    int factor;                             // 0 for an unused entry
+    SDL_Texture *texture;
+    Uint32 used;                            // uses when it was last handed out, the oldest goes first
+};
+
+struct Atlas {
+    SDL_Texture *texture;
+    int w;
+    int h;
+    Uint8 *pixels;                          // what's in the texture, RGBA32, w * 4 pitch
+    struct Raster raster;                   // software rendering only, pixels in ARGB8888
+    SDL_Surface *sheet;                     // only loaded if sprites.cfg outgrew the build
+    SDL_Rect extra_sheet[GA_MAX_EXTRA_CELLS];
+    SDL_Rect extra[GA_MAX_EXTRA_CELLS];
+    int total_extra;
+
+    struct AtlasVariant variants[GA_MAX_VARIANTS];     // pre-scaled copies, see GA_ScaledTexture
+    Uint32 uses;
+};
+
+
+/********************************************//**
+ * @brief
+ * Copies a rect of the RGBA32 pixels into the software raster, converting to ARGB8888
+ * @param atlas struct Atlas*
+ * @param rect const SDL_Rect*
+ * @return void
+ ***********************************************/
+void GA_ConvertRect(struct Atlas *atlas, const SDL_Rect *rect) {
+    SDL_ConvertPixels(rect->w, rect->h, SDL_PIXELFORMAT_RGBA32,
+                      atlas->pixels + ((size_t)rect->y * atlas->w + rect->x) * 4, atlas->w * 4,
+                      SDL_PIXELFORMAT_ARGB8888,
+                      atlas->raster.pixels + (size_t)rect->y * atlas->raster.pitch + rect->x,
+                      atlas->raster.pitch * 4);
+}
+
+/********************************************//**
+ * @brief
+ * Uploads the embedded pixels, the texture is left with room for GA_EXTRA_ROWS more cells
+ * @param atlas struct Atlas*
+ * @param renderer SDL_Renderer* NULL for software rendering, only the raster is made
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GA_InitAtlas(struct Atlas *atlas, SDL_Renderer *renderer) {
+    SDL_Rect packed = { 0, 0, GA_ATLAS_WIDTH, GA_ATLAS_HEIGHT };
+
+    atlas->w = GA_ATLAS_WIDTH;
+    atlas->h = GA_ATLAS_HEIGHT + GA_EXTRA_ROWS * (GA_CELL_SIZE + 1);
+    atlas->sheet = NULL;
+    atlas->total_extra = 0;
+    memset(atlas->variants, 0, sizeof(atlas->variants));
+    atlas->uses = 0;
+
+    atlas->pixels = calloc((size_t)atlas->w * atlas->h, 4);
+    if (atlas->pixels == NULL) {
+        DEBUG_ERR("Unable to allocate the atlas pixels");
+        return -1;
+    }
+    memcpy(atlas->pixels, GA_ATLAS_PIXELS, (size_t)GA_ATLAS_WIDTH * GA_ATLAS_HEIGHT * 4);
+
+    memset(&atlas->raster, 0, sizeof(atlas->raster));
+    atlas->texture = NULL;
+    if (renderer == NULL) {
+        if (GX_InitRaster(&atlas->raster, atlas->w, atlas->h) != 0)
+            return -1;
+        GA_ConvertRect(atlas, &packed);
+        return 0;
+    }
+
+    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                       atlas->w, atlas->h);
+    if (atlas->texture == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+
+    if (SDL_UpdateTexture(atlas->texture, &packed, GA_ATLAS_PIXELS, GA_ATLAS_WIDTH * 4) != 0) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Atlas rect of a named sprite, index is one of the GA_<NAME> defines
+ * @param index int
+ * @return SDL_Rect
+ ***********************************************/
+SDL_Rect GA_Rect(int index) {
+    SDL_Rect rect = {
+            GA_ATLAS_RECTS[index].x, GA_ATLAS_RECTS[index].y,
+            GA_ATLAS_RECTS[index].w, GA_ATLAS_RECTS[index].h
+    };
+    return rect;
+}
+
+/********************************************//**
+ * @brief
+ * Finds a sheet rect among the ones packed at build time
+ * @return int
+ * index into GA_ATLAS_RECTS, -1 if it wasn't packed
+ ***********************************************/
+int GA_FindSheetRect(int sheet_x, int sheet_y, int w, int h) {
+    for (int i = 0; i < GA_ATLAS_TOTAL_RECTS; i++)
+        if (GA_ATLAS_RECTS[i].sheet_x == sheet_x && GA_ATLAS_RECTS[i].sheet_y == sheet_y
+            && GA_ATLAS_RECTS[i].w == w && GA_ATLAS_RECTS[i].h == h)
+            return i;
+
+    return -1;
+}
+
+/********************************************//**
+ * @brief
+ * Drops the fallback sheet once every cell has been resolved
+ * @param atlas struct Atlas*
+ * @return void
+ ***********************************************/
+void GA_ReleaseSheet(struct Atlas *atlas) {
+    SDL_FreeSurface(atlas->sheet);
+    atlas->sheet = NULL;
+}
+
+/********************************************//**
+ * @brief
+ * Reads and decodes the sheet into RGBA32. Touches no atlas, safe on a worker thread.
+ * @return SDL_Surface*
+ * NULL on failure
+ ***********************************************/
+SDL_Surface *GA_DecodeSheet(void) {
+    SDL_Surface *loaded;
+    SDL_Surface *sheet;
+
+    // IMG_Load brings the PNG decoder up itself the first time, nobody pays for it unless it's needed
+    loaded = IMG_Load(GA_SHEET_PATH);
+    if (loaded == NULL) {
+        DEBUG_ERR(IMG_GetError());
+        return NULL;
+    }
+    sheet = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (sheet == NULL)
+        DEBUG_ERR(SDL_GetError());
+
+    return sheet;
+}
+
+/********************************************//**
+ * @brief
+ * Hands the atlas a sheet decoded ahead of time (GA_DecodeSheet), so GA_ResolveCell doesn't
+ * have to. The atlas owns it from here.
+ * @param atlas struct Atlas*
+ * @param sheet SDL_Surface* may be NULL
+ * @return void
+ ***********************************************/
+void GA_AdoptSheet(struct Atlas *atlas, SDL_Surface *sheet) {
+    if (atlas->sheet != NULL) {
+        SDL_FreeSurface(sheet);
+        return;
+    }
+    atlas->sheet = sheet;
+}
+
+/********************************************//**
+ * @brief
+ * Decodes the sheet, if it isn't already
+ * @param atlas struct Atlas*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GA_LoadSheet(struct Atlas *atlas) {
+    if (atlas->sheet == NULL)
+        atlas->sheet = GA_DecodeSheet();
+
+    return (atlas->sheet != NULL) ? 0 : -1;
+}
+
+/********************************************//**
+ * @brief
+ * Writes a rect of the atlas's CPU copy into a pre-scaled copy, every pixel repeated factor
+ * times across and down
+ * @param atlas const struct Atlas*
+ * @param variant struct AtlasVariant*
+ * @param rect const SDL_Rect* in the atlas, unscaled
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GA_ScaleInto(const struct Atlas *atlas, struct AtlasVariant *variant, const SDL_Rect *rect) {
+    int factor = variant->factor;
+    int pitch = rect->w * factor * 4;
+    SDL_Rect scaled = { rect->x * factor, rect->y * factor, rect->w * factor, rect->h * factor };
+    Uint8 *pixels = malloc((size_t)pitch * scaled.h);
+    int result = 0;
+
+    if (pixels == NULL) {
+        DEBUG_ERR("Unable to allocate a scaled atlas");
+        return -1;
+    }
+
+    // One source row is spread out once, then repeated for the rest of the factor
+    for (int row = 0; row < rect->h; row++) {
+        const Uint32 *source = (const Uint32 *)(atlas->pixels + ((size_t)(rect->y + row) * atlas->w + rect->x) * 4);
+        Uint32 *spread = (Uint32 *)(pixels + (size_t)row * factor * pitch);
+
+        for (int x = 0; x < rect->w; x++)
+            for (int f = 0; f < factor; f++)
+                spread[x * factor + f] = source[x];
+        for (int f = 1; f < factor; f++)
+            memcpy((Uint8 *)spread + (size_t)f * pitch, spread, (size_t)pitch);
+    }
+
+    if (SDL_UpdateTexture(variant->texture, &scaled, pixels, pitch) != 0) {
+        DEBUG_ERR(SDL_GetError());
+        result = -1;
+    }
+    free(pixels);
+    return result;
+}
+
+/********************************************//**
+ * @brief
+ * The atlas blown up by a whole factor, built the first time that factor is asked for. Only
+ * GA_MAX_VARIANTS are kept, the one handed out longest ago makes room for a new one, so don't
+ * hang on to more textures than that at once.
+ * @param atlas struct Atlas*
+ * @param renderer SDL_Renderer*
+ * @param factor int
+ * @return SDL_Texture*
+ * the atlas's own texture for a factor of 1, NULL if the copy can't be made (too big for the
+ * renderer, out of memory)
+ ***********************************************/
+SDL_Texture *GA_ScaledTexture(struct Atlas *atlas, SDL_Renderer *renderer, int factor) {
+    SDL_Rect whole = { 0, 0, atlas->w, atlas->h };
+    struct AtlasVariant *variant = &atlas->variants[0];
+    SDL_RendererInfo info;
+    Uint8 alpha = 255;
+
+    if (factor <= 1)
+        return atlas->texture;
+
+    atlas->uses++;
+    for (int i = 0; i < GA_MAX_VARIANTS; i++)
+        if (atlas->variants[i].factor == factor) {
+            atlas->variants[i].used = atlas->uses;
+            return atlas->variants[i].texture;
+        }
+
+    if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0
+        && (atlas->w * factor > info.max_texture_width || atlas->h * factor > info.max_texture_height))
+        return NULL;
+
+    for (int i = 0; i < GA_MAX_VARIANTS; i++) {
+        if (atlas->variants[i].factor == 0) {
+            variant = &atlas->variants[i];
+            break;
+        }
+        if (atlas->variants[i].used < variant->used)
+            variant = &atlas->variants[i];
+    }
+
+    if (variant->texture != NULL)
+        SDL_DestroyTexture(variant->texture);
+    variant->factor = 0;
+    variant->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                         atlas->w * factor, atlas->h * factor);
+    if (variant->texture == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return NULL;
+    }
+
+    SDL_SetTextureBlendMode(variant->texture, SDL_BLENDMODE_BLEND);
+    SDL_GetTextureAlphaMod(atlas->texture, &alpha);
+    SDL_SetTextureAlphaMod(variant->texture, alpha);
+
+    variant->factor = factor;
+    variant->used = atlas->uses;
+    if (GA_ScaleInto(atlas, variant, &whole) != 0) {
+        SDL_DestroyTexture(variant->texture);
+        variant->texture = NULL;
+        variant->factor = 0;
+        return NULL;
+    }
+
+    return variant->texture;
+}
+
+/********************************************//**
+ * @brief
+ * Copies a sheet rect into the atlas, texture and CPU copy both
+ * @param atlas struct Atlas*
+ * @param from const SDL_Rect* in the sheet, already bounds checked
+ * @param to const SDL_Rect* in the atlas, same size
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GA_CopyFromSheet(struct Atlas *atlas, const SDL_Rect *from, const SDL_Rect *to) {
+    const Uint8 *source = (const Uint8 *)atlas->sheet->pixels + from->y * atlas->sheet->pitch + from->x * 4;
+
+    if (atlas->texture != NULL && SDL_UpdateTexture(atlas->texture, to, source, atlas->sheet->pitch) != 0) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+
+    for (int row = 0; row < to->h; row++)
+        memcpy(atlas->pixels + ((size_t)(to->y + row) * atlas->w + to->x) * 4,
+               source + row * atlas->sheet->pitch, (size_t)to->w * 4);
+    if (atlas->raster.pixels != NULL)
+        GA_ConvertRect(atlas, to);
+
+    for (int i = 0; i < GA_MAX_VARIANTS; i++)
+        if (atlas->variants[i].factor > 0 && GA_ScaleInto(atlas, &atlas->variants[i], to) != 0)
+            return -1;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Whether a sheet rect still matches what the atlas holds for it
+ * @param atlas const struct Atlas*
+ * @param from const SDL_Rect* in the sheet, already bounds checked
+ * @param to const SDL_Rect* in the atlas, same size
+ * @return int
+ * 1 if the pixels are the same, 0 if not
+ ***********************************************/
+int GA_SameAsSheet(const struct Atlas *atlas, const SDL_Rect *from, const SDL_Rect *to) {
+    const Uint8 *source = (const Uint8 *)atlas->sheet->pixels + from->y * atlas->sheet->pitch + from->x * 4;
+
+    for (int row = 0; row < to->h; row++)
+        if (memcmp(atlas->pixels + ((size_t)(to->y + row) * atlas->w + to->x) * 4,
+                   source + row * atlas->sheet->pitch, (size_t)to->w * 4) != 0)
+            return 0;
+
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * Re-reads the sheet from disk and re-uploads only the rects whose pixels changed, each with its
+ * own SDL_UpdateTexture. Rects are where they were, only what's in them moves.
+ * @param atlas struct Atlas*
+ * @param changed SDL_Rect* out, atlas rects that were re-uploaded
+ * @param max_changed int room in changed
+ * @return int
+ * rects re-uploaded (may be more than max_changed, only the first max_changed are written),
+ * -1 if the sheet couldn't be read
+ ***********************************************/
+int GA_ReloadSheet(struct Atlas *atlas, SDL_Rect *changed, int max_changed) {
+    int total_changed = 0;
+
+    GA_ReleaseSheet(atlas);
+    if (GA_LoadSheet(atlas) != 0)
+        return -1;
+
+    for (int i = 0; i < GA_ATLAS_TOTAL_RECTS + atlas->total_extra; i++) {
+        SDL_Rect from, to;
+
+        if (i < GA_ATLAS_TOTAL_RECTS) {
+            const struct AtlasRect *packed = &GA_ATLAS_RECTS[i];
+            SDL_Rect sheet_rect = { packed->sheet_x, packed->sheet_y, packed->w, packed->h };
+            from = sheet_rect;
+            to = GA_Rect(i);
+        } else {
+            from = atlas->extra_sheet[i - GA_ATLAS_TOTAL_RECTS];
+            to = atlas->extra[i - GA_ATLAS_TOTAL_RECTS];
+        }
+
+        // The sheet shrank under us, keep what we had
+        if (from.x + from.w > atlas->sheet->w || from.y + from.h > atlas->sheet->h)
+            continue;
+        if (GA_SameAsSheet(atlas, &from, &to))
+            continue;
+
+        if (GA_CopyFromSheet(atlas, &from, &to) != 0)
+            break;
+        if (total_changed < max_changed)
+            changed[total_changed] = to;
+        total_changed++;
+    }
+
+    GA_ReleaseSheet(atlas);
+    return total_changed;
+}
+
+/********************************************//**
+ * @brief
+ * Atlas rect for a sprites.cfg grid cell. Cells that weren't packed get copied in from the sheet.
+ * @param atlas struct Atlas*
+ * @param col int sheet grid column
+ * @param row int sheet grid row
+ * @param out SDL_Rect*
+ * @return int
+ * 0 on success, -1 if the cell can't be had
+ ***********************************************/
+int GA_ResolveCell(struct Atlas *atlas, int col, int row, SDL_Rect *out) {
+    SDL_Rect from = {
+            col * SPRITE_SHEET_GRID_SIZE, row * SPRITE_SHEET_GRID_SIZE,
+            GA_CELL_SIZE, GA_CELL_SIZE
+    };
+    int per_row = atlas->w / (GA_CELL_SIZE + 1);
+    int packed = GA_FindSheetRect(from.x, from.y, from.w, from.h);
+    SDL_Rect *to;
+
+    if (packed != -1) {
+        *out = GA_Rect(packed);
+        return 0;
+    }
+
+    for (int i = 0; i < atlas->total_extra; i++)
+        if (atlas->extra_sheet[i].x == from.x && atlas->extra_sheet[i].y == from.y) {
+            *out = atlas->extra[i];
+            return 0;
+        }
+
+    if (atlas->total_extra == GA_MAX_EXTRA_CELLS || atlas->total_extra == per_row * GA_EXTRA_ROWS) {
+        DEBUG_ERR("sprites.cfg has too many cells the atlas wasn't built with, rebuild to repack");
+        return -1;
+    }
+
+    if (GA_LoadSheet(atlas) != 0)
+        return -1;
+
+    if (from.x < 0 || from.y < 0 || from.x + from.w > atlas->sheet->w || from.y + from.h > atlas->sheet->h) {
+        DEBUG_ERR("sprites.cfg points outside the sprite sheet");
+        return -1;
+    }
+
+    to = &atlas->extra[atlas->total_extra];
+    to->x = (atlas->total_extra % per_row) * (GA_CELL_SIZE + 1);
+    to->y = GA_ATLAS_HEIGHT + 1 + (atlas->total_extra / per_row) * (GA_CELL_SIZE + 1);
+    to->w = GA_CELL_SIZE;
+    to->h = GA_CELL_SIZE;
+
+    if (GA_CopyFromSheet(atlas, &from, to) != 0)
+        return -1;
+
+    atlas->extra_sheet[atlas->total_extra] = from;
+    atlas->total_extra++;
+    *out = *to;
+    return 0;
+}
+
+void GA_DestroyAtlas(struct Atlas *atlas) {
+    GA_ReleaseSheet(atlas);
+    for (int i = 0; i < GA_MAX_VARIANTS; i++)
+        if (atlas->variants[i].texture != NULL)
+            SDL_DestroyTexture(atlas->variants[i].texture);
+    memset(atlas->variants, 0, sizeof(atlas->variants));
+    free(atlas->pixels);
+    atlas->pixels = NULL;
+    GX_DestroyRaster(&atlas->raster);
+    if (atlas->texture != NULL)
+        SDL_DestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+}
+
+#endif //ZELDATRACKER_GAMEATLAS_H
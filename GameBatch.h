@@ -0,0 +1,185 @@
+#ifndef ZELDATRACKER_GAMEBATCH_H
+#define ZELDATRACKER_GAMEBATCH_H
+
+/*
+ * Collects textured quads from a single texture and hands them to SDL_RenderGeometry in one go.
+ * Per sprite alpha (SPRITE_MODA_*) rides along as vertex color, so there is no texture state to
+ * flip between quads and the whole lot is one draw call.
+ */
+struct SpriteBatch {
+    SDL_Texture *texture;
+    float inv_w;        // 1 / texture width, for normalizing sheet coords
+    float inv_h;        // 1 / texture height
+    SDL_Vertex *vertices;
+    int *indices;
+    int total_quads;
+    int capacity;       // in quads
+};
+
+
+/********************************************//**
+ * @brief
+ * Grows the vertex/index storage, existing quads are kept
+ * @param batch struct SpriteBatch*
+ * @param capacity int in quads
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int GB_Reserve(struct SpriteBatch *batch, int capacity) {
+    SDL_Vertex *vertices;
+    int *indices;
+
+    if (capacity <= batch->capacity)
+        return 0;
+
+    vertices = realloc(batch->vertices, sizeof(SDL_Vertex) * 4 * capacity);
+    if (vertices == NULL)
+        return -1;
+    batch->vertices = vertices;
+
+    indices = realloc(batch->indices, sizeof(int) * 6 * capacity);
+    if (indices == NULL)
+        return -1;
+    batch->indices = indices;
+
+    // Index pattern never changes, fill it in once
+    for (int i = batch->capacity; i < capacity; i++) {
+        batch->indices[i * 6 + 0] = i * 4 + 0;
+        batch->indices[i * 6 + 1] = i * 4 + 1;
+        batch->indices[i * 6 + 2] = i * 4 + 2;
+        batch->indices[i * 6 + 3] = i * 4 + 2;
+        batch->indices[i * 6 + 4] = i * 4 + 3;
+        batch->indices[i * 6 + 5] = i * 4 + 0;
+    }
+
+    batch->capacity = capacity;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Points the batch at another texture, flush anything queued for the old one first
+ * @param batch struct SpriteBatch*
+ * @param texture SDL_Texture*
+ * @return int
+ * 0 on success, -1 on failure (the old texture is kept)
+ ***********************************************/
+int GB_SetTexture(struct SpriteBatch *batch, SDL_Texture *texture) {
+    int w = 1;
+    int h = 1;
+
+    if (SDL_QueryTexture(texture, NULL, NULL, &w, &h) != 0) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+
+    batch->texture = texture;
+    batch->inv_w = 1.0f / (float)w;
+    batch->inv_h = 1.0f / (float)h;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Sets up an empty batch drawing from texture
+ * @param batch struct SpriteBatch*
+ * @param texture SDL_Texture*
+ * @param capacity int initial capacity in quads
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GB_InitBatch(struct SpriteBatch *batch, SDL_Texture *texture, int capacity) {
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->total_quads = 0;
+    batch->capacity = 0;
+
+    if (GB_SetTexture(batch, texture) != 0)
+        return -1;
+
+    return GB_Reserve(batch, capacity);
+}
+
+/********************************************//**
+ * @brief
+ * Queues a copy of frm (texture pixels) to to (target pixels) at the given alpha
+ * @param batch struct SpriteBatch*
+ * @param frm SDL_Rect*
+ * @param to SDL_Rect*
+ * @param alpha Uint8 one of SPRITE_MODA_*
+ * @return void
+ ***********************************************/
+void GB_Push(struct SpriteBatch *batch, const SDL_Rect *frm, const SDL_Rect *to, Uint8 alpha) {
+    SDL_Vertex *v;
+    SDL_Color color = { 255, 255, 255, alpha };
+    float u0 = frm->x * batch->inv_w;
+    float v0 = frm->y * batch->inv_h;
+    float u1 = (frm->x + frm->w) * batch->inv_w;
+    float v1 = (frm->y + frm->h) * batch->inv_h;
+
+    if (batch->total_quads == batch->capacity)
+        if (GB_Reserve(batch, batch->capacity * 2 + 16) != 0)
+            return;
+
+    v = &batch->vertices[batch->total_quads * 4];
+    v[0].position.x = (float)to->x;
+    v[0].position.y = (float)to->y;
+    v[0].tex_coord.x = u0;
+    v[0].tex_coord.y = v0;
+
+    v[1].position.x = (float)(to->x + to->w);
+    v[1].position.y = (float)to->y;
+    v[1].tex_coord.x = u1;
+    v[1].tex_coord.y = v0;
+
+    v[2].position.x = (float)(to->x + to->w);
+    v[2].position.y = (float)(to->y + to->h);
+    v[2].tex_coord.x = u1;
+    v[2].tex_coord.y = v1;
+
+    v[3].position.x = (float)to->x;
+    v[3].position.y = (float)(to->y + to->h);
+    v[3].tex_coord.x = u0;
+    v[3].tex_coord.y = v1;
+
+    v[0].color = color;
+    v[1].color = color;
+    v[2].color = color;
+    v[3].color = color;
+
+    batch->total_quads++;
+}
+
+/********************************************//**
+ * @brief
+ * Submits everything queued as one SDL_RenderGeometry call and empties the batch
+ * @param batch struct SpriteBatch*
+ * @param renderer SDL_Renderer*
+ * @return int
+ * number of quads drawn
+ ***********************************************/
+int GB_Flush(struct SpriteBatch *batch, SDL_Renderer *renderer) {
+    int drawn = batch->total_quads;
+
+    if (drawn == 0)
+        return 0;
+
+    if (SDL_RenderGeometry(renderer, batch->texture,
+                           batch->vertices, drawn * 4,
+                           batch->indices, drawn * 6) != 0)
+        DEBUG_ERR(SDL_GetError());
+
+    batch->total_quads = 0;
+    return drawn;
+}
+
+void GB_DestroyBatch(struct SpriteBatch *batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->total_quads = 0;
+    batch->capacity = 0;
+}
+
+#endif //ZELDATRACKER_GAMEBATCH_H
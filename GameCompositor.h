@@ -0,0 +1,384 @@
+#ifndef ZELDATRACKER_GAMECOMPOSITOR_H
+#define ZELDATRACKER_GAMECOMPOSITOR_H
+
+const int GC_SLOT_UNDRAWN = -1;
+
+/*
+ * Three layers, back to front:
+ *   background - the scene surface plus anything that never changes (dungeon numbers), drawn once
+ *   sprites    - triforces/items and their dungeon tags, only cells whose state changed get redrawn
+ *   dynamic    - link and the cursor, drawn straight to the backbuffer every frame (not owned here)
+ *
+ * The sprite layer is kept premultiplied (it starts out transparent black and everything is BLENDed
+ * into it) so it has to go on screen with a premultiplied "over" instead of SDL_BLENDMODE_BLEND.
+ *
+ * Without a renderer (software rendering) the layers are CPU rasters instead of target textures,
+ * the damage bookkeeping is the same and the caller draws into them with GX_Blit.
+ */
+struct Compositor {
+    int w;
+    int h;
+    SDL_Texture *background;
+    SDL_Texture *sprites;
+    struct Raster background_pixels;    // software rendering only, in place of the textures
+    struct Raster sprite_pixels;
+    int software;
+    SDL_BlendMode premultiplied;
+    int background_dirty;
+    int total_slots;
+    int *drawn;              // per slot key last rendered into the sprite layer
+    SDL_Rect *damaged;       // cells to punch out of the sprite layer before redrawing them
+    int total_damaged;
+    int damage_capacity;     // a cell per slot, twice over so a moved slot can damage where it was
+};
+
+
+/********************************************//**
+ * @brief
+ * Builds a damage key for a sprite slot, two slots with the same key look identical on screen
+ * @param state int sprite state bits
+ * @param tag int dungeon tag, -1 if untagged
+ * @return int
+ ***********************************************/
+int GC_SlotKey(int state, int tag) {
+    return (state & (SPRITE_STATE_ON | SPRITE_STATE_HOVER | SPRITE_STATE_DISABLED)) | ((tag + 1) << 12);
+}
+
+/********************************************//**
+ * @brief
+ * Forgets everything that was drawn, the next frame redraws all layers. Needed when the
+ * renderer throws away target contents (SDL_RENDER_TARGETS_RESET).
+ * @param compositor struct Compositor*
+ * @return void
+ ***********************************************/
+void GC_Invalidate(struct Compositor *compositor) {
+    compositor->background_dirty = 1;
+    for (int i = 0; i < compositor->total_slots; i++)
+        compositor->drawn[i] = GC_SLOT_UNDRAWN;
+}
+
+/********************************************//**
+ * @brief
+ * Empties the sprite layer (fully transparent) and forgets what was drawn, for when everything
+ * is about to land somewhere else
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_ClearSprites(struct Compositor *compositor, SDL_Renderer *renderer) {
+    compositor->total_damaged = 0;
+    GC_Invalidate(compositor);
+    if (compositor->software) {
+        GX_FillRect(&compositor->sprite_pixels, NULL, 0);
+        return;
+    }
+
+    SDL_SetRenderTarget(renderer, compositor->sprites);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+}
+
+/********************************************//**
+ * @brief
+ * (Re)creates the layer textures at a new size, everything is redrawn
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @param w int
+ * @param h int
+ * @return int
+ * 0 on success, -1 on failure (the old layers are kept)
+ ***********************************************/
+int GC_ResizeLayers(struct Compositor *compositor, SDL_Renderer *renderer, int w, int h) {
+    SDL_Texture *background, *sprites;
+
+    if (compositor->software) {
+        struct Raster background_pixels, sprite_pixels;
+
+        if (GX_InitRaster(&background_pixels, w, h) != 0)
+            return -1;
+        if (GX_InitRaster(&sprite_pixels, w, h) != 0) {
+            GX_DestroyRaster(&background_pixels);
+            return -1;
+        }
+
+        GX_DestroyRaster(&compositor->background_pixels);
+        GX_DestroyRaster(&compositor->sprite_pixels);
+        compositor->background_pixels = background_pixels;
+        compositor->sprite_pixels = sprite_pixels;
+        compositor->w = w;
+        compositor->h = h;
+        GC_ClearSprites(compositor, renderer);
+        return 0;
+    }
+
+    background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    sprites = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (background == NULL || sprites == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        if (background != NULL)
+            SDL_DestroyTexture(background);
+        if (sprites != NULL)
+            SDL_DestroyTexture(sprites);
+        return -1;
+    }
+
+    if (compositor->background != NULL)
+        SDL_DestroyTexture(compositor->background);
+    if (compositor->sprites != NULL)
+        SDL_DestroyTexture(compositor->sprites);
+    compositor->background = background;
+    compositor->sprites = sprites;
+    compositor->w = w;
+    compositor->h = h;
+
+    SDL_SetTextureBlendMode(compositor->background, SDL_BLENDMODE_NONE);
+    SDL_SetTextureBlendMode(compositor->sprites, compositor->premultiplied);
+
+    GC_ClearSprites(compositor, renderer);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Creates the cached layer textures
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer* NULL for software rendering, the layers are rasters
+ * @param w int
+ * @param h int
+ * @param total_slots int number of independently damaged sprite cells
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GC_InitCompositor(struct Compositor *compositor, SDL_Renderer *renderer,
+                      int w, int h, int total_slots) {
+    compositor->background = NULL;
+    compositor->sprites = NULL;
+    memset(&compositor->background_pixels, 0, sizeof(compositor->background_pixels));
+    memset(&compositor->sprite_pixels, 0, sizeof(compositor->sprite_pixels));
+    compositor->software = (renderer == NULL);
+    compositor->total_slots = total_slots;
+    compositor->premultiplied = SDL_ComposeCustomBlendMode(
+            SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+            SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+
+    compositor->drawn = malloc(sizeof(int) * total_slots);
+    compositor->damaged = malloc(sizeof(SDL_Rect) * 2 * total_slots);
+    compositor->total_damaged = 0;
+    compositor->damage_capacity = 2 * total_slots;
+    if (compositor->drawn == NULL || compositor->damaged == NULL) {
+        DEBUG_ERR("Unable to allocate the compositor");
+        return -1;
+    }
+
+    return GC_ResizeLayers(compositor, renderer, w, h);
+}
+
+/********************************************//**
+ * @brief
+ * Forgets what one slot looked like, the next GC_CollectChanged reports it whatever its state
+ * @param compositor struct Compositor*
+ * @param slot int
+ * @return void
+ ***********************************************/
+void GC_ForgetSlot(struct Compositor *compositor, int slot) {
+    compositor->drawn[slot] = GC_SLOT_UNDRAWN;
+}
+
+/********************************************//**
+ * @brief
+ * Changes the number of slots. Slot numbers don't mean what they did, so the sprite layer is
+ * cleared and every layer redrawn.
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @param total_slots int
+ * @return int
+ * 0 on success, -1 if we're out of memory (the old slots are kept)
+ ***********************************************/
+int GC_ResizeSlots(struct Compositor *compositor, SDL_Renderer *renderer, int total_slots) {
+    int *drawn = malloc(sizeof(int) * total_slots);
+    SDL_Rect *damaged = malloc(sizeof(SDL_Rect) * 2 * total_slots);
+
+    if (drawn == NULL || damaged == NULL) {
+        free(drawn);
+        free(damaged);
+        return -1;
+    }
+
+    free(compositor->drawn);
+    free(compositor->damaged);
+    compositor->drawn = drawn;
+    compositor->damaged = damaged;
+    compositor->total_slots = total_slots;
+    compositor->total_damaged = 0;
+    compositor->damage_capacity = 2 * total_slots;
+
+    GC_ClearSprites(compositor, renderer);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Records the key for a slot
+ * @param compositor struct Compositor*
+ * @param slot int
+ * @param key int from GC_SlotKey
+ * @return int
+ * 1 if the slot looks different from what's in the sprite layer and needs redrawing, 0 if not
+ ***********************************************/
+int GC_SlotChanged(struct Compositor *compositor, int slot, int key) {
+    if (compositor->drawn[slot] == key)
+        return 0;
+
+    compositor->drawn[slot] = key;
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * GC_SlotChanged over a whole run of slots at once, slot i being state[i]/tag[i]. Disabled
+ * slots are tracked but never reported, there's nothing of theirs to draw.
+ * @param compositor struct Compositor*
+ * @param state const Uint8* per slot state bits
+ * @param tag const Sint8* per slot dungeon tag
+ * @param total int slots, no more than total_slots
+ * @param changed int* out, the slots that need redrawing
+ * @return int
+ * number of slots written to changed
+ ***********************************************/
+int GC_CollectChanged(struct Compositor *compositor, const Uint8 *state, const Sint8 *tag,
+                      int total, int *changed) {
+    int *drawn = compositor->drawn;
+    int total_changed = 0;
+
+    // No branches, the index is always written and only kept if the key moved
+    for (int i = 0; i < total; i++) {
+        int key = GC_SlotKey(state[i], tag[i]);
+
+        changed[total_changed] = i;
+        total_changed += (key != drawn[i]) & ((state[i] & SPRITE_STATE_DISABLED) == 0);
+        drawn[i] = key;
+    }
+
+    return total_changed;
+}
+
+/********************************************//**
+ * @brief
+ * Points the renderer at the background layer and clears it, draw whatever is static then
+ * call GC_EndLayer
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_BeginBackground(struct Compositor *compositor, SDL_Renderer *renderer) {
+    compositor->background_dirty = 0;
+    if (compositor->software) {
+        GX_FillRect(&compositor->background_pixels, NULL, 0xFF000000);
+        return;
+    }
+
+    SDL_SetRenderTarget(renderer, compositor->background);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+}
+
+/********************************************//**
+ * @brief
+ * Points the renderer at the sprite layer, nothing is cleared - GC_Damage the cells that
+ * changed and GC_ClearDamaged before drawing into them
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_BeginSprites(struct Compositor *compositor, SDL_Renderer *renderer) {
+    SDL_SetRenderTarget(renderer, compositor->sprites);
+}
+
+/********************************************//**
+ * @brief
+ * Marks a cell of the sprite layer as damaged, it'll be cleared by GC_ClearDamaged
+ * @param compositor struct Compositor*
+ * @param cell SDL_Rect*
+ * @return void
+ ***********************************************/
+void GC_Damage(struct Compositor *compositor, const SDL_Rect *cell) {
+    if (compositor->total_damaged < compositor->damage_capacity)
+        compositor->damaged[compositor->total_damaged++] = *cell;
+}
+
+/********************************************//**
+ * @brief
+ * Punches fully transparent holes into the current layer for every damaged cell, all in
+ * one fill call
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_ClearDamaged(struct Compositor *compositor, SDL_Renderer *renderer) {
+    if (compositor->total_damaged == 0)
+        return;
+
+    if (compositor->software) {
+        for (int i = 0; i < compositor->total_damaged; i++)
+            GX_FillRect(&compositor->sprite_pixels, &compositor->damaged[i], 0);
+        compositor->total_damaged = 0;
+        return;
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderFillRects(renderer, compositor->damaged, compositor->total_damaged);
+    compositor->total_damaged = 0;
+}
+
+/********************************************//**
+ * @brief
+ * Points the renderer back at the window
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_EndLayer(SDL_Renderer *renderer) {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+}
+
+/********************************************//**
+ * @brief
+ * Copies the background to the backbuffer, replaces SDL_RenderClear
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_DrawBackground(struct Compositor *compositor, SDL_Renderer *renderer) {
+    SDL_RenderCopy(renderer, compositor->background, NULL, NULL);
+}
+
+/********************************************//**
+ * @brief
+ * Composites the sprite layer over whatever is in the backbuffer
+ * @param compositor struct Compositor*
+ * @param renderer SDL_Renderer*
+ * @return void
+ ***********************************************/
+void GC_DrawSprites(struct Compositor *compositor, SDL_Renderer *renderer) {
+    SDL_RenderCopy(renderer, compositor->sprites, NULL, NULL);
+}
+
+void GC_DestroyCompositor(struct Compositor *compositor) {
+    if (compositor->background != NULL)
+        SDL_DestroyTexture(compositor->background);
+    if (compositor->sprites != NULL)
+        SDL_DestroyTexture(compositor->sprites);
+    GX_DestroyRaster(&compositor->background_pixels);
+    GX_DestroyRaster(&compositor->sprite_pixels);
+    free(compositor->drawn);
+    free(compositor->damaged);
+    compositor->background = NULL;
+    compositor->sprites = NULL;
+    compositor->drawn = NULL;
+    compositor->damaged = NULL;
+}
+
+#endif //ZELDATRACKER_GAMECOMPOSITOR_H
@@ -0,0 +1,624 @@
+#ifndef ZELDATRACKER_GAMECONFIG_H
+#define ZELDATRACKER_GAMECONFIG_H
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * sprites.cfg, one item per line:
+ *
+ *     <enabled>,<sheet column>,<sheet row>#<name>
+ *
+ * Blank lines and lines starting with '#' are skipped, whitespace around the numbers is fine.
+ * The parser streams the file through a fixed stack buffer and never allocates. Whatever it
+ * produces is written to "<config>.bin" as a flat array of struct SpriteEntry, and as long as
+ * that still matches the config (size and content hash) later startups just map it.
+ */
+
+#define GCF_NAME_LENGTH 24
+
+const Uint32 GCF_CACHE_VERSION = 2;
+const char GCF_CACHE_MAGIC[4] = { 'Z', 'T', 'S', 'C' };
+const char *GCF_CACHE_SUFFIX = ".bin";
+const Uint64 GCF_HASH_SEED = 14695981039346656037ULL;   // FNV-1a 64
+const Uint64 GCF_HASH_PRIME = 1099511628211ULL;
+
+struct SpriteEntry {
+    Sint32 enabled;
+    Sint32 col;                     // column in the sprite sheet grid
+    Sint32 row;                     // row in the sprite sheet grid
+    char name[GCF_NAME_LENGTH];     // the #comment, truncated
+};
+
+struct SpriteCacheHeader {
+    char magic[4];
+    Uint32 version;
+    Uint32 entry_size;
+    Uint32 total_entries;
+    Sint64 source_size;
+    Uint64 source_hash;             // FNV-1a of the text config
+};
+
+struct ConfigError {
+    int line;
+    int column;
+    char message[96];
+};
+
+typedef int (*GCF_EntryCallback)(void *ctx, const struct SpriteEntry *entry, int line);
+
+struct ConfigParser {
+    GCF_EntryCallback on_entry;
+    void *ctx;
+    struct ConfigError *error;
+    Uint64 hash;
+    int line;
+    int column;
+    int field;                      // 0 enabled, 1 col, 2 row, 3 name, 4 comment line
+    int digits;                     // digits seen in the current number
+    int number_done;                // whitespace after the digits, only a separator may follow
+    int blank;                      // nothing but whitespace on this line so far
+    int name_length;
+    Sint64 value;
+    Sint32 numbers[3];
+    struct SpriteEntry entry;
+};
+
+struct SpriteConfig {
+    const struct SpriteEntry *entries;
+    int total_entries;
+    int from_cache;                 // 1 if entries point into the mapped cache
+    struct SpriteEntry *owned;      // parsed entries when we couldn't use the cache
+    int capacity;
+    void *mapping;
+    size_t mapping_size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE map;
+#endif
+    struct ConfigError error;
+};
+
+
+/********************************************//**
+ * @brief
+ * Records a parse error, first one wins
+ * @param parser struct ConfigParser*
+ * @param message const char*
+ * @return int
+ * always -1 so callers can return it
+ ***********************************************/
+int GCF_Fail(struct ConfigParser *parser, const char *message) {
+    parser->error->line = parser->line;
+    parser->error->column = parser->column;
+    snprintf(parser->error->message, sizeof(parser->error->message), "%s", message);
+    return -1;
+}
+
+void GCF_ResetLine(struct ConfigParser *parser) {
+    parser->column = 0;
+    parser->field = 0;
+    parser->digits = 0;
+    parser->number_done = 0;
+    parser->blank = 1;
+    parser->name_length = 0;
+    parser->value = 0;
+    memset(&parser->entry, 0, sizeof(parser->entry));
+}
+
+void GCF_InitParser(struct ConfigParser *parser, GCF_EntryCallback on_entry, void *ctx,
+                    struct ConfigError *error) {
+    parser->on_entry = on_entry;
+    parser->ctx = ctx;
+    parser->error = error;
+    parser->hash = GCF_HASH_SEED;
+    parser->line = 1;
+    GCF_ResetLine(parser);
+    error->line = 0;
+    error->column = 0;
+    error->message[0] = '\0';
+}
+
+/********************************************//**
+ * @brief
+ * Finishes the current number field
+ * @param parser struct ConfigParser*
+ * @return int
+ * 0 on success, -1 on error
+ ***********************************************/
+int GCF_EndNumber(struct ConfigParser *parser) {
+    if (parser->digits == 0)
+        return GCF_Fail(parser, "expected a number");
+
+    parser->numbers[parser->field] = (Sint32)parser->value;
+    parser->field++;
+    parser->digits = 0;
+    parser->number_done = 0;
+    parser->value = 0;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Finishes the current line and hands the entry to the callback
+ * @param parser struct ConfigParser*
+ * @return int
+ * 0 on success, -1 on error
+ ***********************************************/
+int GCF_EndLine(struct ConfigParser *parser) {
+    int result = 0;
+
+    if (parser->blank)
+        goto next_line;
+
+    if (parser->field < 3) {
+        if (parser->field != 2 || GCF_EndNumber(parser) != 0)
+            return GCF_Fail(parser, "expected <enabled>,<column>,<row>");
+    }
+
+    // Trailing whitespace isn't part of the name
+    while (parser->name_length > 0 && (parser->entry.name[parser->name_length - 1] == ' '
+                                       || parser->entry.name[parser->name_length - 1] == '\t'))
+        parser->entry.name[--parser->name_length] = '\0';
+
+    parser->entry.enabled = (parser->numbers[0] != 0) ? 1 : 0;
+    parser->entry.col = parser->numbers[1];
+    parser->entry.row = parser->numbers[2];
+    result = parser->on_entry(parser->ctx, &parser->entry, parser->line);
+    if (result != 0)
+        return GCF_Fail(parser, "out of memory");
+
+    next_line:
+    parser->line++;
+    GCF_ResetLine(parser);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Feeds a chunk of the file through the parser, chunks can split lines anywhere
+ * @param parser struct ConfigParser*
+ * @param data const char*
+ * @param length size_t
+ * @return int
+ * 0 on success, -1 on error (see parser->error)
+ ***********************************************/
+int GCF_Feed(struct ConfigParser *parser, const char *data, size_t length) {
+    char c;
+    char message[64];
+
+    for (size_t i = 0; i < length; i++) {
+        c = data[i];
+        parser->hash = (parser->hash ^ (Uint8)c) * GCF_HASH_PRIME;
+        parser->column++;
+
+        if (c == '\n') {
+            if (GCF_EndLine(parser) != 0)
+                return -1;
+            continue;
+        }
+        if (c == '\r')
+            continue;
+
+        if (parser->field == 4)
+            continue;
+
+        if (parser->field == 3) {
+            if (parser->name_length < GCF_NAME_LENGTH - 1 && (parser->name_length > 0 || c != ' '))
+                parser->entry.name[parser->name_length++] = c;
+            continue;
+        }
+
+        if (c == ' ' || c == '\t') {
+            if (parser->digits > 0)
+                parser->number_done = 1;
+            continue;
+        }
+
+        if (parser->blank && parser->field == 0 && c == '#') {
+            parser->field = 4;
+            continue;
+        }
+
+        parser->blank = 0;
+        if (c >= '0' && c <= '9') {
+            if (parser->number_done)
+                return GCF_Fail(parser, "expected ',' or '#' between numbers");
+
+            parser->value = parser->value * 10 + (c - '0');
+            if (parser->value > 0x7FFFFFFF)
+                return GCF_Fail(parser, "number too large");
+            parser->digits++;
+        } else if (c == ',') {
+            if (parser->field == 2)
+                return GCF_Fail(parser, "too many numbers, expected '#' after the row");
+            if (GCF_EndNumber(parser) != 0)
+                return -1;
+        } else if (c == '#') {
+            if (parser->field != 2)
+                return GCF_Fail(parser, "expected <enabled>,<column>,<row> before '#'");
+            if (GCF_EndNumber(parser) != 0)
+                return -1;
+        } else {
+            snprintf(message, sizeof(message), "unexpected character '%c'", c);
+            return GCF_Fail(parser, message);
+        }
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Flushes a last line that has no trailing newline
+ * @param parser struct ConfigParser*
+ * @return int
+ * 0 on success, -1 on error
+ ***********************************************/
+int GCF_Finish(struct ConfigParser *parser) {
+    if (parser->blank && (parser->field == 0 || parser->field == 4))
+        return 0;
+
+    return GCF_EndLine(parser);
+}
+
+/********************************************//**
+ * @brief
+ * Streams a whole file through the parser
+ * @param path const char*
+ * @param on_entry GCF_EntryCallback called once per entry, in file order
+ * @param ctx void*
+ * @param error struct ConfigError*
+ * @param hash Uint64* receives the FNV-1a hash of the file, may be NULL
+ * @return int
+ * 0 on success, -1 on error
+ ***********************************************/
+int GCF_ParseFile(const char *path, GCF_EntryCallback on_entry, void *ctx,
+                  struct ConfigError *error, Uint64 *hash) {
+    struct ConfigParser parser;
+    char chunk[4096];
+    size_t read;
+    FILE *file = fopen(path, "rb");
+
+    GCF_InitParser(&parser, on_entry, ctx, error);
+    if (!file) {
+        snprintf(error->message, sizeof(error->message), "unable to open the file");
+        return -1;
+    }
+
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        if (GCF_Feed(&parser, chunk, read) != 0) {
+            fclose(file);
+            return -1;
+        }
+
+    fclose(file);
+    if (GCF_Finish(&parser) != 0)
+        return -1;
+
+    if (hash)
+        *hash = parser.hash;
+    return 0;
+}
+
+Uint64 GCF_HashName(const char *name) {
+    Uint64 h = GCF_HASH_SEED;
+
+    for (; *name != '\0'; name++)
+        h = (h ^ (Uint8)*name) * GCF_HASH_PRIME;
+    return h;
+}
+
+/********************************************//**
+ * @brief
+ * FNV-1a of a file without parsing it, for checking a cache still matches its config
+ * @param path const char*
+ * @param hash Uint64*
+ * @return int
+ * 0 on success, -1 if the file can't be read
+ ***********************************************/
+int GCF_HashFile(const char *path, Uint64 *hash) {
+    char chunk[4096];
+    size_t read;
+    Uint64 h = GCF_HASH_SEED;
+    FILE *file = fopen(path, "rb");
+
+    if (!file)
+        return -1;
+
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        for (size_t i = 0; i < read; i++)
+            h = (h ^ (Uint8)chunk[i]) * GCF_HASH_PRIME;
+
+    fclose(file);
+    *hash = h;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * mtime (ns) and size of a file
+ * @param path const char*
+ * @param mtime Sint64*
+ * @param size Sint64*
+ * @return int
+ * 0 on success, -1 if it doesn't exist
+ ***********************************************/
+int GCF_StatFile(const char *path, Sint64 *mtime, Sint64 *size) {
+#ifdef _WIN32
+    struct __stat64 info;
+    if (_stat64(path, &info) != 0)
+        return -1;
+    *mtime = (Sint64)info.st_mtime * 1000000000LL;
+#else
+    struct stat info;
+    if (stat(path, &info) != 0)
+        return -1;
+    *mtime = (Sint64)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+    *size = (Sint64)info.st_size;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Maps a whole file read-only
+ * @param config struct SpriteConfig* receives the mapping
+ * @param path const char*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GCF_MapFile(struct SpriteConfig *config, const char *path) {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+
+    config->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, NULL);
+    if (config->file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    if (!GetFileSizeEx(config->file, &size) || size.QuadPart == 0) {
+        CloseHandle(config->file);
+        return -1;
+    }
+
+    config->map = CreateFileMappingA(config->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (config->map == NULL) {
+        CloseHandle(config->file);
+        return -1;
+    }
+
+    config->mapping = MapViewOfFile(config->map, FILE_MAP_READ, 0, 0, 0);
+    if (config->mapping == NULL) {
+        CloseHandle(config->map);
+        CloseHandle(config->file);
+        return -1;
+    }
+    config->mapping_size = (size_t)size.QuadPart;
+#else
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return -1;
+
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+
+    config->mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (config->mapping == MAP_FAILED) {
+        config->mapping = NULL;
+        return -1;
+    }
+    config->mapping_size = (size_t)info.st_size;
+#endif
+    return 0;
+}
+
+void GCF_UnmapFile(struct SpriteConfig *config) {
+    if (config->mapping == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(config->mapping);
+    CloseHandle(config->map);
+    CloseHandle(config->file);
+#else
+    munmap(config->mapping, config->mapping_size);
+#endif
+    config->mapping = NULL;
+    config->mapping_size = 0;
+}
+
+/********************************************//**
+ * @brief
+ * Maps "<path>.bin" and checks it still describes path: same size and content hash, and
+ * every name terminated inside its field
+ * @param config struct SpriteConfig*
+ * @param path const char* the text config
+ * @param cache_path const char*
+ * @return int
+ * 0 if config->entries now points into a valid cache, -1 if the cache is missing or stale
+ ***********************************************/
+int GCF_OpenCache(struct SpriteConfig *config, const char *path, const char *cache_path) {
+    struct SpriteCacheHeader header;
+    const struct SpriteEntry *entries;
+    Sint64 mtime, size;
+    Uint64 hash;
+
+    if (GCF_StatFile(path, &mtime, &size) != 0 || GCF_MapFile(config, cache_path) != 0)
+        return -1;
+
+    if (config->mapping_size < sizeof(header))
+        goto stale;
+
+    memcpy(&header, config->mapping, sizeof(header));
+    if (memcmp(header.magic, GCF_CACHE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != GCF_CACHE_VERSION
+        || header.entry_size != sizeof(struct SpriteEntry)
+        || header.source_size != size
+        || config->mapping_size != sizeof(header) + (size_t)header.total_entries * sizeof(struct SpriteEntry))
+        goto stale;
+
+    // An edit that keeps the size (and maybe the mtime) still changes the hash
+    if (GCF_HashFile(path, &hash) != 0 || hash != header.source_hash)
+        goto stale;
+
+    // Names are used as C strings straight out of the mapping
+    entries = (const struct SpriteEntry *)((const char *)config->mapping + sizeof(header));
+    for (Uint32 i = 0; i < header.total_entries; i++)
+        if (memchr(entries[i].name, '\0', sizeof(entries[i].name)) == NULL)
+            goto stale;
+
+    config->entries = entries;
+    config->total_entries = (int)header.total_entries;
+    config->from_cache = 1;
+    return 0;
+
+    stale:
+    GCF_UnmapFile(config);
+    return -1;
+}
+
+/********************************************//**
+ * @brief
+ * Writes the parsed entries out as the binary cache, via a temp file so a half written cache
+ * is never picked up
+ * @param config struct SpriteConfig*
+ * @param path const char* the text config
+ * @param cache_path const char*
+ * @param hash Uint64 FNV-1a of the text config
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GCF_WriteCache(const struct SpriteConfig *config, const char *path, const char *cache_path, Uint64 hash) {
+    struct SpriteCacheHeader header;
+    Sint64 mtime;
+    char temp_path[512];
+    FILE *out;
+    int ok;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GCF_CACHE_MAGIC, sizeof(header.magic));
+    header.version = GCF_CACHE_VERSION;
+    header.entry_size = sizeof(struct SpriteEntry);
+    header.total_entries = (Uint32)config->total_entries;
+    header.source_hash = hash;
+    if (GCF_StatFile(path, &mtime, &header.source_size) != 0)
+        return -1;
+
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path);
+    out = fopen(temp_path, "wb");
+    if (!out)
+        return -1;
+
+    ok = fwrite(&header, sizeof(header), 1, out) == 1
+         && (config->total_entries == 0
+             || fwrite(config->entries, sizeof(struct SpriteEntry), config->total_entries, out)
+                == (size_t)config->total_entries);
+    ok = (fclose(out) == 0) && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA(temp_path, cache_path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && rename(temp_path, cache_path) == 0;
+#endif
+    if (!ok)
+        remove(temp_path);
+
+    return ok ? 0 : -1;
+}
+
+/********************************************//**
+ * @brief
+ * GCF_ParseFile callback for GCF_LoadConfig, the only place the loader allocates
+ ***********************************************/
+int GCF_AppendEntry(void *ctx, const struct SpriteEntry *entry, int line) {
+    struct SpriteConfig *config = ctx;
+    struct SpriteEntry *grown;
+
+    if (config->total_entries == config->capacity) {
+        int capacity = (config->capacity == 0) ? 32 : config->capacity * 2;
+        grown = realloc(config->owned, sizeof(struct SpriteEntry) * capacity);
+        if (grown == NULL)
+            return -1;
+        config->owned = grown;
+        config->capacity = capacity;
+    }
+
+    config->owned[config->total_entries++] = *entry;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Loads a sprites config, from the binary cache if it's still good, otherwise by parsing the
+ * text and refreshing the cache
+ * @param config struct SpriteConfig*
+ * @param path const char*
+ * @return int
+ * 0 on success, -1 on failure (config->error has the line/column/message)
+ ***********************************************/
+int GCF_LoadConfig(struct SpriteConfig *config, const char *path) {
+    char cache_path[512];
+    Uint64 hash = 0;
+
+    memset(config, 0, sizeof(*config));
+    snprintf(cache_path, sizeof(cache_path), "%s%s", path, GCF_CACHE_SUFFIX);
+
+    if (GCF_OpenCache(config, path, cache_path) == 0)
+        return 0;
+
+    if (GCF_ParseFile(path, GCF_AppendEntry, config, &config->error, &hash) != 0) {
+        free(config->owned);
+        config->owned = NULL;
+        config->total_entries = 0;
+        return -1;
+    }
+
+    config->entries = config->owned;
+    if (GCF_WriteCache(config, path, cache_path, hash) != 0)
+        DEBUG_LOG("Unable to write the sprites cache, parsing again next time");
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Formats config->error as "path:line:column: message"
+ * @param config struct SpriteConfig*
+ * @param path const char*
+ * @param out char*
+ * @param out_length size_t
+ * @return void
+ ***********************************************/
+void GCF_FormatError(const struct SpriteConfig *config, const char *path, char *out, size_t out_length) {
+    if (config->error.line > 0)
+        snprintf(out, out_length, "%s:%d:%d: %s", path, config->error.line,
+                 config->error.column, config->error.message);
+    else
+        snprintf(out, out_length, "%s: %s", path, config->error.message);
+}
+
+void GCF_UnloadConfig(struct SpriteConfig *config) {
+    GCF_UnmapFile(config);
+    free(config->owned);
+    config->owned = NULL;
+    config->entries = NULL;
+    config->total_entries = 0;
+    config->capacity = 0;
+}
+
+#endif //ZELDATRACKER_GAMECONFIG_H
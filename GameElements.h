@@ -9,10 +9,15 @@ const Uint8 SPRITE_MODA_OFF = 0x55;
 const Uint8 SPRITE_MODA_HOVER = 0xAA;
 const Uint8 SPRITE_MODA_ON = 0xFF;
 const int SPRITE_SHEET_GRID_SIZE = 15;
-const int SPRITE_STATE_OFF      = 0x0000;
-const int SPRITE_STATE_ON       = 0x0001;
-const int SPRITE_STATE_HOVER    = 0x0010;
-const int SPRITE_STATE_DISABLED = 0x0100;
+
+// State bits, packed into one Uint8 per sprite
+const int SPRITE_STATE_OFF      = 0x00;
+const int SPRITE_STATE_ON       = 0x01;
+const int SPRITE_STATE_HOVER    = 0x02;
+const int SPRITE_STATE_DISABLED = 0x04;
+
+// Alpha by (state & (SPRITE_STATE_ON | SPRITE_STATE_HOVER)), ON wins over HOVER
+const Uint8 SPRITE_MODA_FOR_STATE[4] = { 0x55, 0xFF, 0xAA, 0xFF };
 
 struct Scene {
     int h;
@@ -23,21 +28,214 @@ struct Scene {
     SDL_Surface *surface;
 };
 
-struct Sprite {
-    int s_x;  // x column location in sprite sheet
-    int s_y;  // y column location in sprite sheet
-    int x;      // real world location for rendering
-    int y;      // real world location for rendering
-    int state;
+/*
+ * Every clickable sprite, one column per field. Columns are dense over [0, total) so the passes
+ * over them (hover, toggles, collecting what to draw) are straight loops over flat arrays.
+ *
+ * Handles stay valid for as long as the sprite lives, whatever else gets added or removed:
+ * the low GE_HANDLE_INDEX_BITS pick an entry in dense_of, the rest is that entry's generation.
+ * Generations are 32 bits, an entry has to be reused ~4 billion times before a stale handle
+ * could match again. Dense indices only move when something is removed (the last sprite fills
+ * the hole).
+ */
+typedef Uint64 SpriteHandle;
+
+#define GE_HANDLE_INDEX_BITS 24
+#define GE_HANDLE_INDEX_MASK ((1u << GE_HANDLE_INDEX_BITS) - 1)
+
+const SpriteHandle GE_NO_SPRITE = 0;    // generations start at 1, so this is never handed out
+const Uint32 GE_FREE_END = GE_HANDLE_INDEX_MASK;
+
+struct SpriteStore {
+    int total;
+    int capacity;
+
+    // Dense columns
+    int *x;                 // real world location for rendering
+    int *y;
+    SDL_Rect *frm;          // where to draw it from in the atlas
+    Sint16 *col;            // column in the sprite sheet grid
+    Sint16 *row;            // row in the sprite sheet grid
+    Uint8 *state;           // SPRITE_STATE_* bits
+    Sint8 *tag;             // dungeon tag, -1 for none
+    Uint32 *owner;          // handle entry pointing at each dense index
+
+    // Handle entries, a free entry's dense_of is the next free entry
+    Uint32 *dense_of;
+    Uint32 *generation;
+    int total_handles;
+    Uint32 free_handle;
 };
 
 
-void GE_InitSprite(struct Sprite *sprite, int state) {
-    sprite->s_x = 0;
-    sprite->s_y = 0;
-    sprite->x = 0;
-    sprite->y = 0;
-    sprite->state = state;
+/********************************************//**
+ * @brief
+ * Grows every column to hold capacity sprites, nothing moves
+ * @param store struct SpriteStore*
+ * @param capacity int
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int GE_ReserveStore(struct SpriteStore *store, int capacity) {
+    void *grown;
+
+    if (capacity <= store->capacity)
+        return 0;
+    if (capacity > (int)GE_HANDLE_INDEX_MASK)
+        return -1;
+
+#define GE_GROW(column) \
+    grown = realloc(store->column, sizeof(*store->column) * capacity); \
+    if (grown == NULL) \
+        return -1; \
+    store->column = grown;
+
+    GE_GROW(x)
+    GE_GROW(y)
+    GE_GROW(frm)
+    GE_GROW(col)
+    GE_GROW(row)
+    GE_GROW(state)
+    GE_GROW(tag)
+    GE_GROW(owner)
+    GE_GROW(dense_of)
+    GE_GROW(generation)
+#undef GE_GROW
+
+    store->capacity = capacity;
+    return 0;
+}
+
+int GE_InitStore(struct SpriteStore *store, int capacity) {
+    memset(store, 0, sizeof(*store));
+    store->free_handle = GE_FREE_END;
+
+    return GE_ReserveStore(store, capacity);
+}
+
+/********************************************//**
+ * @brief
+ * Appends a sprite, everything but the position and state starts zeroed/untagged
+ * @param store struct SpriteStore*
+ * @param x int
+ * @param y int
+ * @param state int
+ * @return SpriteHandle
+ * GE_NO_SPRITE if we're out of memory
+ ***********************************************/
+SpriteHandle GE_AddSprite(struct SpriteStore *store, int x, int y, int state) {
+    SDL_Rect nothing = { 0, 0, 0, 0 };
+    Uint32 entry;
+    int at = store->total;
+
+    if (at == store->capacity)
+        if (GE_ReserveStore(store, store->capacity * 2 + 16) != 0)
+            return GE_NO_SPRITE;
+
+    if (store->free_handle != GE_FREE_END) {
+        entry = store->free_handle;
+        store->free_handle = store->dense_of[entry];
+    } else {
+        entry = (Uint32)store->total_handles++;
+        store->generation[entry] = 0;
+    }
+
+    // 0 is reserved so GE_NO_SPRITE never matches
+    if (++store->generation[entry] == 0)
+        store->generation[entry] = 1;
+    store->dense_of[entry] = (Uint32)at;
+
+    store->x[at] = x;
+    store->y[at] = y;
+    store->frm[at] = nothing;
+    store->col[at] = 0;
+    store->row[at] = 0;
+    store->state[at] = (Uint8)state;
+    store->tag[at] = -1;
+    store->owner[at] = entry;
+    store->total++;
+
+    return ((SpriteHandle)store->generation[entry] << GE_HANDLE_INDEX_BITS) | entry;
+}
+
+/********************************************//**
+ * @brief
+ * Looks a handle up
+ * @param store struct SpriteStore*
+ * @param handle SpriteHandle
+ * @return int
+ * dense index, -1 if the sprite is gone
+ ***********************************************/
+int GE_SpriteIndex(const struct SpriteStore *store, SpriteHandle handle) {
+    Uint32 entry = (Uint32)(handle & GE_HANDLE_INDEX_MASK);
+
+    if (handle == GE_NO_SPRITE || entry >= (Uint32)store->total_handles
+        || store->generation[entry] != (Uint32)(handle >> GE_HANDLE_INDEX_BITS))
+        return -1;
+
+    return (int)store->dense_of[entry];
+}
+
+/********************************************//**
+ * @brief
+ * Handle of the sprite currently at a dense index
+ * @param store const struct SpriteStore*
+ * @param index int
+ * @return SpriteHandle
+ ***********************************************/
+SpriteHandle GE_HandleAt(const struct SpriteStore *store, int index) {
+    Uint32 entry = store->owner[index];
+
+    return ((SpriteHandle)store->generation[entry] << GE_HANDLE_INDEX_BITS) | entry;
+}
+
+/********************************************//**
+ * @brief
+ * Removes a sprite, the last one moves into its place
+ * @param store struct SpriteStore*
+ * @param handle SpriteHandle
+ * @return int
+ * dense index whose contents changed (anything cached per index needs redoing), -1 if nothing was removed
+ ***********************************************/
+int GE_RemoveSprite(struct SpriteStore *store, SpriteHandle handle) {
+    int at = GE_SpriteIndex(store, handle);
+    int last = store->total - 1;
+    Uint32 entry = (Uint32)(handle & GE_HANDLE_INDEX_MASK);
+
+    if (at == -1)
+        return -1;
+
+    store->x[at] = store->x[last];
+    store->y[at] = store->y[last];
+    store->frm[at] = store->frm[last];
+    store->col[at] = store->col[last];
+    store->row[at] = store->row[last];
+    store->state[at] = store->state[last];
+    store->tag[at] = store->tag[last];
+    store->owner[at] = store->owner[last];
+    store->dense_of[store->owner[at]] = (Uint32)at;
+
+    // Bumping the generation kills any handle still pointing at this entry
+    store->generation[entry]++;
+    store->dense_of[entry] = store->free_handle;
+    store->free_handle = entry;
+    store->total--;
+
+    return at;
+}
+
+void GE_DestroyStore(struct SpriteStore *store) {
+    free(store->x);
+    free(store->y);
+    free(store->frm);
+    free(store->col);
+    free(store->row);
+    free(store->state);
+    free(store->tag);
+    free(store->owner);
+    free(store->dense_of);
+    free(store->generation);
+    memset(store, 0, sizeof(*store));
 }
 
 #endif //ZELDATRACKER_GAMEELEMENTS_H
@@ -0,0 +1,323 @@
+#ifndef ZELDATRACKER_GAMEEXPORT_H
+#define ZELDATRACKER_GAMEEXPORT_H
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GEX_SHARED_MEMORY 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Hands every presented frame to other processes, so capture tools and encoders can take the
+ * tracker straight from memory instead of grabbing the window. Frames go into a POSIX shared
+ * memory object laid out as
+ *
+ *     struct ExportHeader     magic, geometry and the newest sequence
+ *     struct ExportSlot       GEX_SLOTS of them, one per frame buffer
+ *     pixels                  GEX_SLOTS frames of height * pitch bytes, ARGB8888
+ *
+ * and/or appended to a file: YUV4MPEG2 (4:2:0) if the name ends in .y4m, bare ARGB8888 frames
+ * otherwise. Nothing is rendered while nothing changes, so the .y4m repeats the last frame until
+ * the next one is due to keep to its frame rate, the raw file just has one frame per present.
+ *
+ * The renderer reads each frame back once, straight into the slot it's publishing to
+ * (GEX_BeginFrame / GEX_EndFrame). A slot's sequence is 0 while it's being written, so readers
+ * take the header's sequence s, copy slot (s - 1) % GEX_SLOTS if its sequence is s and check it
+ * still is afterwards, otherwise the writer lapped them and they try again. When the frame size
+ * changes the object is resized and generation bumped, readers have to map it again.
+ */
+
+#define GEX_SLOTS 4
+
+const char GEX_MAGIC[8] = { 'Z', 'T', 'F', 'R', 'A', 'M', 'E', '1' };
+
+struct ExportSlot {
+    Uint64 sequence;        // frame in this slot, 0 while it's being written
+    Uint64 presented_ns;    // SDL_GetPerformanceCounter time it was rendered at, in ns
+};
+
+struct ExportHeader {
+    char magic[8];
+    Uint32 generation;      // bumped whenever the geometry below changes
+    Uint32 format;          // SDL_PIXELFORMAT_ARGB8888
+    Uint32 w;
+    Uint32 h;
+    Uint32 pitch;           // bytes per row
+    Uint32 slots;
+    Uint64 frame_offset;    // from the start of the object to slot 0's pixels
+    Uint64 frame_bytes;     // slot i starts at frame_offset + i * frame_bytes
+    Uint64 sequence;        // newest complete frame, 0 before the first
+    struct ExportSlot slot[GEX_SLOTS];
+};
+
+struct FrameExport {
+    char name[64];          // shared memory object, empty for none
+    int fd;
+    Uint8 *map;
+    size_t map_size;
+    struct ExportHeader *header;
+    Uint8 *pixels;          // stands in for the slots when there's no shared memory
+    size_t pixels_size;
+
+    FILE *sink;
+    int y4m;
+    int fps;
+    Uint8 *yuv;             // the last frame written to a .y4m
+    size_t yuv_size;
+    Uint64 first_presented; // counter at the first frame written to a .y4m
+    Uint64 written;         // frames in the .y4m so far, repeats included
+
+    int w;
+    int h;
+    int pitch;
+    Uint32 generation;
+    Uint64 sequence;
+    Uint8 *writing;         // slot handed out by GEX_BeginFrame, NULL if none
+};
+
+
+/********************************************//**
+ * @brief
+ * Starts exporting. Nothing is sized until the first frame.
+ * @param export struct FrameExport*
+ * @param name const char* shared memory object ("/zelda-tracker"), NULL for none
+ * @param sink_path const char* file to append frames to, NULL for none
+ * @param fps int frame rate written into a .y4m header
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GEX_OpenExport(struct FrameExport *export, const char *name, const char *sink_path, int fps) {
+    size_t length = (sink_path != NULL) ? strlen(sink_path) : 0;
+
+    memset(export, 0, sizeof(*export));
+    export->fd = -1;
+    export->fps = (fps > 0) ? fps : 60;
+
+    if (name != NULL) {
+#ifdef GEX_SHARED_MEMORY
+        snprintf(export->name, sizeof(export->name), "%s", name);
+        export->fd = shm_open(export->name, O_CREAT | O_RDWR, 0600);
+        if (export->fd == -1) {
+            DEBUG_ERR("Unable to create the frame export's shared memory");
+            return -1;
+        }
+#else
+        DEBUG_ERR("Shared memory frame export isn't available on this platform");
+        return -1;
+#endif
+    }
+
+    if (sink_path != NULL) {
+        export->y4m = (length > 4 && strcmp(sink_path + length - 4, ".y4m") == 0);
+        export->sink = fopen(sink_path, "wb");
+        if (export->sink == NULL) {
+            DEBUG_ERR("Unable to open the frame export file");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * (Re)sizes everything for w x h frames, a new shared memory generation if it had to change
+ * @param export struct FrameExport*
+ * @param w int
+ * @param h int
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GEX_Resize(struct FrameExport *export, int w, int h) {
+    size_t frame_bytes = (size_t)w * h * 4;
+
+    if (w == export->w && h == export->h)
+        return 0;
+
+    // The first frame of a .y4m fixes its size for good, anything after is cut/padded to it
+    if (export->sink != NULL && export->y4m && export->yuv == NULL) {
+        fprintf(export->sink, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", w & ~1, h & ~1, export->fps);
+        export->yuv_size = (size_t)(w & ~1) * (h & ~1) * 3 / 2;
+        export->yuv = malloc(export->yuv_size);
+        if (export->yuv == NULL)
+            return -1;
+    }
+
+    export->w = w;
+    export->h = h;
+    export->pitch = w * 4;
+    export->generation++;
+
+#ifdef GEX_SHARED_MEMORY
+    if (export->fd != -1) {
+        size_t offset = (sizeof(struct ExportHeader) + 63) & ~(size_t)63;
+        size_t size = offset + frame_bytes * GEX_SLOTS;
+
+        // Never shrinks, a reader still mapped at the old size would fault past the new end
+        if (size < export->map_size)
+            size = export->map_size;
+        if (export->map != NULL)
+            munmap(export->map, export->map_size);
+        export->map = NULL;
+        export->header = NULL;
+
+        if (ftruncate(export->fd, (off_t)size) != 0)
+            return -1;
+        export->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, export->fd, 0);
+        if (export->map == MAP_FAILED) {
+            export->map = NULL;
+            return -1;
+        }
+        export->map_size = size;
+        export->header = (struct ExportHeader *)export->map;
+
+        memset(export->header, 0, sizeof(*export->header));
+        export->header->format = SDL_PIXELFORMAT_ARGB8888;
+        export->header->w = (Uint32)w;
+        export->header->h = (Uint32)h;
+        export->header->pitch = (Uint32)export->pitch;
+        export->header->slots = GEX_SLOTS;
+        export->header->frame_offset = offset;
+        export->header->frame_bytes = frame_bytes;
+        __atomic_store_n(&export->header->sequence, export->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&export->header->generation, export->generation, __ATOMIC_RELAXED);
+        // Readers check the magic last, it goes in once everything else is
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(export->header->magic, GEX_MAGIC, sizeof(GEX_MAGIC));
+        return 0;
+    }
+#endif
+
+    free(export->pixels);
+    export->pixels = malloc(frame_bytes);
+    export->pixels_size = frame_bytes;
+    return (export->pixels == NULL) ? -1 : 0;
+}
+
+/********************************************//**
+ * @brief
+ * Where the next frame goes, w x h ARGB8888 rows export->pitch apart. Write it and call
+ * GEX_EndFrame (or don't, if it couldn't be read back, the slot is just reused).
+ * @param export struct FrameExport*
+ * @param w int
+ * @param h int
+ * @return void*
+ * NULL on failure
+ ***********************************************/
+void *GEX_BeginFrame(struct FrameExport *export, int w, int h) {
+    if (GEX_Resize(export, w, h) != 0) {
+        export->w = 0;
+        export->h = 0;
+        return NULL;
+    }
+
+    if (export->header != NULL) {
+        int slot = (int)(export->sequence % GEX_SLOTS);
+
+        __atomic_store_n(&export->header->slot[slot].sequence, 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        export->writing = export->map + export->header->frame_offset + (size_t)slot * export->header->frame_bytes;
+    } else {
+        export->writing = export->pixels;
+    }
+
+    return export->writing;
+}
+
+/********************************************//**
+ * @brief
+ * Appends the frame to the sink as 4:2:0, cut to even dimensions, after as many repeats of the
+ * last one as the time since it calls for
+ * @param export struct FrameExport*
+ * @param frame const Uint8*
+ * @param presented Uint64 SDL_GetPerformanceCounter when it was rendered
+ * @return void
+ ***********************************************/
+void GEX_WriteY4m(struct FrameExport *export, const Uint8 *frame, Uint64 presented) {
+    int w = export->w & ~1;
+    int h = export->h & ~1;
+    Uint64 due;
+
+    if (w == 0 || h == 0)
+        return;
+
+    // The window was resized since the header went out, keep the old size
+    if ((size_t)w * h * 3 / 2 != export->yuv_size)
+        return;
+
+    if (export->written == 0)
+        export->first_presented = presented;
+    due = (Uint64)((double)(presented - export->first_presented) * export->fps
+                   / (double)SDL_GetPerformanceFrequency());
+    for (; export->written < due; export->written++) {
+        fputs("FRAME\n", export->sink);
+        fwrite(export->yuv, 1, export->yuv_size, export->sink);
+    }
+
+    if (SDL_ConvertPixels(w, h, SDL_PIXELFORMAT_ARGB8888, frame, export->pitch,
+                          SDL_PIXELFORMAT_IYUV, export->yuv, w) != 0)
+        return;
+
+    // Two presents inside one frame time, the later one replaces the earlier
+    if (export->written > due)
+        fseek(export->sink, -(long)(export->yuv_size + 6), SEEK_CUR);
+    else
+        export->written++;
+    fputs("FRAME\n", export->sink);
+    fwrite(export->yuv, 1, export->yuv_size, export->sink);
+}
+
+/********************************************//**
+ * @brief
+ * Publishes the frame written since GEX_BeginFrame and appends it to the sink
+ * @param export struct FrameExport*
+ * @param presented Uint64 SDL_GetPerformanceCounter when it was rendered
+ * @return Uint64
+ * its sequence number
+ ***********************************************/
+Uint64 GEX_EndFrame(struct FrameExport *export, Uint64 presented) {
+    Uint8 *frame = export->writing;
+
+    if (frame == NULL)
+        return export->sequence;
+    export->writing = NULL;
+    export->sequence++;
+
+    if (export->header != NULL) {
+        struct ExportSlot *slot = &export->header->slot[(export->sequence - 1) % GEX_SLOTS];
+
+        slot->presented_ns = (Uint64)((double)presented * 1e9 / (double)SDL_GetPerformanceFrequency());
+        __atomic_store_n(&slot->sequence, export->sequence, __ATOMIC_RELEASE);
+        __atomic_store_n(&export->header->sequence, export->sequence, __ATOMIC_RELEASE);
+    }
+
+    if (export->sink != NULL) {
+        if (export->y4m)
+            GEX_WriteY4m(export, frame, presented);
+        else
+            fwrite(frame, 1, (size_t)export->pitch * export->h, export->sink);
+    }
+
+    return export->sequence;
+}
+
+void GEX_CloseExport(struct FrameExport *export) {
+#ifdef GEX_SHARED_MEMORY
+    if (export->map != NULL)
+        munmap(export->map, export->map_size);
+    if (export->fd != -1) {
+        close(export->fd);
+        shm_unlink(export->name);
+    }
+#endif
+    if (export->sink != NULL)
+        fclose(export->sink);
+    free(export->pixels);
+    free(export->yuv);
+    memset(export, 0, sizeof(*export));
+    export->fd = -1;
+}
+
+#endif //ZELDATRACKER_GAMEEXPORT_H
@@ -0,0 +1,283 @@
+#ifndef ZELDATRACKER_GAMEHISTORY_H
+#define ZELDATRACKER_GAMEHISTORY_H
+
+/*
+ * Undo/redo for what the runner tracked. Everything that's kept between runs, one ON bit per
+ * slot and a 4 bit dungeon tag per slot, is packed into a few words per 64 slots
+ *
+ *     word[0, on_words)                       slot s is bit s % 64 of word s / 64
+ *     word[on_words, on_words + tag_words)    slot s is bits 4 * (s % 16) of word on_words + s / 16
+ *
+ * so taking a snapshot is a copy and comparing two is XORing them word by word. Each step of
+ * history is only the words that changed, XORed: applying it once undoes it, applying it again
+ * redoes it. Steps and their words go round two fixed rings, the oldest steps fall off when
+ * either fills up. The state words are sized by GH_Reset, nothing is allocated between resets.
+ */
+
+#define GH_STEPS 4096               // power of two
+#define GH_DELTA_WORDS 16384        // power of two
+
+const Uint64 GH_NIBBLE_LOW = 0x1111111111111111ull;
+
+struct HistoryStep {
+    Uint32 first;           // running count into the delta ring
+    Uint32 words;
+};
+
+struct History {
+    int total_slots;        // 0 if there's no history (GH_Reset couldn't allocate)
+    int on_words;
+    int tag_words;
+    int capacity;           // words now/recorded have room for
+    Uint64 *now;            // on_words + tag_words
+    Uint64 *recorded;       // as of the last GH_Commit/GH_Undo/GH_Redo
+    Uint64 *touched;        // on_words, GH_Apply's scratch
+
+    struct HistoryStep *steps;  // GH_STEPS
+    Uint32 *delta_at;       // GH_DELTA_WORDS, which word
+    Uint64 *delta;          // GH_DELTA_WORDS, XOR of its old and new value
+    Uint32 delta_head;      // running count of delta words written
+
+    // Running step counts, steps [oldest, cursor) can be undone and [cursor, newest) redone
+    Uint32 oldest;
+    Uint32 cursor;
+    Uint32 newest;
+};
+
+
+int GH_InitHistory(struct History *history) {
+    memset(history, 0, sizeof(*history));
+    history->steps = malloc(sizeof(struct HistoryStep) * GH_STEPS);
+    history->delta_at = malloc(sizeof(Uint32) * GH_DELTA_WORDS);
+    history->delta = malloc(sizeof(Uint64) * GH_DELTA_WORDS);
+
+    return (history->steps == NULL || history->delta_at == NULL || history->delta == NULL) ? -1 : 0;
+}
+
+void GH_DestroyHistory(struct History *history) {
+    free(history->now);
+    free(history->recorded);
+    free(history->touched);
+    free(history->steps);
+    free(history->delta_at);
+    free(history->delta);
+    memset(history, 0, sizeof(*history));
+}
+
+/********************************************//**
+ * @brief
+ * Records slot's ON bit and tag in the current state. Nothing goes into the history until
+ * GH_Commit.
+ * @param history struct History*
+ * @param slot int
+ * @param on int
+ * @param tag int dungeon 1-15, anything else is no tag
+ * @return void
+ ***********************************************/
+void GH_Set(struct History *history, int slot, int on, int tag) {
+    Uint64 *tags;
+    int shift = (slot % 16) * 4;
+
+    if (slot < 0 || slot >= history->total_slots)
+        return;
+
+    history->now[slot / 64] &= ~((Uint64)1 << (slot % 64));
+    history->now[slot / 64] |= (Uint64)(on != 0) << (slot % 64);
+
+    tags = &history->now[history->on_words + slot / 16];
+    *tags &= ~((Uint64)0xF << shift);
+    *tags |= (Uint64)((tag > 0) ? tag & 0xF : 0) << shift;
+}
+
+int GH_On(const struct History *history, int slot) {
+    return (int)(history->now[slot / 64] >> (slot % 64)) & 1;
+}
+
+int GH_Tag(const struct History *history, int slot) {
+    return (int)(history->now[history->on_words + slot / 16] >> ((slot % 16) * 4)) & 0xF;
+}
+
+/********************************************//**
+ * @brief
+ * Starts over from the given state, with nothing to undo or redo. The state words grow to fit
+ * total_slots if they have to.
+ * @param history struct History*
+ * @param state const Uint8* total_slots, SPRITE_STATE_ON is all that's kept
+ * @param tag const Sint8* total_slots
+ * @param total_slots int
+ * @return int
+ * 0 on success, -1 if there was no room for them (there's no history until the next reset)
+ ***********************************************/
+int GH_Reset(struct History *history, const Uint8 *state, const Sint8 *tag, int total_slots) {
+    int on_words = (total_slots + 63) / 64;
+    int words = on_words + (total_slots + 15) / 16;
+
+    history->total_slots = 0;
+    history->on_words = 0;
+    history->tag_words = 0;
+    history->oldest = history->cursor = history->newest = 0;
+    history->delta_head = 0;
+
+    if (words > history->capacity) {
+        Uint64 *now = realloc(history->now, sizeof(Uint64) * words);
+        Uint64 *recorded = (now != NULL) ? realloc(history->recorded, sizeof(Uint64) * words) : NULL;
+        Uint64 *touched = (recorded != NULL) ? realloc(history->touched, sizeof(Uint64) * on_words) : NULL;
+
+        if (now != NULL)
+            history->now = now;
+        if (recorded != NULL)
+            history->recorded = recorded;
+        if (touched == NULL) {
+            DEBUG_ERR("Unable to make room for the undo history, undo is off");
+            return -1;
+        }
+        history->touched = touched;
+        history->capacity = words;
+    }
+
+    history->total_slots = total_slots;
+    history->on_words = on_words;
+    history->tag_words = words - on_words;
+    memset(history->now, 0, sizeof(Uint64) * words);
+    for (int slot = 0; slot < total_slots; slot++)
+        GH_Set(history, slot, state[slot] & SPRITE_STATE_ON, tag[slot]);
+    memcpy(history->recorded, history->now, sizeof(Uint64) * words);
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Appends word's change to the delta ring if it has one
+ * @param history struct History*
+ * @param word int
+ * @return int
+ * 1 if it changed
+ ***********************************************/
+int GH_PushDelta(struct History *history, int word) {
+    Uint64 changed = history->now[word] ^ history->recorded[word];
+    Uint32 at = history->delta_head % GH_DELTA_WORDS;
+
+    if (changed == 0)
+        return 0;
+
+    history->delta_at[at] = (Uint32)word;
+    history->delta[at] = changed;
+    history->delta_head++;
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * Makes everything set since the last commit one step of history, dropping whatever could be
+ * redone
+ * @param history struct History*
+ * @return int
+ * 1 if a step was recorded, 0 if nothing had changed
+ ***********************************************/
+int GH_Commit(struct History *history) {
+    struct HistoryStep *step;
+    Uint32 first;
+    Uint32 words = 0;
+
+    if (history->total_slots == 0)
+        return 0;
+
+    // Undone steps' words get written over
+    first = (history->cursor != history->newest) ? history->steps[history->cursor % GH_STEPS].first
+                                                 : history->delta_head;
+    history->delta_head = first;
+    for (int w = 0; w < history->on_words; w++)
+        words += (Uint32)GH_PushDelta(history, w);
+    for (int w = history->on_words; w < history->on_words + history->tag_words; w++)
+        words += (Uint32)GH_PushDelta(history, w);
+    if (words == 0)
+        return 0;
+
+    step = &history->steps[history->cursor % GH_STEPS];
+    step->first = first;
+    step->words = words;
+    history->newest = ++history->cursor;
+    memcpy(history->recorded, history->now, sizeof(Uint64) * (history->on_words + history->tag_words));
+
+    // Whatever no longer fits, oldest first
+    while (history->newest - history->oldest > GH_STEPS
+           || history->delta_head - history->steps[history->oldest % GH_STEPS].first > GH_DELTA_WORDS)
+        history->oldest++;
+
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * XORs a step into the current state and lists the slots it touched
+ * @param history struct History*
+ * @param step const struct HistoryStep*
+ * @param slots int* out, room for total_slots, in slot order
+ * @return int
+ * how many
+ ***********************************************/
+int GH_Apply(struct History *history, const struct HistoryStep *step, int *slots) {
+    Uint64 *touched = history->touched;
+    int total = 0;
+
+    memset(touched, 0, sizeof(Uint64) * history->on_words);
+    for (Uint32 i = 0; i < step->words; i++) {
+        Uint32 at = (step->first + i) % GH_DELTA_WORDS;
+        int word = (int)history->delta_at[at];
+        Uint64 changed = history->delta[at];
+
+        history->now[word] ^= changed;
+        if (word < history->on_words) {
+            touched[word] |= changed;
+            continue;
+        }
+
+        // One bit per tag that changed, moved down to its slot's bit
+        word -= history->on_words;
+        changed = (changed | (changed >> 1) | (changed >> 2) | (changed >> 3)) & GH_NIBBLE_LOW;
+        for (; changed != 0; changed &= changed - 1)
+            touched[word / 4] |= (Uint64)1 << ((word % 4) * 16 + __builtin_ctzll(changed) / 4);
+    }
+    memcpy(history->recorded, history->now, sizeof(Uint64) * (history->on_words + history->tag_words));
+
+    for (int w = 0; w < history->on_words; w++)
+        for (Uint64 bits = touched[w]; bits != 0; bits &= bits - 1)
+            slots[total++] = w * 64 + __builtin_ctzll(bits);
+
+    return total;
+}
+
+/********************************************//**
+ * @brief
+ * Steps back once. Commit first, anything set since the last commit would be lost.
+ * @param history struct History*
+ * @param slots int* out, room for total_slots
+ * @return int
+ * slots that changed, 0 if there's nothing to undo
+ ***********************************************/
+int GH_Undo(struct History *history, int *slots) {
+    if (history->cursor == history->oldest)
+        return 0;
+
+    history->cursor--;
+    return GH_Apply(history, &history->steps[history->cursor % GH_STEPS], slots);
+}
+
+/********************************************//**
+ * @brief
+ * Steps forward again after GH_Undo
+ * @param history struct History*
+ * @param slots int* out, room for total_slots
+ * @return int
+ * slots that changed, 0 if there's nothing to redo
+ ***********************************************/
+int GH_Redo(struct History *history, int *slots) {
+    if (history->cursor == history->newest)
+        return 0;
+
+    history->cursor++;
+    return GH_Apply(history, &history->steps[(history->cursor - 1) % GH_STEPS], slots);
+}
+
+#endif //ZELDATRACKER_GAMEHISTORY_H
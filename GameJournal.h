@@ -0,0 +1,534 @@
+#ifndef ZELDATRACKER_GAMEJOURNAL_H
+#define ZELDATRACKER_GAMEJOURNAL_H
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+ * Keeps the tracker's per-slot state on disk so a crash (or a stray Escape) doesn't lose a run.
+ *
+ *     <path>          journal, a header then fixed size records, one per change, appended
+ *     <path>.snap     snapshot, a header then every slot's state and tag
+ *
+ * The state side only ever pushes records into a lock-free queue, a writer thread appends them
+ * and fsyncs at most every GJ_SYNC_MS, so a click costs a few stores. Every GJ_SNAPSHOT_EVERY
+ * records the state side hands over a full copy, the writer replaces the snapshot and starts an
+ * empty journal, so replay never has more than that many records to get through.
+ *
+ * Both files carry an epoch. A journal only applies on top of the snapshot with the same epoch,
+ * so dying between writing a snapshot and starting its journal just leaves a stale journal that
+ * gets ignored. Records carry a check word, a torn tail stops the replay where it tears.
+ *
+ * A snapshot that can't be written leaves the old snapshot and journal in charge, the writer keeps
+ * appending to them and the state side asks again every GJ_RETRY_MS. A journal that can't be
+ * (re)started holds the records in the queue until it can, once that fills the state side falls
+ * back on snapshots as it does for any record that doesn't fit.
+ */
+
+#define GJ_QUEUE_SIZE 1024      // power of two
+#define GJ_REPLAY_CHUNK 256     // records read at a time when restoring
+
+const Uint32 GJ_SNAPSHOT_VERSION = 1;
+const Uint32 GJ_JOURNAL_VERSION = 2;     // 2: 32 bit slots
+const char GJ_JOURNAL_MAGIC[4] = { 'Z', 'T', 'J', 'L' };
+const char GJ_SNAPSHOT_MAGIC[4] = { 'Z', 'T', 'S', 'S' };
+const char *GJ_SNAPSHOT_SUFFIX = ".snap";
+const Uint32 GJ_SYNC_MS = 250;
+const int GJ_SNAPSHOT_EVERY = 512;
+const Uint32 GJ_RETRY_MS = 1000;        // between snapshots asked for after one failed
+
+struct JournalRecord {
+    Uint32 slot;
+    Uint8 state;
+    Sint8 tag;
+    Uint16 unused;
+    Uint32 check;           // GJ_Check of the above, zeroed or torn records fail it
+};
+
+struct JournalHeader {
+    char magic[4];
+    Uint32 version;
+    Uint32 epoch;
+    Uint32 total_slots;
+};
+
+struct Journal {
+    char path[512];
+    char snapshot_path[512];
+    int total_slots;
+
+    // State side -> writer, records [tail, head) are waiting to be written
+    struct JournalRecord queue[GJ_QUEUE_SIZE];
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    int since_snapshot;     // state side, records queued since the last snapshot was handed over
+    int behind;             // state side, a record didn't fit, the next snapshot has to cover it
+    Uint32 requested_at;    // state side, ticks at the last snapshot handed over
+
+    // A snapshot waiting for the writer, taken when head was snapshot_at - 1 (0 if none)
+    Uint8 *snapshot_state;
+    Sint8 *snapshot_tag;
+    SDL_atomic_t snapshot_at;
+    SDL_atomic_t snapshot_failed;   // the writer couldn't write the last one, ask again
+
+    // Writer side
+    Uint32 epoch;
+    FILE *file;             // NULL until the first snapshot, or if the journal couldn't be started
+    int snapshotted;        // a snapshot at epoch was written this run, the journal can start over on it
+    int reported;           // the journal couldn't be written and we've said so
+    int dirty;              // written but not yet fsynced
+    Uint32 synced_at;
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    SDL_atomic_t quit;
+};
+
+
+Uint32 GJ_Check(Uint32 slot, Uint8 state, Sint8 tag) {
+    Uint32 packed = (Uint32)state | ((Uint32)(Uint8)tag << 8);
+
+    return ~((slot * 2654435761u) ^ (packed * 2246822519u) ^ (slot >> 16));
+}
+
+/********************************************//**
+ * @brief
+ * Pushes whatever's buffered for file down to the disk
+ * @param file FILE*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GJ_Sync(FILE *file) {
+    if (fflush(file) != 0)
+        return -1;
+#ifdef _WIN32
+    return _commit(_fileno(file));
+#else
+    return fsync(fileno(file));
+#endif
+}
+
+void GJ_FillHeader(struct JournalHeader *header, const char *magic, Uint32 version, Uint32 epoch,
+                   int total_slots) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, magic, sizeof(header->magic));
+    header->version = version;
+    header->epoch = epoch;
+    header->total_slots = (Uint32)total_slots;
+}
+
+int GJ_CheckHeader(const struct JournalHeader *header, const char *magic, Uint32 version, int total_slots) {
+    return memcmp(header->magic, magic, sizeof(header->magic)) == 0
+           && header->version == version
+           && header->total_slots == (Uint32)total_slots;
+}
+
+/********************************************//**
+ * @brief
+ * Rebuilds state/tag from the snapshot plus the journal written on top of it. Slots the files
+ * don't mention are left alone, as is everything if the files were written for a different
+ * number of slots (sprites.cfg changed).
+ * @param path const char* the journal, the snapshot is next to it
+ * @param state Uint8* total_slots
+ * @param tag Sint8* total_slots
+ * @param total_slots int
+ * @param epoch Uint32* out, the snapshot's epoch, 0 if there was none
+ * @return int
+ * records replayed from the journal, -1 if there was nothing usable
+ ***********************************************/
+int GJ_Restore(const char *path, Uint8 *state, Sint8 *tag, int total_slots, Uint32 *epoch) {
+    struct JournalHeader header;
+    struct JournalRecord records[GJ_REPLAY_CHUNK];
+    char snapshot_path[512];
+    FILE *in;
+    size_t total_read;
+    int replayed = 0;
+    int torn = 0;
+
+    *epoch = 0;
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s%s", path, GJ_SNAPSHOT_SUFFIX);
+
+    // Snapshot first, without one the journal has nothing to apply to
+    in = fopen(snapshot_path, "rb");
+    if (in == NULL)
+        return -1;
+    if (fread(&header, sizeof(header), 1, in) != 1 || !GJ_CheckHeader(&header, GJ_SNAPSHOT_MAGIC, GJ_SNAPSHOT_VERSION, total_slots)
+        || fread(state, sizeof(Uint8), total_slots, in) != (size_t)total_slots
+        || fread(tag, sizeof(Sint8), total_slots, in) != (size_t)total_slots) {
+        fclose(in);
+        DEBUG_ERR("Ignoring a snapshot that doesn't match sprites.cfg");
+        return -1;
+    }
+    fclose(in);
+    *epoch = header.epoch;
+
+    in = fopen(path, "rb");
+    if (in == NULL)
+        return 0;
+    if (fread(&header, sizeof(header), 1, in) != 1 || !GJ_CheckHeader(&header, GJ_JOURNAL_MAGIC, GJ_JOURNAL_VERSION, total_slots)
+        || header.epoch != *epoch) {
+        fclose(in);
+        return 0;
+    }
+
+    while (!torn && (total_read = fread(records, sizeof(struct JournalRecord), GJ_REPLAY_CHUNK, in)) > 0) {
+        for (size_t i = 0; i < total_read; i++) {
+            const struct JournalRecord *record = &records[i];
+
+            if (record->slot >= (Uint32)total_slots
+                || record->check != GJ_Check(record->slot, record->state, record->tag)) {
+                torn = 1;
+                break;
+            }
+            state[record->slot] = record->state;
+            tag[record->slot] = record->tag;
+            replayed++;
+        }
+    }
+    fclose(in);
+
+    return replayed;
+}
+
+/********************************************//**
+ * @brief
+ * Writer: starts an empty journal at the current epoch, in place of whatever was there
+ * @param journal struct Journal*
+ * @return int
+ * 0 on success, -1 on failure (file is left NULL)
+ ***********************************************/
+int GJ_StartJournal(struct Journal *journal) {
+    struct JournalHeader header;
+
+    if (journal->file != NULL)
+        fclose(journal->file);
+    journal->file = fopen(journal->path, "wb");
+    if (journal->file == NULL)
+        return -1;
+
+    GJ_FillHeader(&header, GJ_JOURNAL_MAGIC, GJ_JOURNAL_VERSION, journal->epoch, journal->total_slots);
+    if (fwrite(&header, sizeof(header), 1, journal->file) != 1) {
+        fclose(journal->file);
+        journal->file = NULL;
+        return -1;
+    }
+    journal->dirty = 1;
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Writer: replaces the snapshot with the one waiting in the journal and starts a fresh journal
+ * on top of it
+ * @param journal struct Journal*
+ * @return int
+ * 0 if the snapshot was written (the journal may not have started, file is NULL then), -1 if
+ * not (the old snapshot and journal stay as they were)
+ ***********************************************/
+int GJ_WriteSnapshot(struct Journal *journal) {
+    struct JournalHeader header;
+    char temp_path[520];
+    Uint32 epoch = journal->epoch + 1;
+    FILE *out;
+    int ok;
+
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", journal->snapshot_path);
+    out = fopen(temp_path, "wb");
+    if (out == NULL)
+        return -1;
+
+    GJ_FillHeader(&header, GJ_SNAPSHOT_MAGIC, GJ_SNAPSHOT_VERSION, epoch, journal->total_slots);
+    ok = fwrite(&header, sizeof(header), 1, out) == 1
+         && fwrite(journal->snapshot_state, sizeof(Uint8), journal->total_slots, out) == (size_t)journal->total_slots
+         && fwrite(journal->snapshot_tag, sizeof(Sint8), journal->total_slots, out) == (size_t)journal->total_slots
+         && GJ_Sync(out) == 0;
+    ok = (fclose(out) == 0) && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA(temp_path, journal->snapshot_path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && rename(temp_path, journal->snapshot_path) == 0;
+#endif
+    if (!ok) {
+        remove(temp_path);
+        return -1;
+    }
+
+    // From here on the old journal's epoch no longer matches, it's dead whatever happens next
+    journal->epoch = epoch;
+    journal->snapshotted = 1;
+    GJ_StartJournal(journal);
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Writer: writes out everything queued, handling a waiting snapshot first
+ * @param journal struct Journal*
+ * @return void
+ ***********************************************/
+void GJ_Drain(struct Journal *journal) {
+    int snapshot_at = SDL_AtomicGet(&journal->snapshot_at);
+    int head;
+    int tail = SDL_AtomicGet(&journal->tail);
+
+    for (;;) {
+        if (snapshot_at != 0) {
+            SDL_MemoryBarrierAcquire();
+
+            // Everything queued before the snapshot was taken is already in it. Only ever forward,
+            // records before tail may already have been overwritten by the state side.
+            if (GJ_WriteSnapshot(journal) == 0) {
+                if (snapshot_at - 1 - tail > 0) {
+                    tail = snapshot_at - 1;
+                    SDL_AtomicSet(&journal->tail, tail);
+                }
+            } else {
+                // The old snapshot and journal still hold everything, keep appending to them
+                DEBUG_ERR("Unable to write the tracker snapshot, will try again");
+                SDL_AtomicSet(&journal->snapshot_failed, 1);
+            }
+            SDL_AtomicSet(&journal->snapshot_at, 0);
+        }
+
+        // A snapshot asked for before this head was published goes first, or the records after
+        // it would land in the journal it's about to replace
+        head = SDL_AtomicGet(&journal->head);
+        snapshot_at = SDL_AtomicGet(&journal->snapshot_at);
+        if (snapshot_at == 0)
+            break;
+    }
+    SDL_MemoryBarrierAcquire();
+
+    // A journal that didn't start after its snapshot gets another go. Until there's one the
+    // records wait in the queue (before the first snapshot there's nothing they could go on top of).
+    if (journal->file == NULL && journal->snapshotted)
+        GJ_StartJournal(journal);
+    if (journal->file == NULL) {
+        if (journal->snapshotted && !journal->reported)
+            DEBUG_ERR("Unable to start the tracker journal, holding changes until it can be");
+        journal->reported = journal->snapshotted;
+        return;
+    }
+    journal->reported = 0;
+
+    // At most two runs, before and after the queue wraps
+    while (tail != head) {
+        int from = tail & (GJ_QUEUE_SIZE - 1);
+        int run = head - tail;
+
+        if (from + run > GJ_QUEUE_SIZE)
+            run = GJ_QUEUE_SIZE - from;
+        if (fwrite(&journal->queue[from], sizeof(struct JournalRecord), run, journal->file) != (size_t)run)
+            DEBUG_ERR("Unable to append to the tracker journal");
+
+        tail += run;
+        journal->dirty = 1;
+    }
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&journal->tail, tail);
+}
+
+int GJ_WriterThread(void *data) {
+    struct Journal *journal = data;
+    int quit = 0;
+
+    while (!quit) {
+        SDL_SemWaitTimeout(journal->wake, GJ_SYNC_MS);
+        quit = SDL_AtomicGet(&journal->quit);
+        GJ_Drain(journal);
+
+        // Batched: a burst of clicks costs one fsync, not one each
+        if (journal->dirty && journal->file != NULL
+            && (quit || SDL_GetTicks() - journal->synced_at >= GJ_SYNC_MS)) {
+            if (GJ_Sync(journal->file) != 0)
+                DEBUG_ERR("Unable to sync the tracker journal");
+            journal->dirty = 0;
+            journal->synced_at = SDL_GetTicks();
+        }
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * State side: hands the writer a full copy of state/tag to snapshot
+ * @param journal struct Journal*
+ * @param state const Uint8*
+ * @param tag const Sint8*
+ * @return int
+ * 0 if it was handed over, -1 if the writer is still busy with the last one
+ ***********************************************/
+int GJ_RequestSnapshot(struct Journal *journal, const Uint8 *state, const Sint8 *tag) {
+    if (SDL_AtomicGet(&journal->snapshot_at) != 0)
+        return -1;
+
+    memcpy(journal->snapshot_state, state, sizeof(Uint8) * journal->total_slots);
+    memcpy(journal->snapshot_tag, tag, sizeof(Sint8) * journal->total_slots);
+    SDL_AtomicSet(&journal->snapshot_failed, 0);
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&journal->snapshot_at, SDL_AtomicGet(&journal->head) + 1);
+    SDL_SemPost(journal->wake);
+
+    journal->since_snapshot = 0;
+    journal->behind = 0;
+    journal->requested_at = SDL_GetTicks();
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Everything GJ_OpenJournal does short of the first snapshot and the writer thread, for driving
+ * the writer by hand
+ * @param journal struct Journal*
+ * @param path const char*
+ * @param total_slots int
+ * @param epoch Uint32 from GJ_Restore
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GJ_SetupJournal(struct Journal *journal, const char *path, int total_slots, Uint32 epoch) {
+    memset(journal, 0, sizeof(*journal));
+    snprintf(journal->path, sizeof(journal->path), "%s", path);
+    snprintf(journal->snapshot_path, sizeof(journal->snapshot_path), "%s%s", path, GJ_SNAPSHOT_SUFFIX);
+    journal->total_slots = total_slots;
+    journal->epoch = epoch;
+    SDL_AtomicSet(&journal->head, 0);
+    SDL_AtomicSet(&journal->tail, 0);
+    SDL_AtomicSet(&journal->snapshot_at, 0);
+    SDL_AtomicSet(&journal->snapshot_failed, 0);
+    SDL_AtomicSet(&journal->quit, 0);
+
+    journal->snapshot_state = malloc(sizeof(Uint8) * total_slots);
+    journal->snapshot_tag = malloc(sizeof(Sint8) * total_slots);
+    journal->wake = SDL_CreateSemaphore(0);
+    if (journal->snapshot_state == NULL || journal->snapshot_tag == NULL || journal->wake == NULL) {
+        DEBUG_ERR("Unable to set up the tracker journal");
+        return -1;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Starts journaling on top of state/tag (restore into them first). The writer's first job is a
+ * snapshot of them, so every run starts with an empty journal.
+ * @param journal struct Journal*
+ * @param path const char*
+ * @param state const Uint8*
+ * @param tag const Sint8*
+ * @param total_slots int
+ * @param epoch Uint32 from GJ_Restore
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GJ_OpenJournal(struct Journal *journal, const char *path, const Uint8 *state, const Sint8 *tag,
+                   int total_slots, Uint32 epoch) {
+    if (GJ_SetupJournal(journal, path, total_slots, epoch) != 0)
+        return -1;
+
+    GJ_RequestSnapshot(journal, state, tag);
+    journal->thread = SDL_CreateThread(GJ_WriterThread, "ZT_Journal", journal);
+    if (journal->thread == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * State side: queues one slot's new state, never blocks
+ * @param journal struct Journal*
+ * @param slot int
+ * @param state Uint8
+ * @param tag Sint8
+ * @return void
+ ***********************************************/
+void GJ_Append(struct Journal *journal, int slot, Uint8 state, Sint8 tag) {
+    int head = SDL_AtomicGet(&journal->head);
+    struct JournalRecord *record;
+
+    // Full, the writer must be stuck on the disk. The next snapshot picks this change up.
+    if (head - SDL_AtomicGet(&journal->tail) == GJ_QUEUE_SIZE) {
+        journal->behind = 1;
+        return;
+    }
+
+    record = &journal->queue[head & (GJ_QUEUE_SIZE - 1)];
+    record->slot = (Uint32)slot;
+    record->state = state;
+    record->tag = tag;
+    record->unused = 0;
+    record->check = GJ_Check(record->slot, state, tag);
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&journal->head, head + 1);
+    SDL_SemPost(journal->wake);
+    journal->since_snapshot++;
+}
+
+/********************************************//**
+ * @brief
+ * State side, once a frame: hands over a snapshot when the journal has grown long enough or
+ * dropped a record, or again GJ_RETRY_MS after the writer couldn't write the last one
+ * @param journal struct Journal*
+ * @param state const Uint8*
+ * @param tag const Sint8*
+ * @return void
+ ***********************************************/
+void GJ_Maintain(struct Journal *journal, const Uint8 *state, const Sint8 *tag) {
+    // The last one failed, the disk gets a rest before the next
+    if (SDL_AtomicGet(&journal->snapshot_failed)) {
+        if (SDL_GetTicks() - journal->requested_at >= GJ_RETRY_MS)
+            GJ_RequestSnapshot(journal, state, tag);
+        return;
+    }
+
+    if (journal->behind || journal->since_snapshot >= GJ_SNAPSHOT_EVERY)
+        GJ_RequestSnapshot(journal, state, tag);
+}
+
+/********************************************//**
+ * @brief
+ * Writes out and syncs whatever is still queued, then stops the writer
+ * @param journal struct Journal*
+ * @param state const Uint8* the final state, for a last snapshot if records were dropped (may be NULL)
+ * @param tag const Sint8*
+ * @return Uint32
+ * epoch of the last snapshot written, for a GJ_OpenJournal picking up where this one left off
+ ***********************************************/
+Uint32 GJ_CloseJournal(struct Journal *journal, const Uint8 *state, const Sint8 *tag) {
+    Uint32 epoch;
+
+    // Whatever didn't fit in the queue only makes it to disk with a snapshot
+    if (journal->thread != NULL && journal->behind && state != NULL) {
+        while (GJ_RequestSnapshot(journal, state, tag) != 0)
+            SDL_Delay(1);
+    }
+
+    if (journal->thread != NULL) {
+        SDL_AtomicSet(&journal->quit, 1);
+        SDL_SemPost(journal->wake);
+        SDL_WaitThread(journal->thread, NULL);
+    }
+    if (journal->file != NULL)
+        fclose(journal->file);
+    if (journal->wake != NULL)
+        SDL_DestroySemaphore(journal->wake);
+    free(journal->snapshot_state);
+    free(journal->snapshot_tag);
+    epoch = journal->epoch;
+    memset(journal, 0, sizeof(*journal));
+
+    return epoch;
+}
+
+#endif //ZELDATRACKER_GAMEJOURNAL_H
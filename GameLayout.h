@@ -0,0 +1,143 @@
+#ifndef ZELDATRACKER_GAMELAYOUT_H
+#define ZELDATRACKER_GAMELAYOUT_H
+
+/*
+ * Maps the tracker's logical layout (everything is placed as if the window were base_w x base_h,
+ * the same numbers the game has always used) onto the pixels the window really has. The scale is
+ * a whole number so sprites can come out of an atlas pre-scaled by the same factor
+ * (GA_ScaledTexture) and land 1:1 on pixels, whatever is left over is split evenly around the
+ * layout. Only recomputed when the window's size or pixel density changes, never per frame.
+ */
+struct Layout {
+    int base_w;
+    int base_h;
+    int window_w;       // in points, what mouse events are in
+    int window_h;
+    int pixel_w;        // in pixels, what the renderer draws into
+    int pixel_h;
+    int scale;          // pixels per logical unit
+    int offset_x;       // pixels between the window's edge and the layout
+    int offset_y;
+};
+
+
+/********************************************//**
+ * @brief
+ * Fits the logical layout into the window at the biggest whole scale that shows all of it
+ * (never less than 1, a window that's too small just cuts the bottom/right off)
+ * @param layout struct Layout*
+ * @param base_w int logical size
+ * @param base_h int
+ * @param window_w int window size in points
+ * @param window_h int
+ * @param pixel_w int window size in pixels
+ * @param pixel_h int
+ * @return void
+ ***********************************************/
+void GLY_FitLayout(struct Layout *layout, int base_w, int base_h, int window_w, int window_h,
+                   int pixel_w, int pixel_h) {
+    int scale_w = pixel_w / base_w;
+    int scale_h = pixel_h / base_h;
+
+    layout->base_w = base_w;
+    layout->base_h = base_h;
+    layout->window_w = (window_w > 0) ? window_w : 1;
+    layout->window_h = (window_h > 0) ? window_h : 1;
+    layout->pixel_w = (pixel_w > 0) ? pixel_w : 1;
+    layout->pixel_h = (pixel_h > 0) ? pixel_h : 1;
+    layout->scale = (scale_w < scale_h) ? scale_w : scale_h;
+    if (layout->scale < 1)
+        layout->scale = 1;
+
+    layout->offset_x = (layout->pixel_w - base_w * layout->scale) / 2;
+    layout->offset_y = (layout->pixel_h - base_h * layout->scale) / 2;
+    if (layout->offset_x < 0)
+        layout->offset_x = 0;
+    if (layout->offset_y < 0)
+        layout->offset_y = 0;
+}
+
+/********************************************//**
+ * @brief
+ * Fits the logical layout into a window as it is right now
+ * @param layout struct Layout*
+ * @param window SDL_Window*
+ * @param base_w int logical size
+ * @param base_h int
+ * @return void
+ ***********************************************/
+void GLY_FitWindow(struct Layout *layout, SDL_Window *window, int base_w, int base_h) {
+    int window_w, window_h, pixel_w, pixel_h;
+
+    SDL_GetWindowSize(window, &window_w, &window_h);
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+    SDL_GetWindowSizeInPixels(window, &pixel_w, &pixel_h);
+#else
+    pixel_w = window_w;
+    pixel_h = window_h;
+#endif
+
+    GLY_FitLayout(layout, base_w, base_h, window_w, window_h, pixel_w, pixel_h);
+}
+
+/********************************************//**
+ * @brief
+ * Whether two layouts put things in the same pixels
+ * @param a const struct Layout*
+ * @param b const struct Layout*
+ * @return int
+ * 1 if they do, 0 if not
+ ***********************************************/
+int GLY_SameLayout(const struct Layout *a, const struct Layout *b) {
+    return a->pixel_w == b->pixel_w && a->pixel_h == b->pixel_h && a->scale == b->scale
+           && a->offset_x == b->offset_x && a->offset_y == b->offset_y;
+}
+
+/********************************************//**
+ * @brief
+ * Where a logical rect ends up on the window, in pixels
+ * @param layout const struct Layout*
+ * @param logical const SDL_Rect*
+ * @return SDL_Rect
+ ***********************************************/
+SDL_Rect GLY_ToPixels(const struct Layout *layout, const SDL_Rect *logical) {
+    SDL_Rect pixels = {
+            layout->offset_x + logical->x * layout->scale, layout->offset_y + logical->y * layout->scale,
+            logical->w * layout->scale, logical->h * layout->scale
+    };
+    return pixels;
+}
+
+/********************************************//**
+ * @brief
+ * A rect with every edge multiplied by factor, for looking rects up in a pre-scaled atlas
+ * @param rect const SDL_Rect*
+ * @param factor int
+ * @return SDL_Rect
+ ***********************************************/
+SDL_Rect GLY_Scale(const SDL_Rect *rect, int factor) {
+    SDL_Rect scaled = { rect->x * factor, rect->y * factor, rect->w * factor, rect->h * factor };
+    return scaled;
+}
+
+/********************************************//**
+ * @brief
+ * The logical point under a window point (mouse events), rounded down. Points in the border
+ * around the layout come out negative or past base_w/base_h.
+ * @param layout const struct Layout*
+ * @param x int in points
+ * @param y int
+ * @param logical_x int* out
+ * @param logical_y int* out
+ * @return void
+ ***********************************************/
+void GLY_ToLogical(const struct Layout *layout, int x, int y, int *logical_x, int *logical_y) {
+    int pixel_x = (int)((Sint64)x * layout->pixel_w / layout->window_w) - layout->offset_x;
+    int pixel_y = (int)((Sint64)y * layout->pixel_h / layout->window_h) - layout->offset_y;
+
+    // Round towards -infinity so the column left of the layout doesn't alias column 0
+    *logical_x = (pixel_x >= 0) ? pixel_x / layout->scale : -((-pixel_x + layout->scale - 1) / layout->scale);
+    *logical_y = (pixel_y >= 0) ? pixel_y / layout->scale : -((-pixel_y + layout->scale - 1) / layout->scale);
+}
+
+#endif //ZELDATRACKER_GAMELAYOUT_H
@@ -0,0 +1,562 @@
+#ifndef ZELDATRACKER_GAMEMAP_H
+#define ZELDATRACKER_GAMEMAP_H
+
+/*
+ * Map panel: the 16 x 8 overworld and the room grids of the 9 dungeons, a Uint8 of marks and a
+ * dungeon tag per cell. Every runner has all 10 maps, cell c of map m for runner r is
+ *
+ *     (r * GMP_TOTAL_MAPS + m) * GMP_MAX_CELLS + c        c = row * cols + col
+ *
+ * and only the overworld and the dungeon picked in the tab strip are on screen at once.
+ *
+ * That's hundreds of cells, so the render side keeps every map cut into chunks of 4 x 4 cells,
+ * each cached in a texture (a raster when software rendering) at the layout's scale. A chunk is
+ * only drawn again when one of its cells looks different from when it was last drawn, the same
+ * per-cell keys the compositor uses for slots. Chunks of the maps on screen are brought up to
+ * date every frame, the hidden maps' a few at a time (GMP_WARM_CHUNKS), so by the time a tab is
+ * clicked its chunks are already there and switching is a handful of copies.
+ */
+
+#define GMP_MAX_RUNNERS 8       // same as ZT_MAX_RUNNERS
+#define GMP_TOTAL_MAPS 10       // the overworld, then dungeons 1 - 9
+#define GMP_MAX_CELLS 128       // per map, the overworld's 16 x 8
+#define GMP_CHUNK_CELLS 4       // chunks are 4 x 4 cells
+#define GMP_MAX_CHUNKS 8        // per map
+#define GMP_WARM_CHUNKS 4       // hidden chunks redrawn per frame
+
+const Uint8 GMP_VISITED = 0x01;
+const Uint8 GMP_CLEARED = 0x02;
+const Uint8 GMP_SHOP = 0x04;
+const Uint8 GMP_KEY = 0x08;
+const Uint8 GMP_HOVER = 0x10;   // this run only, never saved
+const int GMP_UNDRAWN = -1;
+
+const Uint32 GMP_COLOR_GRID = 0xFF000000;
+const Uint32 GMP_COLOR_UNVISITED = 0xFF1C1C1C;
+const Uint32 GMP_COLOR_VISITED = 0xFF50508C;
+const Uint32 GMP_COLOR_CLEARED = 0xFF2E7D32;
+const Uint32 GMP_COLOR_SHOP = 0xFFE8C547;
+const Uint32 GMP_COLOR_KEY = 0xFFE0E0E0;
+const Uint32 GMP_COLOR_HOVER = 0x40FFFFFF;
+const Uint32 GMP_COLOR_TAB = 0xFF303030;
+const Uint32 GMP_COLOR_TAB_SHOWN = 0xFF50508C;
+
+struct MapGrid {
+    int cols;
+    int rows;
+    int cell;               // logical px, a cell's last px right and down is the grid line
+    int x;                  // top left, logical, from the panel's
+    int y;
+};
+
+// Logical, from the panel's top left: overworld, the tab strip, then the dungeon shown
+const struct MapGrid GMP_OVERWORLD = { 16, 8, 11, 0, 0 };
+const struct MapGrid GMP_DUNGEON = { 8, 8, 22, 0, 110 };
+const SDL_Rect GMP_TABS = { 0, 92, 171, 14 };
+const int GMP_TAB_W = 19;
+const int GMP_PANEL_W = 176;
+
+// State side
+struct MapState {
+    int runners;
+    int total;              // cells, runners * GMP_TOTAL_MAPS * GMP_MAX_CELLS
+    Uint8 *marks;
+    Sint8 *tag;             // dungeon, -1 if untagged
+    Uint8 shown[GMP_MAX_RUNNERS];   // dungeon each runner's panel shows, 1 - 9
+    SDL_Point at;           // runner 0's panel, logical
+    int tile_w;             // runner r's is tile_w * r further right
+};
+
+struct MapChunk {
+    SDL_Texture *texture;
+    struct Raster pixels;   // software rendering only, in place of the texture
+};
+
+// Render side
+struct MapCache {
+    int software;
+    int scale;              // what the chunks were made at, 0 before GMP_ResizeCache
+    int total_maps;         // runners * GMP_TOTAL_MAPS
+    struct MapChunk *chunks;    // GMP_MAX_CHUNKS per map, unused ones stay empty
+    int *drawn;             // per cell key last drawn into its chunk
+    int warm_next;          // hidden map the warming picks up from
+};
+
+
+const struct MapGrid *GMP_Grid(int map) {
+    return (map == 0) ? &GMP_OVERWORLD : &GMP_DUNGEON;
+}
+
+int GMP_Cell(int runner, int map, int cell) {
+    return (runner * GMP_TOTAL_MAPS + map) * GMP_MAX_CELLS + cell;
+}
+
+int GMP_TotalChunks(int map) {
+    const struct MapGrid *grid = GMP_Grid(map);
+
+    return (grid->cols / GMP_CHUNK_CELLS) * (grid->rows / GMP_CHUNK_CELLS);
+}
+
+/********************************************//**
+ * @brief
+ * Builds a damage key for a cell, two cells with the same key look identical on screen
+ * @param marks int
+ * @param tag int dungeon tag, -1 if untagged
+ * @return int
+ ***********************************************/
+int GMP_CellKey(int marks, int tag) {
+    return marks | ((tag + 1) << 8);
+}
+
+/********************************************//**
+ * @brief
+ * Allocates every runner's maps, all unmarked, each showing dungeon 1
+ * @param maps struct MapState*
+ * @param runners int no more than GMP_MAX_RUNNERS
+ * @param at SDL_Point runner 0's panel, logical
+ * @param tile_w int logical distance between runners' panels
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GMP_InitMaps(struct MapState *maps, int runners, SDL_Point at, int tile_w) {
+    memset(maps, 0, sizeof(*maps));
+    maps->runners = (runners > GMP_MAX_RUNNERS) ? GMP_MAX_RUNNERS : runners;
+    maps->total = maps->runners * GMP_TOTAL_MAPS * GMP_MAX_CELLS;
+    maps->marks = calloc((size_t)maps->total, sizeof(Uint8));
+    maps->tag = malloc(sizeof(Sint8) * maps->total);
+    maps->at = at;
+    maps->tile_w = tile_w;
+
+    if (maps->marks == NULL || maps->tag == NULL) {
+        DEBUG_ERR("Unable to allocate the maps");
+        return -1;
+    }
+
+    memset(maps->tag, -1, sizeof(Sint8) * maps->total);
+    for (int r = 0; r < GMP_MAX_RUNNERS; r++)
+        maps->shown[r] = 1;
+    return 0;
+}
+
+void GMP_DestroyMaps(struct MapState *maps) {
+    free(maps->marks);
+    free(maps->tag);
+    memset(maps, 0, sizeof(*maps));
+}
+
+/********************************************//**
+ * @brief
+ * The cell under a logical point, on the overworld or the dungeon its runner's panel shows
+ * @param maps const struct MapState*
+ * @param x int
+ * @param y int
+ * @return int
+ * cell index, -1 if there's no cell there
+ ***********************************************/
+int GMP_CellAt(const struct MapState *maps, int x, int y) {
+    int runner, map;
+    const struct MapGrid *grid;
+
+    x -= maps->at.x;
+    y -= maps->at.y;
+    if (x < 0 || y < 0)
+        return -1;
+    runner = x / maps->tile_w;
+    x %= maps->tile_w;
+    if (runner >= maps->runners)
+        return -1;
+
+    map = (y < GMP_DUNGEON.y) ? 0 : maps->shown[runner];
+    grid = GMP_Grid(map);
+    x -= grid->x;
+    y -= grid->y;
+    if (x < 0 || y < 0 || x >= grid->cols * grid->cell || y >= grid->rows * grid->cell)
+        return -1;
+
+    return GMP_Cell(runner, map, (y / grid->cell) * grid->cols + x / grid->cell);
+}
+
+/********************************************//**
+ * @brief
+ * The dungeon tab under a logical point
+ * @param maps const struct MapState*
+ * @param x int
+ * @param y int
+ * @param runner int* out, whose panel it's on
+ * @return int
+ * dungeon 1 - 9, 0 if there's no tab there
+ ***********************************************/
+int GMP_TabAt(const struct MapState *maps, int x, int y, int *runner) {
+    x -= maps->at.x;
+    y -= maps->at.y;
+    if (x < 0 || y < GMP_TABS.y || y >= GMP_TABS.y + GMP_TABS.h)
+        return 0;
+    *runner = x / maps->tile_w;
+    x %= maps->tile_w;
+    if (*runner >= maps->runners || x < GMP_TABS.x || x >= GMP_TABS.x + GMP_TABS.w)
+        return 0;
+
+    return 1 + (x - GMP_TABS.x) / GMP_TAB_W;
+}
+
+/********************************************//**
+ * @brief
+ * Sets up an empty cache, chunks get made by GMP_ResizeCache once the scale is known
+ * @param cache struct MapCache*
+ * @param renderer SDL_Renderer* NULL for software rendering
+ * @param runners int
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GMP_InitCache(struct MapCache *cache, SDL_Renderer *renderer, int runners) {
+    int total_cells = runners * GMP_TOTAL_MAPS * GMP_MAX_CELLS;
+
+    memset(cache, 0, sizeof(*cache));
+    cache->software = (renderer == NULL);
+    cache->total_maps = runners * GMP_TOTAL_MAPS;
+    cache->chunks = calloc((size_t)cache->total_maps * GMP_MAX_CHUNKS, sizeof(struct MapChunk));
+    cache->drawn = malloc(sizeof(int) * total_cells);
+    if (cache->chunks == NULL || cache->drawn == NULL) {
+        DEBUG_ERR("Unable to allocate the map cache");
+        return -1;
+    }
+
+    for (int i = 0; i < total_cells; i++)
+        cache->drawn[i] = GMP_UNDRAWN;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Forgets everything that was drawn, every chunk gets redrawn. Needed when the renderer throws
+ * away target contents.
+ * @param cache struct MapCache*
+ * @return void
+ ***********************************************/
+void GMP_Invalidate(struct MapCache *cache) {
+    for (int i = 0; i < cache->total_maps * GMP_MAX_CELLS; i++)
+        cache->drawn[i] = GMP_UNDRAWN;
+}
+
+void GMP_DestroyChunk(struct MapChunk *chunk) {
+    if (chunk->texture != NULL)
+        SDL_DestroyTexture(chunk->texture);
+    chunk->texture = NULL;
+    GX_DestroyRaster(&chunk->pixels);
+}
+
+/********************************************//**
+ * @brief
+ * (Re)creates every chunk at a new scale, everything is redrawn
+ * @param cache struct MapCache*
+ * @param renderer SDL_Renderer*
+ * @param scale int pixels per logical unit
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GMP_ResizeCache(struct MapCache *cache, SDL_Renderer *renderer, int scale) {
+    if (scale == cache->scale)
+        return 0;
+
+    for (int m = 0; m < cache->total_maps; m++) {
+        int side = GMP_Grid(m % GMP_TOTAL_MAPS)->cell * GMP_CHUNK_CELLS * scale;
+
+        for (int c = 0; c < GMP_TotalChunks(m % GMP_TOTAL_MAPS); c++) {
+            struct MapChunk *chunk = &cache->chunks[m * GMP_MAX_CHUNKS + c];
+
+            GMP_DestroyChunk(chunk);
+            if (cache->software) {
+                if (GX_InitRaster(&chunk->pixels, side, side) != 0)
+                    return -1;
+                continue;
+            }
+
+            chunk->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                               side, side);
+            if (chunk->texture == NULL) {
+                DEBUG_ERR(SDL_GetError());
+                return -1;
+            }
+            SDL_SetTextureBlendMode(chunk->texture, SDL_BLENDMODE_NONE);
+        }
+    }
+
+    cache->scale = scale;
+    GMP_Invalidate(cache);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * The cells of a chunk, as a rect of cell columns and rows
+ * @param map int
+ * @param chunk int
+ * @return SDL_Rect
+ ***********************************************/
+SDL_Rect GMP_ChunkCells(int map, int chunk) {
+    int across = GMP_Grid(map)->cols / GMP_CHUNK_CELLS;
+    SDL_Rect cells = {
+            (chunk % across) * GMP_CHUNK_CELLS, (chunk / across) * GMP_CHUNK_CELLS,
+            GMP_CHUNK_CELLS, GMP_CHUNK_CELLS
+    };
+    return cells;
+}
+
+/********************************************//**
+ * @brief
+ * Whether any cell of a chunk looks different from when it was drawn
+ * @param cache const struct MapCache*
+ * @param marks const Uint8*
+ * @param tag const Sint8*
+ * @param map int runner * GMP_TOTAL_MAPS + map
+ * @param chunk int
+ * @return int
+ ***********************************************/
+int GMP_ChunkDirty(const struct MapCache *cache, const Uint8 *marks, const Sint8 *tag, int map, int chunk) {
+    const struct MapGrid *grid = GMP_Grid(map % GMP_TOTAL_MAPS);
+    SDL_Rect cells = GMP_ChunkCells(map % GMP_TOTAL_MAPS, chunk);
+
+    for (int row = cells.y; row < cells.y + cells.h; row++)
+        for (int col = cells.x; col < cells.x + cells.w; col++) {
+            int cell = map * GMP_MAX_CELLS + row * grid->cols + col;
+
+            if (cache->drawn[cell] != GMP_CellKey(marks[cell], tag[cell]))
+                return 1;
+        }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Redraws every cell of a chunk into its texture/raster
+ * @param cache struct MapCache*
+ * @param renderer SDL_Renderer*
+ * @param text struct GlyphAtlas* for the tags
+ * @param marks const Uint8*
+ * @param tag const Sint8*
+ * @param map int runner * GMP_TOTAL_MAPS + map
+ * @param chunk int
+ * @return void
+ ***********************************************/
+void GMP_DrawChunk(struct MapCache *cache, SDL_Renderer *renderer, struct GlyphAtlas *text,
+                   const Uint8 *marks, const Sint8 *tag, int map, int chunk) {
+    struct MapChunk *drawing = &cache->chunks[map * GMP_MAX_CHUNKS + chunk];
+    const struct MapGrid *grid = GMP_Grid(map % GMP_TOTAL_MAPS);
+    SDL_Rect cells = GMP_ChunkCells(map % GMP_TOTAL_MAPS, chunk);
+    int scale = cache->scale;
+    int side = grid->cell * scale;
+    int dot = (side / 4 > scale) ? side / 4 : scale;
+    int height = side / 2;
+    char digit[2] = { 0, 0 };
+
+    if (cache->software) {
+        GX_FillRect(&drawing->pixels, NULL, GMP_COLOR_GRID);
+    } else {
+        SDL_SetRenderTarget(renderer, drawing->texture);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+    }
+
+    for (int row = 0; row < cells.h; row++)
+        for (int col = 0; col < cells.w; col++) {
+            int cell = map * GMP_MAX_CELLS + (cells.y + row) * grid->cols + cells.x + col;
+            Uint8 mark = marks[cell];
+            SDL_Rect box = { col * side, row * side, side - scale, side - scale };
+            SDL_Rect shop = { box.x + scale, box.y + scale, dot, dot };
+            SDL_Rect key = { box.x + scale, box.y + box.h - dot - scale, dot, dot };
+            Uint32 color = (mark & GMP_CLEARED) ? GMP_COLOR_CLEARED
+                           : (mark & GMP_VISITED) ? GMP_COLOR_VISITED : GMP_COLOR_UNVISITED;
+            SDL_Point label = { box.x + box.w, box.y + box.h - height };
+
+            cache->drawn[cell] = GMP_CellKey(mark, tag[cell]);
+            digit[0] = (char)('0' + tag[cell]);
+            if (tag[cell] >= 1)
+                label.x -= GTX_MeasureText(text, digit, height);
+
+            if (cache->software) {
+                GX_FillRect(&drawing->pixels, &box, color);
+                if (mark & GMP_SHOP)
+                    GX_FillRect(&drawing->pixels, &shop, GMP_COLOR_SHOP);
+                if (mark & GMP_KEY)
+                    GX_FillRect(&drawing->pixels, &key, GMP_COLOR_KEY);
+                if (mark & GMP_HOVER)
+                    GX_BlendRect(&drawing->pixels, &box, GMP_COLOR_HOVER);
+                if (tag[cell] >= 1)
+                    GTX_DrawText(text, &drawing->pixels, digit, label.x, label.y, height, 255);
+                continue;
+            }
+
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+            SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+            SDL_RenderFillRect(renderer, &box);
+            if (mark & GMP_SHOP) {
+                SDL_SetRenderDrawColor(renderer, (GMP_COLOR_SHOP >> 16) & 0xFF, (GMP_COLOR_SHOP >> 8) & 0xFF,
+                                       GMP_COLOR_SHOP & 0xFF, 255);
+                SDL_RenderFillRect(renderer, &shop);
+            }
+            if (mark & GMP_KEY) {
+                SDL_SetRenderDrawColor(renderer, (GMP_COLOR_KEY >> 16) & 0xFF, (GMP_COLOR_KEY >> 8) & 0xFF,
+                                       GMP_COLOR_KEY & 0xFF, 255);
+                SDL_RenderFillRect(renderer, &key);
+            }
+            if (mark & GMP_HOVER) {
+                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+                SDL_SetRenderDrawColor(renderer, 255, 255, 255, GMP_COLOR_HOVER >> 24);
+                SDL_RenderFillRect(renderer, &box);
+            }
+            if (tag[cell] >= 1)
+                GTX_PushText(text, digit, label.x, label.y, height, 255);
+        }
+
+    if (cache->software == 0)
+        GTX_Flush(text, renderer);
+}
+
+/********************************************//**
+ * @brief
+ * Brings the chunks up to date: everything on screen, then up to GMP_WARM_CHUNKS of the hidden
+ * maps' so switching to them finds them drawn. Leaves the renderer pointed at the window.
+ * @param cache struct MapCache*
+ * @param renderer SDL_Renderer*
+ * @param text struct GlyphAtlas*
+ * @param marks const Uint8*
+ * @param tag const Sint8*
+ * @param shown const Uint8* per runner, the dungeon on screen
+ * @return int
+ * chunks redrawn
+ ***********************************************/
+int GMP_Refresh(struct MapCache *cache, SDL_Renderer *renderer, struct GlyphAtlas *text,
+                const Uint8 *marks, const Sint8 *tag, const Uint8 *shown) {
+    int runners = cache->total_maps / GMP_TOTAL_MAPS;
+    int budget = GMP_WARM_CHUNKS;
+    int drawn = 0;
+
+    if (cache->scale == 0)
+        return 0;
+
+    for (int r = 0; r < runners; r++) {
+        int visible[2] = { r * GMP_TOTAL_MAPS, r * GMP_TOTAL_MAPS + shown[r] };
+
+        for (int v = 0; v < 2; v++)
+            for (int c = 0; c < GMP_TotalChunks(visible[v] % GMP_TOTAL_MAPS); c++)
+                if (GMP_ChunkDirty(cache, marks, tag, visible[v], c)) {
+                    GMP_DrawChunk(cache, renderer, text, marks, tag, visible[v], c);
+                    drawn++;
+                }
+    }
+
+    // Round robin over the rest, one pass at most
+    for (int i = 0; i < cache->total_maps && budget > 0; i++) {
+        int map = (cache->warm_next + i) % cache->total_maps;
+        int runner = map / GMP_TOTAL_MAPS;
+
+        if (map % GMP_TOTAL_MAPS == 0 || map % GMP_TOTAL_MAPS == shown[runner])
+            continue;
+
+        for (int c = 0; c < GMP_TotalChunks(map % GMP_TOTAL_MAPS) && budget > 0; c++)
+            if (GMP_ChunkDirty(cache, marks, tag, map, c)) {
+                GMP_DrawChunk(cache, renderer, text, marks, tag, map, c);
+                budget--;
+                drawn++;
+            }
+        if (budget > 0)
+            cache->warm_next = (map + 1) % cache->total_maps;
+    }
+
+    if (cache->software == 0) {
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    }
+    return drawn;
+}
+
+/********************************************//**
+ * @brief
+ * Puts the tab strip and the maps on screen over whatever is in the backbuffer (screen if
+ * software rendering)
+ * @param cache struct MapCache*
+ * @param renderer SDL_Renderer*
+ * @param screen struct Raster*
+ * @param text struct GlyphAtlas* for the tab numbers
+ * @param layout const struct Layout*
+ * @param at SDL_Point runner 0's panel, logical
+ * @param tile_w int
+ * @param shown const Uint8*
+ * @return void
+ ***********************************************/
+void GMP_Compose(struct MapCache *cache, SDL_Renderer *renderer, struct Raster *screen, struct GlyphAtlas *text,
+                 const struct Layout *layout, SDL_Point at, int tile_w, const Uint8 *shown) {
+    int runners = cache->total_maps / GMP_TOTAL_MAPS;
+    char digit[2] = { 0, 0 };
+
+    if (cache->scale == 0)
+        return;
+
+    for (int r = 0; r < runners; r++) {
+        int visible[2] = { 0, shown[r] };
+
+        for (int v = 0; v < 2; v++) {
+            int map = r * GMP_TOTAL_MAPS + visible[v];
+            const struct MapGrid *grid = GMP_Grid(visible[v]);
+
+            for (int c = 0; c < GMP_TotalChunks(visible[v]); c++) {
+                struct MapChunk *chunk = &cache->chunks[map * GMP_MAX_CHUNKS + c];
+                SDL_Rect cells = GMP_ChunkCells(visible[v], c);
+                SDL_Rect logical = {
+                        at.x + r * tile_w + grid->x + cells.x * grid->cell, at.y + grid->y + cells.y * grid->cell,
+                        GMP_CHUNK_CELLS * grid->cell, GMP_CHUNK_CELLS * grid->cell
+                };
+                SDL_Rect to = GLY_ToPixels(layout, &logical);
+                SDL_Rect frm = { 0, 0, chunk->pixels.w, chunk->pixels.h };
+
+                if (cache->software)
+                    GX_Blit(screen, &to, &chunk->pixels, &frm, 255);
+                else
+                    SDL_RenderCopy(renderer, chunk->texture, NULL, &to);
+            }
+        }
+
+        // Nine rects and digits, cheaper to draw than to cache
+        for (int d = 1; d < GMP_TOTAL_MAPS; d++) {
+            SDL_Rect logical = {
+                    at.x + r * tile_w + GMP_TABS.x + (d - 1) * GMP_TAB_W, at.y + GMP_TABS.y,
+                    GMP_TAB_W - 1, GMP_TABS.h
+            };
+            SDL_Rect tab = GLY_ToPixels(layout, &logical);
+            Uint32 color = (d == shown[r]) ? GMP_COLOR_TAB_SHOWN : GMP_COLOR_TAB;
+            int height = (GMP_TABS.h - 6) * layout->scale;
+
+            digit[0] = (char)('0' + d);
+            if (cache->software) {
+                GX_FillRect(screen, &tab, color);
+                GTX_DrawText(text, screen, digit, tab.x + (tab.w - GTX_MeasureText(text, digit, height)) / 2,
+                             tab.y + 3 * layout->scale, height, 255);
+                continue;
+            }
+
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+            SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+            SDL_RenderFillRect(renderer, &tab);
+            GTX_PushText(text, digit, tab.x + (tab.w - GTX_MeasureText(text, digit, height)) / 2,
+                         tab.y + 3 * layout->scale, height, 255);
+        }
+    }
+
+    if (cache->software == 0) {
+        GTX_Flush(text, renderer);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    }
+}
+
+void GMP_DestroyCache(struct MapCache *cache) {
+    if (cache->chunks != NULL)
+        for (int i = 0; i < cache->total_maps * GMP_MAX_CHUNKS; i++)
+            GMP_DestroyChunk(&cache->chunks[i]);
+    free(cache->chunks);
+    free(cache->drawn);
+    memset(cache, 0, sizeof(*cache));
+}
+
+#endif //ZELDATRACKER_GAMEMAP_H
@@ -24,4 +24,211 @@ int GM_PointCollides(int x, int y, int x2, int y2, int w, int h) {
 
     return GM_NO_COLLIDES;
 }
+
+const int GM_NO_HIT = -1;
+
+/*
+ * Uniform grid over a fixed set of rectangles (the sprite layout), built once and then queried
+ * per mouse event. Cells are stored CSR style: cell_start[c]..cell_start[c + 1] indexes into
+ * entries, so a lookup is one divide per axis plus a scan of whatever shares that cell.
+ */
+struct HitGrid {
+    int cell_w;
+    int cell_h;
+    int origin_x;
+    int origin_y;
+    int cols;
+    int rows;
+    int *cell_start;     // cols * rows + 1 offsets into entries
+    int *entries;        // rect index, grouped by cell
+    int total_entries;
+    int *rects;          // x, y, w, h, id per rect
+    int total_rects;
+    int capacity;
+};
+
+
+/********************************************//**
+ * @brief
+ * Sets up an empty grid, add rects with GM_HitGridAdd then call GM_HitGridBuild
+ * @param grid struct HitGrid*
+ * @param cell_w int
+ * @param cell_h int
+ * @param capacity int max number of rects
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int GM_InitHitGrid(struct HitGrid *grid, int cell_w, int cell_h, int capacity) {
+    grid->cell_w = cell_w;
+    grid->cell_h = cell_h;
+    grid->origin_x = 0;
+    grid->origin_y = 0;
+    grid->cols = 0;
+    grid->rows = 0;
+    grid->cell_start = NULL;
+    grid->entries = NULL;
+    grid->total_entries = 0;
+    grid->total_rects = 0;
+    grid->capacity = capacity;
+    grid->rects = malloc(sizeof(int) * 5 * capacity);
+
+    return (grid->rects == NULL) ? -1 : 0;
+}
+
+/********************************************//**
+ * @brief
+ * Queues a rect for the next GM_HitGridBuild. Same inclusive edges as GM_PointCollides.
+ * @param grid struct HitGrid*
+ * @param id int returned by GM_HitGridQuery on a hit
+ * @param x int
+ * @param y int
+ * @param w int
+ * @param h int
+ * @return void
+ ***********************************************/
+void GM_HitGridAdd(struct HitGrid *grid, int id, int x, int y, int w, int h) {
+    int *rect;
+
+    if (grid->total_rects == grid->capacity)
+        return;
+
+    rect = &grid->rects[grid->total_rects * 5];
+    rect[0] = x;
+    rect[1] = y;
+    rect[2] = w;
+    rect[3] = h;
+    rect[4] = id;
+    grid->total_rects++;
+}
+
+/********************************************//**
+ * @brief
+ * Buckets every queued rect into the cells it touches. Call again after changing the layout.
+ * @param grid struct HitGrid*
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int GM_HitGridBuild(struct HitGrid *grid) {
+    int min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+    int c0, c1, r0, r1;
+    int *rect;
+    int *fill = NULL;
+
+    free(grid->cell_start);
+    free(grid->entries);
+    grid->cell_start = NULL;
+    grid->entries = NULL;
+    grid->total_entries = 0;
+    grid->cols = 0;
+    grid->rows = 0;
+
+    if (grid->total_rects == 0)
+        return 0;
+
+    for (int i = 0; i < grid->total_rects; i++) {
+        rect = &grid->rects[i * 5];
+        if (i == 0 || rect[0] < min_x)
+            min_x = rect[0];
+        if (i == 0 || rect[1] < min_y)
+            min_y = rect[1];
+        if (i == 0 || rect[0] + rect[2] > max_x)
+            max_x = rect[0] + rect[2];
+        if (i == 0 || rect[1] + rect[3] > max_y)
+            max_y = rect[1] + rect[3];
+    }
+
+    grid->origin_x = min_x;
+    grid->origin_y = min_y;
+    grid->cols = (max_x - min_x) / grid->cell_w + 1;
+    grid->rows = (max_y - min_y) / grid->cell_h + 1;
+    grid->cell_start = calloc((size_t)grid->cols * grid->rows + 1, sizeof(int));
+    if (grid->cell_start == NULL)
+        return -1;
+
+    // Pass one counts entries per cell, pass two drops them into place
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < grid->total_rects; i++) {
+            rect = &grid->rects[i * 5];
+            c0 = (rect[0] - min_x) / grid->cell_w;
+            c1 = (rect[0] + rect[2] - min_x) / grid->cell_w;
+            r0 = (rect[1] - min_y) / grid->cell_h;
+            r1 = (rect[1] + rect[3] - min_y) / grid->cell_h;
+
+            for (int r = r0; r <= r1; r++)
+                for (int c = c0; c <= c1; c++) {
+                    if (pass == 0)
+                        grid->cell_start[r * grid->cols + c + 1]++;
+                    else
+                        grid->entries[fill[r * grid->cols + c]++] = i;
+                }
+        }
+
+        if (pass == 0) {
+            for (int cell = 0; cell < grid->cols * grid->rows; cell++)
+                grid->cell_start[cell + 1] += grid->cell_start[cell];
+
+            grid->total_entries = grid->cell_start[grid->cols * grid->rows];
+            grid->entries = malloc(sizeof(int) * (grid->total_entries + 1));
+            fill = malloc(sizeof(int) * grid->cols * grid->rows);
+            if (grid->entries == NULL || fill == NULL) {
+                free(fill);
+                return -1;
+            }
+            memcpy(fill, grid->cell_start, sizeof(int) * grid->cols * grid->rows);
+        }
+    }
+
+    free(fill);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Finds the rect under x/y
+ * @param grid struct HitGrid*
+ * @param x int
+ * @param y int
+ * @return int
+ * id of the first rect containing the point, GM_NO_HIT if there isn't one
+ ***********************************************/
+int GM_HitGridQuery(const struct HitGrid *grid, int x, int y) {
+    int col, row, cell;
+    const int *rect;
+
+    if (x < grid->origin_x || y < grid->origin_y || grid->cell_start == NULL)
+        return GM_NO_HIT;
+
+    col = (x - grid->origin_x) / grid->cell_w;
+    row = (y - grid->origin_y) / grid->cell_h;
+    if (col >= grid->cols || row >= grid->rows)
+        return GM_NO_HIT;
+
+    cell = row * grid->cols + col;
+    for (int e = grid->cell_start[cell]; e < grid->cell_start[cell + 1]; e++) {
+        rect = &grid->rects[grid->entries[e] * 5];
+        if (GM_PointCollides(x, y, rect[0], rect[1], rect[2], rect[3]) == GM_COLLIDES)
+            return rect[4];
+    }
+
+    return GM_NO_HIT;
+}
+
+/********************************************//**
+ * @brief
+ * Drops every rect, the grid is empty until the next GM_HitGridAdd/GM_HitGridBuild
+ * @param grid struct HitGrid*
+ * @return void
+ ***********************************************/
+void GM_HitGridClear(struct HitGrid *grid) {
+    grid->total_rects = 0;
+}
+
+void GM_DestroyHitGrid(struct HitGrid *grid) {
+    free(grid->cell_start);
+    free(grid->entries);
+    free(grid->rects);
+    grid->cell_start = NULL;
+    grid->entries = NULL;
+    grid->rects = NULL;
+}
 #endif // GAME_MATH_H
@@ -0,0 +1,183 @@
+#ifndef ZELDATRACKER_GAMEPROFILER_H
+#define ZELDATRACKER_GAMEPROFILER_H
+
+/*
+ * Where a frame's time goes. Each phase of the loop gets a fixed-bucket histogram (percentiles
+ * without sorting or allocating) and the last GP_TOTAL_RECORDS frames are kept one row apiece
+ * for GP_WriteCsv. Nothing here is thread safe: one side owns the Profiler and anything measured
+ * elsewhere is handed to it (the tracker ships the state side's numbers in its snapshots).
+ *
+ * When profiling is off callers skip the counter reads entirely, all that's left is a branch.
+ */
+
+// Phases, the first GP_STATE_PHASES run on the state side
+#define GP_EVENTS 0             // draining the event queue
+#define GP_UPDATE 1             // ZT_Update
+#define GP_PUBLISH 2            // copying the snapshot out
+#define GP_STATE_PHASES 3
+#define GP_LAYERS 3             // redrawing changed cells into the cached layers
+#define GP_COMPOSE 4            // stacking the layers, link and the cursor
+#define GP_PRESENT 5            // SDL_RenderPresent
+#define GP_FRAME 6              // present to present
+#define GP_CLICK_TO_PHOTON 7    // mouse button down to the present showing the toggle
+#define GP_TOTAL_PHASES 8
+
+#define GP_BUCKETS 256
+const double GP_BUCKET_MS = 0.125;      // 0 - 32ms, anything slower lands in the last bucket
+#define GP_TOTAL_RECORDS 1024
+
+const char *GP_PHASE_NAMES[GP_TOTAL_PHASES] = {
+        "events", "update", "publish", "layers", "compose", "present", "frame", "click"
+};
+
+struct Histogram {
+    Uint32 buckets[GP_BUCKETS];
+    Uint32 total;
+    float max;
+};
+
+struct ProfileRecord {
+    Uint32 sequence;
+    float ms[GP_TOTAL_PHASES];  // negative if the phase didn't happen that frame
+};
+
+struct Profiler {
+    Uint64 frequency;
+    struct Histogram phases[GP_TOTAL_PHASES];
+    struct ProfileRecord current;
+    struct ProfileRecord records[GP_TOTAL_RECORDS];
+    Uint32 total_records;       // ever recorded, the ring holds the newest GP_TOTAL_RECORDS
+};
+
+
+void GP_ClearRecord(struct ProfileRecord *record) {
+    for (int i = 0; i < GP_TOTAL_PHASES; i++)
+        record->ms[i] = -1;
+}
+
+void GP_InitProfiler(struct Profiler *profiler) {
+    memset(profiler, 0, sizeof(*profiler));
+    profiler->frequency = SDL_GetPerformanceFrequency();
+    GP_ClearRecord(&profiler->current);
+}
+
+/********************************************//**
+ * @brief
+ * ms between two performance counter readings
+ * @param profiler const struct Profiler*
+ * @param from Uint64
+ * @param to Uint64
+ * @return float
+ ***********************************************/
+float GP_Ms(const struct Profiler *profiler, Uint64 from, Uint64 to) {
+    return (float)((double)(to - from) * 1000.0 / (double)profiler->frequency);
+}
+
+/********************************************//**
+ * @brief
+ * Adds a sample to a phase's histogram and to the frame being recorded
+ * @param profiler struct Profiler*
+ * @param phase int GP_*
+ * @param ms float
+ * @return void
+ ***********************************************/
+void GP_Record(struct Profiler *profiler, int phase, float ms) {
+    struct Histogram *histogram = &profiler->phases[phase];
+    int bucket = (int)(ms / GP_BUCKET_MS);
+
+    if (ms < 0)
+        return;
+    if (bucket >= GP_BUCKETS)
+        bucket = GP_BUCKETS - 1;
+
+    histogram->buckets[bucket]++;
+    histogram->total++;
+    if (ms > histogram->max)
+        histogram->max = ms;
+
+    profiler->current.ms[phase] = ms;
+}
+
+/********************************************//**
+ * @brief
+ * Files the frame being recorded away under sequence and starts the next
+ * @param profiler struct Profiler*
+ * @param sequence Uint32
+ * @return void
+ ***********************************************/
+void GP_EndFrame(struct Profiler *profiler, Uint32 sequence) {
+    profiler->current.sequence = sequence;
+    profiler->records[profiler->total_records % GP_TOTAL_RECORDS] = profiler->current;
+    profiler->total_records++;
+    GP_ClearRecord(&profiler->current);
+}
+
+/********************************************//**
+ * @brief
+ * Upper edge of the bucket holding the given percentile, so never better than the truth
+ * @param profiler const struct Profiler*
+ * @param phase int GP_*
+ * @param percentile double 0 - 100
+ * @return float
+ * ms, 0 if the phase has no samples
+ ***********************************************/
+float GP_Percentile(const struct Profiler *profiler, int phase, double percentile) {
+    const struct Histogram *histogram = &profiler->phases[phase];
+    Uint32 wanted = (Uint32)(histogram->total * percentile / 100.0 + 0.5);
+    Uint32 seen = 0;
+
+    if (histogram->total == 0)
+        return 0;
+    if (wanted < 1)
+        wanted = 1;
+
+    for (int i = 0; i < GP_BUCKETS - 1; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= wanted)
+            return (float)((i + 1) * GP_BUCKET_MS);
+    }
+
+    return histogram->max;
+}
+
+/********************************************//**
+ * @brief
+ * Writes the recorded frames, oldest first, one row per frame and one column per phase.
+ * Phases that didn't happen in a frame are left empty.
+ * @param profiler const struct Profiler*
+ * @param path const char*
+ * @return int
+ * 0 on success, -1 if the file couldn't be written
+ ***********************************************/
+int GP_WriteCsv(const struct Profiler *profiler, const char *path) {
+    Uint32 first = (profiler->total_records > GP_TOTAL_RECORDS)
+                   ? profiler->total_records - GP_TOTAL_RECORDS : 0;
+    FILE *out = fopen(path, "w");
+
+    if (out == NULL) {
+        DEBUG_ERR("Unable to write the profile");
+        return -1;
+    }
+
+    fprintf(out, "sequence");
+    for (int p = 0; p < GP_TOTAL_PHASES; p++)
+        fprintf(out, ",%s_ms", GP_PHASE_NAMES[p]);
+    fprintf(out, "\n");
+
+    for (Uint32 r = first; r < profiler->total_records; r++) {
+        const struct ProfileRecord *record = &profiler->records[r % GP_TOTAL_RECORDS];
+
+        fprintf(out, "%u", (unsigned)record->sequence);
+        for (int p = 0; p < GP_TOTAL_PHASES; p++) {
+            if (record->ms[p] >= 0)
+                fprintf(out, ",%.4f", record->ms[p]);
+            else
+                fprintf(out, ",");
+        }
+        fprintf(out, "\n");
+    }
+
+    return (fclose(out) == 0) ? 0 : -1;
+}
+
+#endif //ZELDATRACKER_GAMEPROFILER_H
@@ -0,0 +1,459 @@
+#ifndef ZELDATRACKER_GAMERAM_H
+#define ZELDATRACKER_GAMERAM_H
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Auto-tracking from the emulator's RAM. An emulator script dumps the NES's 2 KB of work RAM
+ * into a file (or a shared memory object, "shm:<name>") every frame, we map it and look at
+ * the handful of bytes that say which items Link has. ram.cfg, next to sprites.cfg, says which
+ * ones, one rule per line:
+ *
+ *     <name> <address> <test>
+ *
+ *     bow         0x065A  >=1      on while the byte is at least 1
+ *     silverarrow 0x0659  =2       on while it's exactly 2
+ *     triforce_3  0x0671  &0x04    on while any of those bits are set
+ *
+ * The name is a sprites.cfg #name or triforce_1 to triforce_9, anything else is ignored.
+ * Numbers are decimal or 0x hex, blank lines and lines starting with '#' are skipped.
+ *
+ * The watched bytes are grouped by the 8 byte word they live in and only those words are read,
+ * masked down to the bits some rule cares about and compared whole against the last poll. A
+ * rule is only looked at when its word changed, and only reported when its answer changed, so
+ * a click by hand sticks until the game says otherwise. When the source (re)appears, whatever
+ * the rules say is on is reported, nothing is switched off.
+ *
+ * The writer has to update the file in place (seek and write, not truncate and rewrite), we
+ * check its size every poll but a truncation between that and the read still faults.
+ */
+
+#define GRM_RAM_SIZE 0x800      // NES work RAM, $0000-$07FF
+
+const int GRM_TEST_BITS = 0;        // &mask
+const int GRM_TEST_EQUAL = 1;       // =value
+const int GRM_TEST_AT_LEAST = 2;    // >=value
+const Uint32 GRM_POLL_MS = 16;      // ~60 Hz, the emulator doesn't write any faster
+const Uint32 GRM_RETRY_MS = 1000;   // how often a missing source is looked for again
+
+struct RamRule {
+    char name[GCF_NAME_LENGTH];
+    Uint16 address;
+    Uint8 test;
+    Uint8 operand;          // the mask or the value
+    Sint8 on;               // the answer at the last poll, -1 before the first
+    int slot;               // tracker slot it drives, -1 for none (the caller binds these)
+};
+
+struct RamWatch {
+    struct RamRule *rules;  // sorted by address
+    int total_rules;
+    int capacity;
+    int *changed;           // rules whose answer changed at the last poll
+
+    // One per 8 byte word holding a watched byte, rules [first_rule[w], first_rule[w + 1])
+    // live in word w
+    Uint16 *word_at;        // address of the word
+    Uint64 *word_mask;      // bits any rule looks at, in memory order
+    Uint64 *previous;       // masked word at the last poll
+    int *first_rule;
+    int total_words;
+    size_t needed;          // the source has to be at least this big
+
+    char source[256];       // file path, or "shm:<name>"
+    const Uint8 *ram;
+    size_t ram_size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE map;
+#else
+    int fd;
+#endif
+    int primed;             // the words have been read once since the source appeared
+    Uint32 poll_at;         // SDL_GetTicks of the next poll/retry
+};
+
+
+/********************************************//**
+ * @brief
+ * Parses a decimal or 0x hex number, skipping leading whitespace
+ * @param at const char** moved past the number
+ * @param value long*
+ * @return int
+ * 0 on success, -1 if there's no number
+ ***********************************************/
+int GRM_ParseNumber(const char **at, long *value) {
+    char *end;
+
+    *value = strtol(*at, &end, 0);
+    if (end == *at)
+        return -1;
+    *at = end;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Parses one ram.cfg line into a rule
+ * @param line const char*
+ * @param rule struct RamRule*
+ * @return const char*
+ * NULL on success, what's wrong with it otherwise
+ ***********************************************/
+const char *GRM_ParseRule(const char *line, struct RamRule *rule) {
+    const char *at = line;
+    int length = 0;
+    long address, operand;
+
+    memset(rule, 0, sizeof(*rule));
+    rule->on = -1;
+    rule->slot = -1;
+
+    while (*at == ' ' || *at == '\t')
+        at++;
+    while (*at != '\0' && *at != ' ' && *at != '\t') {
+        if (length < GCF_NAME_LENGTH - 1)
+            rule->name[length++] = *at;
+        at++;
+    }
+
+    if (GRM_ParseNumber(&at, &address) != 0)
+        return "expected an address after the name";
+    if (address < 0 || address >= GRM_RAM_SIZE)
+        return "address outside of the NES's RAM";
+
+    while (*at == ' ' || *at == '\t')
+        at++;
+    if (at[0] == '&') {
+        rule->test = (Uint8)GRM_TEST_BITS;
+        at += 1;
+    } else if (at[0] == '>' && at[1] == '=') {
+        rule->test = (Uint8)GRM_TEST_AT_LEAST;
+        at += 2;
+    } else if (at[0] == '=') {
+        rule->test = (Uint8)GRM_TEST_EQUAL;
+        at += 1;
+    } else {
+        return "expected &mask, =value or >=value after the address";
+    }
+
+    if (GRM_ParseNumber(&at, &operand) != 0 || operand < 0 || operand > 0xFF)
+        return "expected a byte after the test";
+
+    while (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n')
+        at++;
+    if (*at != '\0' && *at != '#')
+        return "unexpected text after the test";
+
+    rule->address = (Uint16)address;
+    rule->operand = (Uint8)operand;
+    return NULL;
+}
+
+int GRM_CompareRules(const void *a, const void *b) {
+    return (int)((const struct RamRule *)a)->address - (int)((const struct RamRule *)b)->address;
+}
+
+/********************************************//**
+ * @brief
+ * Groups the (sorted) rules into the words they live in
+ * @param watch struct RamWatch*
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int GRM_BuildWords(struct RamWatch *watch) {
+    int count = watch->total_rules;
+
+    watch->word_at = malloc(sizeof(Uint16) * (count + 1));
+    watch->word_mask = malloc(sizeof(Uint64) * (count + 1));
+    watch->previous = malloc(sizeof(Uint64) * (count + 1));
+    watch->first_rule = malloc(sizeof(int) * (count + 1));
+    watch->changed = malloc(sizeof(int) * (count + 1));
+    if (watch->word_at == NULL || watch->word_mask == NULL || watch->previous == NULL
+        || watch->first_rule == NULL || watch->changed == NULL)
+        return -1;
+
+    watch->total_words = 0;
+    for (int i = 0; i < count; i++) {
+        const struct RamRule *rule = &watch->rules[i];
+        Uint16 word = (Uint16)(rule->address & ~7);
+        Uint8 bytes[8];
+        Uint64 mask;
+        int w = watch->total_words - 1;
+
+        if (w < 0 || watch->word_at[w] != word) {
+            w = watch->total_words++;
+            watch->word_at[w] = word;
+            watch->word_mask[w] = 0;
+            watch->first_rule[w] = i;
+        }
+
+        // Built through memory so it lines up with the words whatever the byte order
+        memset(bytes, 0, sizeof(bytes));
+        bytes[rule->address & 7] = (rule->test == GRM_TEST_BITS) ? rule->operand : 0xFF;
+        memcpy(&mask, bytes, sizeof(mask));
+        watch->word_mask[w] |= mask;
+    }
+    watch->first_rule[watch->total_words] = count;
+    watch->needed = (watch->total_words > 0) ? (size_t)watch->word_at[watch->total_words - 1] + 8 : 0;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Loads ram.cfg and gets ready to read source. The source doesn't have to exist yet, it's
+ * looked for again every GRM_RETRY_MS until it does.
+ * @param watch struct RamWatch*
+ * @param path const char* rules, see the top of this file
+ * @param source const char* RAM dump file, or "shm:<name>" for a shared memory object
+ * @return int
+ * 0 on success, -1 on failure (reported)
+ ***********************************************/
+int GRM_InitWatch(struct RamWatch *watch, const char *path, const char *source) {
+    char line[256];
+    char message[320];
+    const char *error;
+    int number = 0;
+    FILE *file;
+
+    memset(watch, 0, sizeof(*watch));
+#ifdef _WIN32
+    watch->file = INVALID_HANDLE_VALUE;
+#else
+    watch->fd = -1;
+#endif
+    snprintf(watch->source, sizeof(watch->source), "%s", source);
+
+    file = fopen(path, "r");
+    if (file == NULL) {
+        snprintf(message, sizeof(message), "%s: unable to open the file", path);
+        DEBUG_ERR(message);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        const char *at = line;
+
+        number++;
+        while (*at == ' ' || *at == '\t')
+            at++;
+        if (*at == '#' || *at == '\r' || *at == '\n' || *at == '\0')
+            continue;
+
+        if (watch->total_rules == watch->capacity) {
+            int capacity = (watch->capacity > 0) ? watch->capacity * 2 : 32;
+            struct RamRule *grown = realloc(watch->rules, sizeof(struct RamRule) * capacity);
+
+            if (grown == NULL) {
+                fclose(file);
+                DEBUG_ERR("Out of memory loading the RAM rules");
+                return -1;
+            }
+            watch->rules = grown;
+            watch->capacity = capacity;
+        }
+
+        error = GRM_ParseRule(at, &watch->rules[watch->total_rules]);
+        if (error != NULL) {
+            fclose(file);
+            snprintf(message, sizeof(message), "%s:%d: %s", path, number, error);
+            DEBUG_ERR(message);
+            return -1;
+        }
+        watch->total_rules++;
+    }
+    fclose(file);
+
+    // Rules on the same byte can end up in any order, they don't depend on each other
+    qsort(watch->rules, watch->total_rules, sizeof(struct RamRule), GRM_CompareRules);
+    if (GRM_BuildWords(watch) != 0) {
+        DEBUG_ERR("Out of memory loading the RAM rules");
+        return -1;
+    }
+    return 0;
+}
+
+void GRM_CloseSource(struct RamWatch *watch) {
+#ifdef _WIN32
+    if (watch->ram != NULL)
+        UnmapViewOfFile(watch->ram);
+    if (watch->map != NULL)
+        CloseHandle(watch->map);
+    if (watch->file != INVALID_HANDLE_VALUE)
+        CloseHandle(watch->file);
+    watch->map = NULL;
+    watch->file = INVALID_HANDLE_VALUE;
+#else
+    if (watch->ram != NULL)
+        munmap((void *)watch->ram, watch->ram_size);
+    if (watch->fd != -1)
+        close(watch->fd);
+    watch->fd = -1;
+#endif
+    watch->ram = NULL;
+    watch->ram_size = 0;
+    watch->primed = 0;
+}
+
+/********************************************//**
+ * @brief
+ * Maps the source, if it's there and big enough
+ * @param watch struct RamWatch*
+ * @return int
+ * 0 on success, -1 if it isn't (yet)
+ ***********************************************/
+int GRM_OpenSource(struct RamWatch *watch) {
+    const char *shm = (strncmp(watch->source, "shm:", 4) == 0) ? watch->source + 4 : NULL;
+#ifdef _WIN32
+    MEMORY_BASIC_INFORMATION info;
+
+    if (shm != NULL) {
+        watch->map = OpenFileMappingA(FILE_MAP_READ, FALSE, shm);
+    } else {
+        watch->file = CreateFileA(watch->source, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (watch->file == INVALID_HANDLE_VALUE)
+            return -1;
+        watch->map = CreateFileMappingA(watch->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    if (watch->map == NULL) {
+        GRM_CloseSource(watch);
+        return -1;
+    }
+
+    watch->ram = MapViewOfFile(watch->map, FILE_MAP_READ, 0, 0, 0);
+    if (watch->ram == NULL || VirtualQuery(watch->ram, &info, sizeof(info)) == 0) {
+        GRM_CloseSource(watch);
+        return -1;
+    }
+    watch->ram_size = info.RegionSize;
+#else
+    struct stat info;
+
+    watch->fd = (shm != NULL) ? shm_open(shm, O_RDONLY, 0) : open(watch->source, O_RDONLY);
+    if (watch->fd == -1)
+        return -1;
+
+    if (fstat(watch->fd, &info) != 0 || (size_t)info.st_size < watch->needed || info.st_size == 0) {
+        GRM_CloseSource(watch);
+        return -1;
+    }
+
+    watch->ram = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, watch->fd, 0);
+    if (watch->ram == MAP_FAILED) {
+        watch->ram = NULL;
+        GRM_CloseSource(watch);
+        return -1;
+    }
+    watch->ram_size = (size_t)info.st_size;
+#endif
+
+    if (watch->ram_size < watch->needed) {
+        GRM_CloseSource(watch);
+        return -1;
+    }
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Whether the source shrank out from under us (the emulator restarted, say)
+ * @param watch struct RamWatch*
+ * @return int
+ * 1 if it's still big enough to read, 0 if not
+ ***********************************************/
+int GRM_SourceIntact(const struct RamWatch *watch) {
+#ifdef _WIN32
+    return 1;   // a mapped file can't be truncated on Windows
+#else
+    struct stat info;
+
+    return fstat(watch->fd, &info) == 0 && (size_t)info.st_size >= watch->needed;
+#endif
+}
+
+/********************************************//**
+ * @brief
+ * Reads the watched words and works out which rules changed their answer. Does nothing until
+ * GRM_POLL_MS after the last poll.
+ * @param watch struct RamWatch*
+ * @return int
+ * how many rules changed, rules[changed[i]].on is the new answer
+ ***********************************************/
+int GRM_Poll(struct RamWatch *watch) {
+    Uint32 now = SDL_GetTicks();
+    int total_changed = 0;
+
+    if ((Sint32)(now - watch->poll_at) < 0 || watch->total_words == 0)
+        return 0;
+    watch->poll_at = now + GRM_POLL_MS;
+
+    if (watch->ram != NULL && GRM_SourceIntact(watch) == 0) {
+        DEBUG_LOG("The emulator's RAM went away, waiting for it to come back");
+        GRM_CloseSource(watch);
+    }
+    if (watch->ram == NULL) {
+        if (GRM_OpenSource(watch) != 0) {
+            watch->poll_at = now + GRM_RETRY_MS;
+            return 0;
+        }
+        DEBUG_LOG("Auto-tracking from the emulator's RAM");
+    }
+
+    for (int w = 0; w < watch->total_words; w++) {
+        Uint64 word;
+        Uint8 bytes[8];
+
+        memcpy(&word, watch->ram + watch->word_at[w], sizeof(word));
+        word &= watch->word_mask[w];
+        if (watch->primed && word == watch->previous[w])
+            continue;
+        watch->previous[w] = word;
+        memcpy(bytes, &word, sizeof(bytes));
+
+        for (int i = watch->first_rule[w]; i < watch->first_rule[w + 1]; i++) {
+            struct RamRule *rule = &watch->rules[i];
+            Uint8 value = bytes[rule->address & 7];
+            Sint8 on;
+
+            if (rule->test == GRM_TEST_BITS)
+                on = (value & rule->operand) != 0;
+            else if (rule->test == GRM_TEST_EQUAL)
+                on = value == rule->operand;
+            else
+                on = value >= rule->operand;
+
+            // A fresh source only adds, it hasn't seen the run the clicks so far came from
+            if (on == rule->on || (watch->primed == 0 && on == 0)) {
+                rule->on = on;
+                continue;
+            }
+            rule->on = on;
+            watch->changed[total_changed++] = i;
+        }
+    }
+
+    watch->primed = 1;
+    return total_changed;
+}
+
+void GRM_DestroyWatch(struct RamWatch *watch) {
+    GRM_CloseSource(watch);
+    free(watch->rules);
+    free(watch->word_at);
+    free(watch->word_mask);
+    free(watch->previous);
+    free(watch->first_rule);
+    free(watch->changed);
+    memset(watch, 0, sizeof(*watch));
+}
+
+#endif //ZELDATRACKER_GAMERAM_H
@@ -0,0 +1,190 @@
+#ifndef ZELDATRACKER_GAMERING_H
+#define ZELDATRACKER_GAMERING_H
+
+/*
+ * Hands frames from the state thread to the render thread. Each FrameSnapshot is everything
+ * that changes between frames, copied out of the tracker, and it's never touched again once
+ * published. Single producer, single consumer, no locks: head is only stored by the producer
+ * and tail only by the consumer. The consumer always skips ahead to the newest snapshot, so a
+ * slow present costs frames, never input.
+ */
+
+#define GR_RING_SLOTS 4     // power of two
+
+struct FrameSnapshot {
+    Uint32 sequence;
+    int total_slots;
+    Uint8 *state;           // per slot, same numbering as the sprite store
+    Sint8 *tag;
+    int total_cells;        // map cells, 0 without the map panel (see GameMap.h)
+    Uint8 *map_marks;
+    Sint8 *map_tag;
+    Uint8 map_shown[GMP_MAX_RUNNERS];
+    SDL_Rect link_walk_frm;
+    SDL_Rect link_walk_to;
+    SDL_Rect cursor_draw_at;
+    Uint32 layers_lost;     // changes whenever the renderer lost its targets, redraw every layer
+    struct Layout layout;   // where on the window everything goes, see GameLayout.h
+
+    // Profiling, see GameProfiler.h. Nothing below is filled in unless profiling is set
+    int profiling;
+    float state_ms[GP_STATE_PHASES];
+    Uint64 clicked_at;      // counter at the oldest click this frame shows, 0 for none
+    Uint32 dumps_requested; // changes whenever a CSV dump is asked for
+};
+
+struct SnapshotRing {
+    struct FrameSnapshot slots[GR_RING_SLOTS];
+    Uint8 *storage;
+    SDL_atomic_t head;      // snapshots published so far
+    SDL_atomic_t tail;      // snapshots released so far
+    SDL_sem *published;     // posted once per publish so the consumer can sleep
+};
+
+
+/********************************************//**
+ * @brief
+ * Allocates every slot up front, publishing never allocates
+ * @param ring struct SnapshotRing*
+ * @param total_slots int sprites per snapshot
+ * @param total_cells int map cells per snapshot
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GR_InitRing(struct SnapshotRing *ring, int total_slots, int total_cells) {
+    size_t per_slot = (size_t)(total_slots + total_cells) * (sizeof(Uint8) + sizeof(Sint8));
+
+    memset(ring, 0, sizeof(*ring));
+    ring->storage = calloc(GR_RING_SLOTS, per_slot);
+    ring->published = SDL_CreateSemaphore(0);
+    if (ring->storage == NULL || ring->published == NULL) {
+        DEBUG_ERR("Unable to set up the snapshot ring");
+        return -1;
+    }
+
+    for (int i = 0; i < GR_RING_SLOTS; i++) {
+        ring->slots[i].total_slots = total_slots;
+        ring->slots[i].state = ring->storage + i * per_slot;
+        ring->slots[i].tag = (Sint8 *)(ring->slots[i].state + total_slots);
+        ring->slots[i].total_cells = total_cells;
+        ring->slots[i].map_marks = ring->slots[i].state + 2 * total_slots;
+        ring->slots[i].map_tag = (Sint8 *)(ring->slots[i].map_marks + total_cells);
+    }
+
+    SDL_AtomicSet(&ring->head, 0);
+    SDL_AtomicSet(&ring->tail, 0);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Producer: the slot to fill in next
+ * @param ring struct SnapshotRing*
+ * @return struct FrameSnapshot*
+ * NULL if the consumer hasn't freed a slot yet, try again next frame
+ ***********************************************/
+struct FrameSnapshot *GR_BeginWrite(struct SnapshotRing *ring) {
+    int head = SDL_AtomicGet(&ring->head);
+
+    if (head - SDL_AtomicGet(&ring->tail) == GR_RING_SLOTS)
+        return NULL;
+
+    return &ring->slots[head & (GR_RING_SLOTS - 1)];
+}
+
+/********************************************//**
+ * @brief
+ * Producer: hands the slot from GR_BeginWrite over to the consumer
+ * @param ring struct SnapshotRing*
+ * @return void
+ ***********************************************/
+void GR_Publish(struct SnapshotRing *ring) {
+    int head = SDL_AtomicGet(&ring->head);
+
+    ring->slots[head & (GR_RING_SLOTS - 1)].sequence = (Uint32)head;
+    // The snapshot's contents have to land before the new head does
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->head, head + 1);
+    SDL_SemPost(ring->published);
+}
+
+/********************************************//**
+ * @brief
+ * Consumer: sleeps until something is published or timeout_ms runs out
+ * @param ring struct SnapshotRing*
+ * @param timeout_ms Uint32
+ * @return void
+ ***********************************************/
+void GR_Wait(struct SnapshotRing *ring, Uint32 timeout_ms) {
+    SDL_SemWaitTimeout(ring->published, timeout_ms);
+}
+
+/********************************************//**
+ * @brief
+ * Consumer: drops everything but the newest snapshot and returns that one, it stays valid
+ * until GR_Release
+ * @param ring struct SnapshotRing*
+ * @param skipped int* out, how many older snapshots were dropped (may be NULL)
+ * @return const struct FrameSnapshot*
+ * NULL if nothing new was published
+ ***********************************************/
+const struct FrameSnapshot *GR_AcquireLatest(struct SnapshotRing *ring, int *skipped) {
+    int head = SDL_AtomicGet(&ring->head);
+    int tail = SDL_AtomicGet(&ring->tail);
+
+    if (skipped != NULL)
+        *skipped = 0;
+    if (head == tail)
+        return NULL;
+
+    SDL_MemoryBarrierAcquire();
+    if (head - tail > 1) {
+        if (skipped != NULL)
+            *skipped = head - tail - 1;
+        SDL_AtomicSet(&ring->tail, head - 1);
+    }
+
+    return &ring->slots[(head - 1) & (GR_RING_SLOTS - 1)];
+}
+
+/********************************************//**
+ * @brief
+ * Consumer: done with the snapshot from GR_AcquireLatest, the producer may reuse it
+ * @param ring struct SnapshotRing*
+ * @return void
+ ***********************************************/
+void GR_Release(struct SnapshotRing *ring) {
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&ring->tail, 1);
+}
+
+/********************************************//**
+ * @brief
+ * Wakes a consumer sleeping in GR_Wait without publishing anything (shutdown)
+ * @param ring struct SnapshotRing*
+ * @return void
+ ***********************************************/
+void GR_Wake(struct SnapshotRing *ring) {
+    SDL_SemPost(ring->published);
+}
+
+/********************************************//**
+ * @brief
+ * Throws away everything published and not yet acquired (the tracker's layout changed under
+ * it). Only safe while the consumer is parked outside the ring.
+ * @param ring struct SnapshotRing*
+ * @return void
+ ***********************************************/
+void GR_Drop(struct SnapshotRing *ring) {
+    SDL_AtomicSet(&ring->tail, SDL_AtomicGet(&ring->head));
+}
+
+void GR_DestroyRing(struct SnapshotRing *ring) {
+    if (ring->published != NULL)
+        SDL_DestroySemaphore(ring->published);
+    free(ring->storage);
+    ring->published = NULL;
+    ring->storage = NULL;
+}
+
+#endif //ZELDATRACKER_GAMERING_H
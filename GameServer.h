@@ -0,0 +1,564 @@
+#ifndef ZELDATRACKER_GAMESERVER_H
+#define ZELDATRACKER_GAMESERVER_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET GS_Socket;
+#define GS_NO_SOCKET INVALID_SOCKET
+#define GS_CloseSocket closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+typedef int GS_Socket;
+#define GS_NO_SOCKET (-1)
+#define GS_CloseSocket close
+#endif
+
+// A client hanging up with output pending mustn't SIGPIPE the tracker, send just fails instead.
+// Linux takes it per send, Apple per socket (SO_NOSIGPIPE in GS_Accept), Windows never signals.
+#ifdef MSG_NOSIGNAL
+#define GS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define GS_SEND_FLAGS 0
+#endif
+
+/*
+ * Serves the tracker's state to overlays over TCP on 127.0.0.1 only. Every message is
+ *
+ *     Uint32 length (of what follows), Uint8 type, payload       all integers little endian
+ *
+ *     GS_MSG_FULL     Uint32 total_slots, then per slot: Uint8 state, Sint8 tag, Uint8 name
+ *                     length, the name (no terminator). Sent on connect, after a resync and
+ *                     after a delta couldn't be sent.
+ *     GS_MSG_DELTA    Uint32 count, then per change: Uint32 slot, Uint8 state, Sint8 tag
+ *
+ * state is SPRITE_STATE_ON | SPRITE_STATE_DISABLED bits, tag is the dungeon (-1 for none).
+ * Clients never need to send anything, whatever they do send is read and dropped.
+ *
+ * The state side pushes changes into a lock-free queue and never touches a socket. The server
+ * thread keeps its own copy of the state, turns each tick's changes into one GS_MSG_DELTA for
+ * everybody and sends from per-client buffers, so a stalled client only ever stalls itself (and
+ * gets dropped once it's GS_CLIENT_BACKLOG behind).
+ */
+
+#define GS_QUEUE_SIZE 1024      // power of two
+#define GS_MAX_CLIENTS 64
+#define GS_MSG_FULL 1
+#define GS_MSG_DELTA 2
+
+const Uint32 GS_TICK_MS = 10;                   // longest a change waits before going out
+const size_t GS_CLIENT_BACKLOG = 256 * 1024;    // unsent bytes before a client is dropped
+const int GS_NAME_LENGTH = 32;
+
+struct StateDelta {
+    Uint32 slot;
+    Uint8 state;
+    Sint8 tag;
+};
+
+struct ServerClient {
+    GS_Socket socket;
+    Uint8 *out;             // [sent, length) still has to go out
+    size_t length;
+    size_t sent;
+    size_t capacity;
+};
+
+struct StateServer {
+    int total_slots;
+    Uint8 state_mask;       // state bits clients get to see
+    GS_Socket listener;
+    struct ServerClient clients[GS_MAX_CLIENTS];
+    int total_clients;
+
+    // State side -> server, changes [tail, head) haven't gone out
+    struct StateDelta queue[GS_QUEUE_SIZE];
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    int behind;             // state side, a change didn't fit, everybody needs a GS_MSG_FULL
+
+    // A full copy waiting for the server, taken when head was resync_at - 1 (0 if none)
+    Uint8 *resync_state;
+    Sint8 *resync_tag;
+    SDL_atomic_t resync_at;
+
+    // Server side, what the clients have been told
+    Uint8 *state;
+    Sint8 *tag;
+    char *names;            // GS_NAME_LENGTH per slot
+    Uint8 *message;         // scratch for building messages
+    size_t message_capacity;
+    int out_of_date;        // a message couldn't be built, the clients are owed a GS_MSG_FULL
+
+    SDL_Thread *thread;
+    SDL_atomic_t quit;
+};
+
+
+void GS_Put16(Uint8 *at, Uint16 value) {
+    at[0] = (Uint8)(value & 0xFF);
+    at[1] = (Uint8)(value >> 8);
+}
+
+void GS_Put32(Uint8 *at, Uint32 value) {
+    GS_Put16(at, (Uint16)(value & 0xFFFF));
+    GS_Put16(at + 2, (Uint16)(value >> 16));
+}
+
+int GS_SetNonBlocking(GS_Socket socket) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(socket, FIONBIO, &on) == 0 ? 0 : -1;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return (flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0) ? 0 : -1;
+#endif
+}
+
+int GS_WouldBlock(void) {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/********************************************//**
+ * @brief
+ * Queues bytes for a client
+ * @param client struct ServerClient*
+ * @param data const Uint8*
+ * @param length size_t
+ * @return int
+ * 0 on success, -1 if the client is too far behind (drop it)
+ ***********************************************/
+int GS_QueueBytes(struct ServerClient *client, const Uint8 *data, size_t length) {
+    Uint8 *grown;
+    size_t capacity = client->capacity;
+
+    // Slide what's left to the front before growing
+    if (client->sent > 0) {
+        memmove(client->out, client->out + client->sent, client->length - client->sent);
+        client->length -= client->sent;
+        client->sent = 0;
+    }
+
+    if (client->length + length > GS_CLIENT_BACKLOG)
+        return -1;
+
+    while (client->length + length > capacity)
+        capacity = capacity * 2 + 1024;
+    if (capacity != client->capacity) {
+        grown = realloc(client->out, capacity);
+        if (grown == NULL)
+            return -1;
+        client->out = grown;
+        client->capacity = capacity;
+    }
+
+    memcpy(client->out + client->length, data, length);
+    client->length += length;
+    return 0;
+}
+
+void GS_DropClient(struct StateServer *server, int index) {
+    GS_CloseSocket(server->clients[index].socket);
+    free(server->clients[index].out);
+    server->clients[index] = server->clients[--server->total_clients];
+}
+
+/********************************************//**
+ * @brief
+ * Makes sure the scratch message has room for length bytes
+ * @return Uint8*
+ * NULL if we're out of memory
+ ***********************************************/
+Uint8 *GS_Message(struct StateServer *server, size_t length) {
+    Uint8 *grown;
+
+    if (length > server->message_capacity) {
+        grown = realloc(server->message, length);
+        if (grown == NULL)
+            return NULL;
+        server->message = grown;
+        server->message_capacity = length;
+    }
+
+    return server->message;
+}
+
+/********************************************//**
+ * @brief
+ * Builds a GS_MSG_FULL from the server's copy of the state
+ * @param server struct StateServer*
+ * @return size_t
+ * bytes in server->message, 0 if we're out of memory
+ ***********************************************/
+size_t GS_BuildFull(struct StateServer *server) {
+    size_t length = 4 + 1 + 4 + (size_t)server->total_slots * (3 + GS_NAME_LENGTH);
+    Uint8 *message = GS_Message(server, length);
+    Uint8 *at;
+
+    if (message == NULL)
+        return 0;
+
+    at = message + 9;
+    for (int i = 0; i < server->total_slots; i++) {
+        const char *name = server->names + i * GS_NAME_LENGTH;
+        size_t name_length = strlen(name);
+
+        *at++ = server->state[i];
+        *at++ = (Uint8)server->tag[i];
+        *at++ = (Uint8)name_length;
+        memcpy(at, name, name_length);
+        at += name_length;
+    }
+
+    length = (size_t)(at - message);
+    GS_Put32(message, (Uint32)(length - 4));
+    message[4] = GS_MSG_FULL;
+    GS_Put32(message + 5, (Uint32)server->total_slots);
+    return length;
+}
+
+void GS_Broadcast(struct StateServer *server, const Uint8 *message, size_t length) {
+    for (int c = server->total_clients - 1; c >= 0; c--)
+        if (GS_QueueBytes(&server->clients[c], message, length) != 0)
+            GS_DropClient(server, c);
+}
+
+/********************************************//**
+ * @brief
+ * Server: folds the queued changes (and a waiting resync) into its copy of the state and
+ * queues them for every client
+ * @param server struct StateServer*
+ * @return void
+ ***********************************************/
+void GS_Drain(struct StateServer *server) {
+    int resync_at = SDL_AtomicGet(&server->resync_at);
+    int tail = SDL_AtomicGet(&server->tail);
+    int head;
+    size_t length;
+    Uint8 *message;
+    Uint8 *at;
+
+    // Clients missed changes last time round, they get all of it before anything new
+    if (server->out_of_date) {
+        length = GS_BuildFull(server);
+        if (length > 0) {
+            GS_Broadcast(server, server->message, length);
+            server->out_of_date = 0;
+        }
+    }
+
+    for (;;) {
+        if (resync_at != 0) {
+            SDL_MemoryBarrierAcquire();
+            memcpy(server->state, server->resync_state, sizeof(Uint8) * server->total_slots);
+            memcpy(server->tag, server->resync_tag, sizeof(Sint8) * server->total_slots);
+
+            // Everything queued before the copy was taken is already in it. Only ever forward,
+            // changes before tail went out already and their slots may have been reused.
+            if (resync_at - 1 - tail > 0) {
+                tail = resync_at - 1;
+                SDL_AtomicSet(&server->tail, tail);
+            }
+            SDL_AtomicSet(&server->resync_at, 0);
+
+            length = GS_BuildFull(server);
+            if (length > 0)
+                GS_Broadcast(server, server->message, length);
+            server->out_of_date = (length == 0);
+        }
+
+        // A resync asked for before this head was published goes first, or clients would get
+        // changes after it and then the older copy on top
+        head = SDL_AtomicGet(&server->head);
+        resync_at = SDL_AtomicGet(&server->resync_at);
+        if (resync_at == 0)
+            break;
+    }
+    SDL_MemoryBarrierAcquire();
+    if (head == tail)
+        return;
+
+    message = GS_Message(server, 4 + 1 + 4 + (size_t)(head - tail) * 6);
+    at = (message != NULL) ? message + 9 : NULL;
+    for (int i = tail; i != head; i++) {
+        const struct StateDelta *delta = &server->queue[i & (GS_QUEUE_SIZE - 1)];
+
+        server->state[delta->slot] = delta->state;
+        server->tag[delta->slot] = delta->tag;
+        if (at != NULL) {
+            GS_Put32(at, delta->slot);
+            at[4] = delta->state;
+            at[5] = (Uint8)delta->tag;
+            at += 6;
+        }
+    }
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&server->tail, head);
+
+    if (message != NULL) {
+        GS_Put32(message, (Uint32)(at - message - 4));
+        message[4] = GS_MSG_DELTA;
+        GS_Put32(message + 5, (Uint32)(head - tail));
+        GS_Broadcast(server, message, (size_t)(at - message));
+    } else {
+        // Out of memory, the server's copy has the changes but the clients don't. They get the
+        // whole of it on the next drain.
+        server->out_of_date = 1;
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Server: takes every pending connection, each one starts with a GS_MSG_FULL
+ * @param server struct StateServer*
+ * @return void
+ ***********************************************/
+void GS_Accept(struct StateServer *server) {
+    GS_Socket socket;
+    size_t length;
+
+    while ((socket = accept(server->listener, NULL, NULL)) != GS_NO_SOCKET) {
+        struct ServerClient *client;
+
+        if (server->total_clients == GS_MAX_CLIENTS || GS_SetNonBlocking(socket) != 0) {
+            GS_CloseSocket(socket);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        int no_sigpipe = 1;
+        setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+        client = &server->clients[server->total_clients++];
+        memset(client, 0, sizeof(*client));
+        client->socket = socket;
+
+        length = GS_BuildFull(server);
+        if (length == 0 || GS_QueueBytes(client, server->message, length) != 0)
+            GS_DropClient(server, server->total_clients - 1);
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Server: waits up to GS_TICK_MS for sockets to be ready, then reads (and drops) whatever the
+ * clients sent and sends whatever they're owed
+ * @param server struct StateServer*
+ * @return void
+ ***********************************************/
+void GS_Pump(struct StateServer *server) {
+    struct timeval timeout = { 0, (long)GS_TICK_MS * 1000 };
+    GS_Socket highest = server->listener;
+    fd_set readable;
+    fd_set writable;
+    char scratch[512];
+
+    FD_ZERO(&readable);
+    FD_ZERO(&writable);
+    FD_SET(server->listener, &readable);
+    for (int c = 0; c < server->total_clients; c++) {
+        struct ServerClient *client = &server->clients[c];
+
+        FD_SET(client->socket, &readable);
+        if (client->sent < client->length)
+            FD_SET(client->socket, &writable);
+        if (client->socket > highest)
+            highest = client->socket;
+    }
+
+    if (select((int)highest + 1, &readable, &writable, NULL, &timeout) <= 0)
+        return;
+
+    if (FD_ISSET(server->listener, &readable))
+        GS_Accept(server);
+
+    for (int c = server->total_clients - 1; c >= 0; c--) {
+        struct ServerClient *client = &server->clients[c];
+        int dead = 0;
+
+        if (FD_ISSET(client->socket, &readable)) {
+            int got = (int)recv(client->socket, scratch, sizeof(scratch), 0);
+            dead = (got == 0) || (got < 0 && !GS_WouldBlock());
+        }
+
+        if (!dead && FD_ISSET(client->socket, &writable)) {
+            int put = (int)send(client->socket, (const char *)client->out + client->sent,
+                                (int)(client->length - client->sent), GS_SEND_FLAGS);
+            if (put > 0)
+                client->sent += (size_t)put;
+            else if (put < 0 && !GS_WouldBlock())
+                dead = 1;
+        }
+
+        if (dead)
+            GS_DropClient(server, c);
+    }
+}
+
+int GS_ServerThread(void *data) {
+    struct StateServer *server = data;
+
+    while (SDL_AtomicGet(&server->quit) == 0) {
+        GS_Drain(server);
+        GS_Pump(server);
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Starts serving on 127.0.0.1:port
+ * @param server struct StateServer*
+ * @param port Uint16
+ * @param state const Uint8* what new clients are told until the first change
+ * @param tag const Sint8*
+ * @param names const char** per slot, cut down to GS_NAME_LENGTH - 1
+ * @param total_slots int
+ * @param state_mask Uint8 state bits clients get to see
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GS_StartServer(struct StateServer *server, Uint16 port, const Uint8 *state, const Sint8 *tag,
+                   const char **names, int total_slots, Uint8 state_mask) {
+    struct sockaddr_in address;
+    int reuse = 1;
+#ifdef _WIN32
+    WSADATA wsa;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        return -1;
+#endif
+
+    memset(server, 0, sizeof(*server));
+    server->total_slots = total_slots;
+    server->state_mask = state_mask;
+    server->listener = GS_NO_SOCKET;
+    SDL_AtomicSet(&server->head, 0);
+    SDL_AtomicSet(&server->tail, 0);
+    SDL_AtomicSet(&server->resync_at, 0);
+    SDL_AtomicSet(&server->quit, 0);
+
+    server->state = malloc(sizeof(Uint8) * total_slots);
+    server->tag = malloc(sizeof(Sint8) * total_slots);
+    server->resync_state = malloc(sizeof(Uint8) * total_slots);
+    server->resync_tag = malloc(sizeof(Sint8) * total_slots);
+    server->names = calloc(total_slots, GS_NAME_LENGTH);
+    if (server->state == NULL || server->tag == NULL || server->resync_state == NULL
+        || server->resync_tag == NULL || server->names == NULL) {
+        DEBUG_ERR("Unable to set up the state server");
+        return -1;
+    }
+
+    memcpy(server->tag, tag, sizeof(Sint8) * total_slots);
+    for (int i = 0; i < total_slots; i++) {
+        server->state[i] = state[i] & state_mask;
+        snprintf(server->names + i * GS_NAME_LENGTH, GS_NAME_LENGTH, "%s", names[i]);
+    }
+
+    // Loopback only, nothing off this machine gets to see (or poke at) us
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    server->listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listener == GS_NO_SOCKET
+        || setsockopt(server->listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse)) != 0
+        || bind(server->listener, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(server->listener, GS_MAX_CLIENTS) != 0
+        || GS_SetNonBlocking(server->listener) != 0) {
+        DEBUG_ERR("Unable to listen for overlays");
+        return -1;
+    }
+
+    server->thread = SDL_CreateThread(GS_ServerThread, "ZT_Server", server);
+    if (server->thread == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * State side: queues a slot's new state for every client, never blocks
+ * @param server struct StateServer*
+ * @param slot int
+ * @param state Uint8
+ * @param tag Sint8
+ * @return void
+ ***********************************************/
+void GS_Publish(struct StateServer *server, int slot, Uint8 state, Sint8 tag) {
+    int head = SDL_AtomicGet(&server->head);
+    struct StateDelta *delta;
+
+    // Full, the next resync covers this one
+    if (head - SDL_AtomicGet(&server->tail) == GS_QUEUE_SIZE) {
+        server->behind = 1;
+        return;
+    }
+
+    delta = &server->queue[head & (GS_QUEUE_SIZE - 1)];
+    delta->slot = (Uint32)slot;
+    delta->state = state & server->state_mask;
+    delta->tag = tag;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&server->head, head + 1);
+}
+
+/********************************************//**
+ * @brief
+ * State side, once a frame: if a change was dropped, hands the server a full copy to resend
+ * @param server struct StateServer*
+ * @param state const Uint8*
+ * @param tag const Sint8*
+ * @return void
+ ***********************************************/
+void GS_Maintain(struct StateServer *server, const Uint8 *state, const Sint8 *tag) {
+    if (server->behind == 0 || SDL_AtomicGet(&server->resync_at) != 0)
+        return;
+
+    for (int i = 0; i < server->total_slots; i++)
+        server->resync_state[i] = state[i] & server->state_mask;
+    memcpy(server->resync_tag, tag, sizeof(Sint8) * server->total_slots);
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&server->resync_at, SDL_AtomicGet(&server->head) + 1);
+    server->behind = 0;
+}
+
+void GS_StopServer(struct StateServer *server) {
+    if (server->thread != NULL) {
+        SDL_AtomicSet(&server->quit, 1);
+        SDL_WaitThread(server->thread, NULL);
+    }
+    while (server->total_clients > 0)
+        GS_DropClient(server, server->total_clients - 1);
+    if (server->listener != GS_NO_SOCKET)
+        GS_CloseSocket(server->listener);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    free(server->state);
+    free(server->tag);
+    free(server->resync_state);
+    free(server->resync_tag);
+    free(server->names);
+    free(server->message);
+    memset(server, 0, sizeof(*server));
+}
+
+#endif //ZELDATRACKER_GAMESERVER_H
@@ -0,0 +1,181 @@
+#ifndef ZELDATRACKER_GAMESTARTUP_H
+#define ZELDATRACKER_GAMESTARTUP_H
+
+/*
+ * Cold start. The slow parts of coming up that don't need the window (reading and parsing
+ * sprites.cfg, opening the font and rasterizing its glyphs, decoding the sheet) run as jobs on
+ * worker threads while the window and renderer are created, only the texture uploads wait for
+ * them. Every phase, on whichever thread, is timed against the same start and GSU_Report prints
+ * them in the order they finished, so it's plain which one the first frame was waiting on.
+ *
+ * Startup only happens once per process, the report is a single global like GX_KERNELS.
+ */
+
+#define GSU_MAX_PHASES 24
+
+struct StartupPhase {
+    const char *name;
+    Uint64 from;            // counter
+    Uint64 to;
+    const char *thread;     // NULL for the main thread
+};
+
+struct StartupReport {
+    Uint64 started;
+    struct StartupPhase phases[GSU_MAX_PHASES];
+    SDL_atomic_t total;     // phases claimed, may run past GSU_MAX_PHASES (those are dropped)
+};
+
+struct StartupJob {
+    SDL_Thread *thread;     // NULL once finished, or if it ran on the calling thread
+    int result;
+};
+
+struct StartupReport GSU_STARTUP;
+
+/********************************************//**
+ * @brief
+ * Starts the clock everything else is measured from, call it first thing in main
+ * @return void
+ ***********************************************/
+void GSU_Begin(void) {
+    memset(&GSU_STARTUP, 0, sizeof(GSU_STARTUP));
+    GSU_STARTUP.started = SDL_GetPerformanceCounter();
+}
+
+/********************************************//**
+ * @brief
+ * Records a phase that ran from from until to, for one that finished somewhere it couldn't be
+ * marked. Safe from any thread.
+ * @param name const char* has to outlive the report, a literal
+ * @param from Uint64 counter when it started
+ * @param to Uint64 counter when it finished
+ * @param thread const char* where it ran, NULL for the main thread
+ * @return Uint64
+ * to
+ ***********************************************/
+Uint64 GSU_MarkUntil(const char *name, Uint64 from, Uint64 to, const char *thread) {
+    int at = SDL_AtomicAdd(&GSU_STARTUP.total, 1);
+
+    if (GSU_STARTUP.started == 0 || at >= GSU_MAX_PHASES)
+        return to;
+
+    GSU_STARTUP.phases[at].name = name;
+    GSU_STARTUP.phases[at].from = from;
+    GSU_STARTUP.phases[at].to = to;
+    GSU_STARTUP.phases[at].thread = thread;
+    return to;
+}
+
+/********************************************//**
+ * @brief
+ * Records a phase that ran from from until now. Safe from any thread.
+ * @param name const char* has to outlive the report, a literal
+ * @param from Uint64 counter when it started
+ * @param thread const char* where it ran, NULL for the main thread
+ * @return Uint64
+ * now, to chain into the next phase's from
+ ***********************************************/
+Uint64 GSU_Mark(const char *name, Uint64 from, const char *thread) {
+    return GSU_MarkUntil(name, from, SDL_GetPerformanceCounter(), thread);
+}
+
+struct StartupJobStart {
+    SDL_ThreadFunction run;
+    void *data;
+    const char *name;
+};
+
+int GSU_RunJob(void *data) {
+    struct StartupJobStart start = *(struct StartupJobStart *)data;
+    Uint64 from = SDL_GetPerformanceCounter();
+    int result;
+
+    free(data);
+    result = start.run(start.data);
+    GSU_Mark(start.name, from, "worker");
+    return result;
+}
+
+/********************************************//**
+ * @brief
+ * Runs run(data) on a worker thread, or right here if one can't be had. run mustn't touch the
+ * window, the renderer or anything the caller uses before GSU_FinishJob.
+ * @param job struct StartupJob*
+ * @param name const char* for the report, a literal
+ * @param run SDL_ThreadFunction returns 0 on success
+ * @param data void*
+ * @return void
+ ***********************************************/
+void GSU_StartJob(struct StartupJob *job, const char *name, SDL_ThreadFunction run, void *data) {
+    struct StartupJobStart *start = malloc(sizeof(struct StartupJobStart));
+    Uint64 from;
+
+    job->thread = NULL;
+    if (start != NULL) {
+        start->run = run;
+        start->data = data;
+        start->name = name;
+        job->thread = SDL_CreateThread(GSU_RunJob, name, start);
+        if (job->thread != NULL)
+            return;
+        free(start);
+    }
+
+    from = SDL_GetPerformanceCounter();
+    job->result = run(data);
+    GSU_Mark(name, from, NULL);
+}
+
+/********************************************//**
+ * @brief
+ * Waits for a job, any thread may call it, once. The wait shows up in the report if there was
+ * one worth mentioning.
+ * @param job struct StartupJob*
+ * @param thread const char* the caller, NULL for the main thread
+ * @return int
+ * what the job returned
+ ***********************************************/
+int GSU_FinishJob(struct StartupJob *job, const char *thread) {
+    Uint64 from = SDL_GetPerformanceCounter();
+
+    if (job->thread == NULL)
+        return job->result;
+
+    SDL_WaitThread(job->thread, &job->result);
+    job->thread = NULL;
+    if ((SDL_GetPerformanceCounter() - from) * 10000 > SDL_GetPerformanceFrequency())
+        GSU_Mark("waiting on a worker", from, thread);
+    return job->result;
+}
+
+/********************************************//**
+ * @brief
+ * Logs every phase so far, in the order they finished, as ms since GSU_Begin and ms taken
+ * @return void
+ ***********************************************/
+void GSU_Report(void) {
+    int total = SDL_AtomicGet(&GSU_STARTUP.total);
+    double ms_per_count = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    char line[128];
+
+    if (GSU_STARTUP.started == 0)
+        return;
+    if (total > GSU_MAX_PHASES)
+        total = GSU_MAX_PHASES;
+
+    DEBUG_LOG("Startup (ms from start, ms taken):");
+    for (int i = 0; i < total; i++) {
+        const struct StartupPhase *phase = &GSU_STARTUP.phases[i];
+
+        if (phase->name == NULL)
+            continue;
+        snprintf(line, sizeof(line), "  %8.2f %8.2f  %s (%s)",
+                 (double)(phase->to - GSU_STARTUP.started) * ms_per_count,
+                 (double)(phase->to - phase->from) * ms_per_count, phase->name,
+                 (phase->thread != NULL) ? phase->thread : "main");
+        DEBUG_LOG(line);
+    }
+}
+
+#endif //ZELDATRACKER_GAMESTARTUP_H
@@ -0,0 +1,244 @@
+#ifndef ZELDATRACKER_GAMETEXT_H
+#define ZELDATRACKER_GAMETEXT_H
+
+/*
+ * Text out of a glyph atlas. Printable ASCII is rasterized once from the font into one texture,
+ * after that a string is just a run of quads in a SpriteBatch: no surfaces, no texture uploads,
+ * nothing allocated per frame. Glyphs are rendered white, alpha rides along like any sprite's.
+ * Software rendering keeps the glyphs in a raster instead and GTX_DrawText blits them directly.
+ */
+
+#define GTX_FIRST_GLYPH 32      // ' '
+#define GTX_LAST_GLYPH 126      // '~'
+#define GTX_TOTAL_GLYPHS (GTX_LAST_GLYPH - GTX_FIRST_GLYPH + 1)
+
+const int GTX_GLYPHS_PER_ROW = 16;
+
+struct GlyphAtlas {
+    SDL_Texture *texture;
+    struct Raster pixels;                   // software rendering only, in place of the texture
+    SDL_Rect glyphs[GTX_TOTAL_GLYPHS];      // where each glyph lives in the texture
+    int advance[GTX_TOTAL_GLYPHS];          // pen movement after the glyph, in font pixels
+    int line_height;
+    struct SpriteBatch batch;
+};
+
+
+/********************************************//**
+ * @brief
+ * Rasterizes printable ASCII from font into one surface and works out where every glyph sits.
+ * CPU only, it can run on a worker thread while the renderer comes up (GTX_UploadText after).
+ * @param text struct GlyphAtlas*
+ * @param font TTF_Font*
+ * @return SDL_Surface*
+ * the glyphs, RGBA32, NULL on failure
+ ***********************************************/
+SDL_Surface *GTX_RasterizeText(struct GlyphAtlas *text, TTF_Font *font) {
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface *rendered[GTX_TOTAL_GLYPHS];
+    SDL_Surface *atlas;
+    int cell_w = 1;
+    int cell_h = TTF_FontHeight(font);
+    int rows = (GTX_TOTAL_GLYPHS + GTX_GLYPHS_PER_ROW - 1) / GTX_GLYPHS_PER_ROW;
+
+    text->texture = NULL;
+    memset(&text->pixels, 0, sizeof(text->pixels));
+    memset(&text->batch, 0, sizeof(text->batch));
+    text->line_height = cell_h;
+
+    for (int i = 0; i < GTX_TOTAL_GLYPHS; i++) {
+        int minx, maxx, miny, maxy, advance;
+        Uint16 glyph = (Uint16)(GTX_FIRST_GLYPH + i);
+
+        rendered[i] = NULL;
+        text->advance[i] = 0;
+        if (TTF_GlyphMetrics(font, glyph, &minx, &maxx, &miny, &maxy, &advance) != 0)
+            continue;
+
+        text->advance[i] = advance;
+        if (glyph == ' ')
+            continue;
+
+        // Comes back a full line tall with the glyph already sat on the baseline
+        rendered[i] = TTF_RenderGlyph_Blended(font, glyph, white);
+        if (rendered[i] == NULL)
+            continue;
+
+        if (rendered[i]->w > cell_w)
+            cell_w = rendered[i]->w;
+        if (rendered[i]->h > cell_h)
+            cell_h = rendered[i]->h;
+    }
+
+    // 1px gutter so scaled glyphs don't pick up their neighbours
+    atlas = SDL_CreateRGBSurfaceWithFormat(0, GTX_GLYPHS_PER_ROW * (cell_w + 1), rows * (cell_h + 1),
+                                           32, SDL_PIXELFORMAT_RGBA32);
+    if (atlas == NULL)
+        DEBUG_ERR(SDL_GetError());
+
+    for (int i = 0; i < GTX_TOTAL_GLYPHS; i++) {
+        SDL_Rect *to = &text->glyphs[i];
+
+        to->x = (i % GTX_GLYPHS_PER_ROW) * (cell_w + 1);
+        to->y = (i / GTX_GLYPHS_PER_ROW) * (cell_h + 1);
+        to->w = (rendered[i] != NULL) ? rendered[i]->w : 0;
+        to->h = (rendered[i] != NULL) ? rendered[i]->h : 0;
+        if (rendered[i] == NULL)
+            continue;
+
+        if (atlas != NULL) {
+            SDL_SetSurfaceBlendMode(rendered[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(rendered[i], NULL, atlas, to);
+        }
+        SDL_FreeSurface(rendered[i]);
+    }
+
+    return atlas;
+}
+
+/********************************************//**
+ * @brief
+ * Turns what GTX_RasterizeText made into a texture, on the thread that renders
+ * @param text struct GlyphAtlas*
+ * @param renderer SDL_Renderer* NULL for software rendering, the glyphs go in a raster
+ * @param atlas SDL_Surface* from GTX_RasterizeText, freed either way
+ * @param capacity int glyph quads to reserve, the batch grows past it if it has to
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GTX_UploadText(struct GlyphAtlas *text, SDL_Renderer *renderer, SDL_Surface *atlas, int capacity) {
+    int result;
+
+    if (atlas == NULL)
+        return -1;
+
+    if (renderer == NULL) {
+        result = GX_InitRaster(&text->pixels, atlas->w, atlas->h);
+        if (result == 0)
+            SDL_ConvertPixels(atlas->w, atlas->h, atlas->format->format, atlas->pixels, atlas->pitch,
+                              SDL_PIXELFORMAT_ARGB8888, text->pixels.pixels, text->pixels.pitch * 4);
+        SDL_FreeSurface(atlas);
+        return result;
+    }
+
+    text->texture = SDL_CreateTextureFromSurface(renderer, atlas);
+    SDL_FreeSurface(atlas);
+    if (text->texture == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(text->texture, SDL_BLENDMODE_BLEND);
+
+    return GB_InitBatch(&text->batch, text->texture, capacity);
+}
+
+/********************************************//**
+ * @brief
+ * Width a string comes out at when drawn height pixels tall
+ * @param text struct GlyphAtlas*
+ * @param str const char*
+ * @param height int
+ * @return int
+ ***********************************************/
+int GTX_MeasureText(const struct GlyphAtlas *text, const char *str, int height) {
+    int pen = 0;
+
+    for (const char *c = str; *c != '\0'; c++)
+        if (*c >= GTX_FIRST_GLYPH && *c <= GTX_LAST_GLYPH)
+            pen += text->advance[*c - GTX_FIRST_GLYPH];
+
+    return pen * height / text->line_height;
+}
+
+/********************************************//**
+ * @brief
+ * Queues a string with its top left at x, y, scaled so a line is height pixels tall.
+ * Anything outside printable ASCII is skipped.
+ * @param text struct GlyphAtlas*
+ * @param str const char*
+ * @param x int
+ * @param y int
+ * @param height int
+ * @param alpha Uint8
+ * @return int
+ * width of what was queued
+ ***********************************************/
+int GTX_PushText(struct GlyphAtlas *text, const char *str, int x, int y, int height, Uint8 alpha) {
+    SDL_Rect to;
+    int pen = 0;
+
+    for (const char *c = str; *c != '\0'; c++) {
+        int glyph = *c - GTX_FIRST_GLYPH;
+
+        if (*c < GTX_FIRST_GLYPH || *c > GTX_LAST_GLYPH)
+            continue;
+
+        if (text->glyphs[glyph].w > 0) {
+            to.x = x + pen * height / text->line_height;
+            to.y = y;
+            to.w = text->glyphs[glyph].w * height / text->line_height;
+            to.h = text->glyphs[glyph].h * height / text->line_height;
+            GB_Push(&text->batch, &text->glyphs[glyph], &to, alpha);
+        }
+        pen += text->advance[glyph];
+    }
+
+    return pen * height / text->line_height;
+}
+
+/********************************************//**
+ * @brief
+ * GTX_PushText for software rendering, the string is blitted into target right away
+ * @param text struct GlyphAtlas*
+ * @param target struct Raster*
+ * @param str const char*
+ * @param x int
+ * @param y int
+ * @param height int
+ * @param alpha Uint8
+ * @return int
+ * width of what was drawn
+ ***********************************************/
+int GTX_DrawText(struct GlyphAtlas *text, struct Raster *target, const char *str, int x, int y, int height,
+                 Uint8 alpha) {
+    SDL_Rect to;
+    int pen = 0;
+
+    for (const char *c = str; *c != '\0'; c++) {
+        int glyph = *c - GTX_FIRST_GLYPH;
+
+        if (*c < GTX_FIRST_GLYPH || *c > GTX_LAST_GLYPH)
+            continue;
+
+        if (text->glyphs[glyph].w > 0) {
+            to.x = x + pen * height / text->line_height;
+            to.y = y;
+            to.w = text->glyphs[glyph].w * height / text->line_height;
+            to.h = text->glyphs[glyph].h * height / text->line_height;
+            GX_Blit(target, &to, &text->pixels, &text->glyphs[glyph], alpha);
+        }
+        pen += text->advance[glyph];
+    }
+
+    return pen * height / text->line_height;
+}
+
+/********************************************//**
+ * @brief
+ * Draws everything queued since the last flush in one call
+ * @return int
+ * number of glyphs drawn
+ ***********************************************/
+int GTX_Flush(struct GlyphAtlas *text, SDL_Renderer *renderer) {
+    return GB_Flush(&text->batch, renderer);
+}
+
+void GTX_DestroyText(struct GlyphAtlas *text) {
+    GB_DestroyBatch(&text->batch);
+    GX_DestroyRaster(&text->pixels);
+    if (text->texture != NULL)
+        SDL_DestroyTexture(text->texture);
+    text->texture = NULL;
+}
+
+#endif //ZELDATRACKER_GAMETEXT_H
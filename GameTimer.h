@@ -0,0 +1,140 @@
+#ifndef ZELDATRACKER_GAMETIMER_H
+#define ZELDATRACKER_GAMETIMER_H
+
+const float GT_MIN_FPS = 1;
+const float GT_MAX_FPS = 240;
+const float GT_FPS_STEP = 10;
+
+struct FrameClock {
+    Uint64 frequency;      // performance counter ticks per second
+    Uint64 started;        // counter value when the clock was created
+    Uint64 previous;       // counter value at the last GT_Advance
+    double now;            // ms since the clock was created, as of the last GT_Advance
+    double lag;            // ms of simulation not yet consumed by fixed updates
+    double ms_per_update;  // fixed simulation step, this is what moves link along
+    double ms_per_frame;   // minimum spacing between two presented frames
+    double next_frame;     // earliest time the next frame may be presented
+    float target_fps;
+};
+
+
+/********************************************//**
+ * @brief
+ * Clamps and applies the presentation frame rate. The simulation step is left alone so
+ * link walks at the same speed no matter how often we draw him.
+ * @param clock struct FrameClock*
+ * @param fps float
+ * @return void
+ ***********************************************/
+void GT_SetTargetFps(struct FrameClock *clock, float fps) {
+    if (fps < GT_MIN_FPS)
+        fps = GT_MIN_FPS;
+    if (fps > GT_MAX_FPS)
+        fps = GT_MAX_FPS;
+
+    clock->target_fps = fps;
+    clock->ms_per_frame = 1000.0 / fps;
+    clock->next_frame = clock->now;
+}
+
+/********************************************//**
+ * @brief
+ * Initializes the clock against SDL's high resolution performance counter
+ * @param clock struct FrameClock*
+ * @param updates_per_second float fixed simulation rate
+ * @param target_fps float presentation cap
+ * @return void
+ ***********************************************/
+void GT_InitClock(struct FrameClock *clock, float updates_per_second, float target_fps) {
+    clock->frequency = SDL_GetPerformanceFrequency();
+    clock->started = SDL_GetPerformanceCounter();
+    clock->previous = clock->started;
+    clock->now = 0;
+    clock->lag = 0;
+    clock->ms_per_update = 1000.0 / updates_per_second;
+    GT_SetTargetFps(clock, target_fps);
+}
+
+/********************************************//**
+ * @brief
+ * Samples the performance counter, moves clock->now forward and banks the elapsed
+ * time as lag for the fixed update loop
+ * @param clock struct FrameClock*
+ * @return double
+ * ms elapsed since the previous call
+ ***********************************************/
+double GT_Advance(struct FrameClock *clock) {
+    Uint64 counter = SDL_GetPerformanceCounter();
+    double elapsed = (double)(counter - clock->previous) * 1000.0 / (double)clock->frequency;
+
+    clock->previous = counter;
+    clock->now = (double)(counter - clock->started) * 1000.0 / (double)clock->frequency;
+    clock->lag += elapsed;
+
+    return elapsed;
+}
+
+/********************************************//**
+ * @brief
+ * Moves the clock forward by a fixed amount instead of sampling the counter, for
+ * deterministic replays
+ * @param clock struct FrameClock*
+ * @param elapsed double ms
+ * @return void
+ ***********************************************/
+void GT_AdvanceBy(struct FrameClock *clock, double elapsed) {
+    clock->now += elapsed;
+    clock->lag += elapsed;
+}
+
+/********************************************//**
+ * @brief
+ * Whether enough time has passed since the last present to draw another frame
+ * @param clock struct FrameClock*
+ * @return int
+ * 1 if a frame may be presented, 0 if not
+ ***********************************************/
+int GT_CanPresent(struct FrameClock *clock) {
+    return clock->now >= clock->next_frame;
+}
+
+/********************************************//**
+ * @brief
+ * Schedules the earliest time for the next frame. Stays on the frame grid unless we
+ * fell more than a whole frame behind, in which case it re-anchors instead of bursting.
+ * @param clock struct FrameClock*
+ * @return void
+ ***********************************************/
+void GT_FramePresented(struct FrameClock *clock) {
+    clock->next_frame += clock->ms_per_frame;
+    if (clock->next_frame < clock->now)
+        clock->next_frame = clock->now + clock->ms_per_frame;
+}
+
+/********************************************//**
+ * @brief
+ * Blocks until there is input, the next fixed update is due or, if a redraw is pending,
+ * the next frame may be presented. This is what keeps us off the CPU while idle.
+ * @param clock struct FrameClock*
+ * @param e SDL_Event* receives the event that woke us, if any
+ * @param redraw_pending int non-zero if there is something new to draw
+ * @return int
+ * 1 if e holds an event, 0 if we woke up on the timeout
+ ***********************************************/
+int GT_WaitEvent(struct FrameClock *clock, SDL_Event *e, int redraw_pending) {
+    double now = (double)(SDL_GetPerformanceCounter() - clock->started) * 1000.0 / (double)clock->frequency;
+    double wake_at = clock->now + (clock->ms_per_update - clock->lag);
+    double timeout;
+
+    if (redraw_pending && clock->next_frame < wake_at)
+        wake_at = clock->next_frame;
+
+    timeout = wake_at - now;
+    if (timeout <= 0)
+        return SDL_PollEvent(e);
+
+    // SDL only sleeps in whole ms, round up so we never wake a hair early and spin
+    return SDL_WaitEventTimeout(e, (int)(timeout + 0.999));
+}
+
+#endif //ZELDATRACKER_GAMETIMER_H
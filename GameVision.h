@@ -0,0 +1,939 @@
+#ifndef ZELDATRACKER_GAMEVISION_H
+#define ZELDATRACKER_GAMEVISION_H
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Auto-tracking from video, for consoles where there's no RAM to read. Frames come in as
+ * YUV4MPEG2 or raw RGB24 from a file or a pipe ("-" for stdin), on a thread of their own. The
+ * item icons are cut out of the sprite sheet, scaled to the capture and looked for in the
+ * inventory part of every frame. vision.cfg says where that is:
+ *
+ *     frame 640 480           raw RGB24 only, a .y4m says its own size
+ *     region 64 60 512 200    inventory, in frame pixels
+ *     scale 2.5 2             frame pixels per sheet pixel
+ *     threshold 0.8           normalized cross-correlation that counts as found
+ *     background 0            luma drawn behind the icons (transparent sheet pixels)
+ *
+ * Matching runs on luma. An item that isn't in view gets a full search now and then (round
+ * robin, GV_SEARCHES_PER_FRAME a frame): sum of absolute differences over every position at
+ * the coarsest level of a 2x pyramid, refined a level at a time around the best and scored
+ * with normalized cross-correlation at full size. Once found, an item is only looked for in a
+ * few pixels around where it was, until it goes away. Both kernels have scalar, SSE2 and AVX2
+ * versions like GameRaster.h's, SAD works on 16/32 positions at a time.
+ *
+ * An item seen GV_CONFIRM_FRAMES frames running counts as detected. Detection only ever turns
+ * items on: the inventory is off screen most of the time, not seeing something means nothing.
+ */
+
+#define GV_LEVELS 3             // full, half and quarter size
+
+const int GV_MIN_COARSE = 4;            // templates smaller than this at a level are too blurry to search with
+const int GV_REFINE_RADIUS = 2;         // pixels around the coarser level's best, at each finer level
+const int GV_TRACK_RADIUS = 2;          // pixels a found item is looked for around where it was
+const int GV_SEARCHES_PER_FRAME = 4;    // full searches for items not in view
+const int GV_CONFIRM_FRAMES = 3;
+const int GV_WAIT_MS = 100;             // reader checks for shutdown at least this often
+
+struct VisionKernels {
+    const char *name;
+    // out[k] = SAD of the template against image + k, for k in [0, n). Saturates at 65535.
+    void (*sad)(const Uint8 *image, int pitch, const Uint8 *tmpl, int tw, int th, int n, Uint16 *out);
+    // sums[0] += sum(image), sums[1] += sum(image^2), sums[2] += sum(image * tmpl) over n pixels
+    void (*correlate)(const Uint8 *image, const Sint16 *tmpl, int n, Sint64 *sums);
+};
+
+struct LumaPlane {
+    Uint8 *pixels;          // pitch is w
+    int w;
+    int h;
+};
+
+struct VisionTemplate {
+    char name[GCF_NAME_LENGTH];
+    int slot;               // state side, bound by the caller, -1 for none
+    int applied;            // state side, detected as of the last poll
+    struct LumaPlane level[GV_LEVELS];
+    Sint16 *centered;       // level 0 minus its mean, for the correlation
+    double energy;          // sum of centered^2
+    int coarse;             // level the full search runs at
+
+    // Reader thread only
+    int tracked;            // found last frame, at x, y in the full size region
+    int x;
+    int y;
+    int streak;             // frames in a row it's been found
+    int seen;               // streak made it to GV_CONFIRM_FRAMES
+
+    SDL_atomic_t detected;  // bumped every time it comes into view
+};
+
+struct VisionConfig {
+    int frame_w;
+    int frame_h;
+    SDL_Rect region;
+    float scale_x;
+    float scale_y;
+    float threshold;
+    int background;
+};
+
+struct Vision {
+    struct VisionConfig config;
+    struct VisionTemplate *templates;
+    int total_templates;
+    int capacity;
+
+    FILE *input;
+    int y4m;
+    int frame_w;
+    int frame_h;
+    size_t frame_bytes;
+    Uint8 *frame;
+    struct LumaPlane level[GV_LEVELS];  // the region, at every size
+    Uint16 *scores;                     // a row of SADs
+    int next_search;
+
+    SDL_Thread *thread;
+    SDL_atomic_t quit;
+    Uint64 frames;
+    double busy_ms;
+};
+
+
+void GV_SadScalar(const Uint8 *image, int pitch, const Uint8 *tmpl, int tw, int th, int n, Uint16 *out) {
+    for (int k = 0; k < n; k++) {
+        Uint32 sad = 0;
+
+        for (int y = 0; y < th; y++)
+            for (int x = 0; x < tw; x++) {
+                int d = image[y * pitch + k + x] - tmpl[y * tw + x];
+                sad += (Uint32)((d < 0) ? -d : d);
+            }
+        out[k] = (Uint16)((sad > 0xFFFF) ? 0xFFFF : sad);
+    }
+}
+
+void GV_CorrelateScalar(const Uint8 *image, const Sint16 *tmpl, int n, Sint64 *sums) {
+    for (int i = 0; i < n; i++) {
+        sums[0] += image[i];
+        sums[1] += image[i] * image[i];
+        sums[2] += image[i] * tmpl[i];
+    }
+}
+
+#ifdef GX_X86
+
+GX_TARGET_SSE2 void GV_SadSse2(const Uint8 *image, int pitch, const Uint8 *tmpl, int tw, int th, int n,
+                               Uint16 *out) {
+    const __m128i zero = _mm_setzero_si128();
+    int k = 0;
+
+    // 16 positions at a time, each template pixel against 16 neighbouring image pixels
+    for (; k + 16 <= n; k += 16) {
+        __m128i lo = zero;
+        __m128i hi = zero;
+
+        for (int y = 0; y < th; y++) {
+            const Uint8 *row = image + y * pitch + k;
+
+            for (int x = 0; x < tw; x++) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+                __m128i t = _mm_set1_epi8((char)tmpl[y * tw + x]);
+                __m128i d = _mm_or_si128(_mm_subs_epu8(v, t), _mm_subs_epu8(t, v));
+
+                lo = _mm_adds_epu16(lo, _mm_unpacklo_epi8(d, zero));
+                hi = _mm_adds_epu16(hi, _mm_unpackhi_epi8(d, zero));
+            }
+        }
+        _mm_storeu_si128((__m128i *)(out + k), lo);
+        _mm_storeu_si128((__m128i *)(out + k + 8), hi);
+    }
+    GV_SadScalar(image + k, pitch, tmpl, tw, th, n - k, out + k);
+}
+
+GX_TARGET_SSE2 void GV_CorrelateSse2(const Uint8 *image, const Sint16 *tmpl, int n, Sint64 *sums) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    __m128i squares = zero;
+    __m128i products = zero;
+    Sint32 lanes[4];
+    Sint64 total[2];
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(image + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+        squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        products = _mm_add_epi32(products,
+                                 _mm_add_epi32(_mm_madd_epi16(lo, _mm_loadu_si128((const __m128i *)(tmpl + i))),
+                                               _mm_madd_epi16(hi, _mm_loadu_si128((const __m128i *)(tmpl + i + 8)))));
+    }
+
+    _mm_storeu_si128((__m128i *)total, sum);
+    sums[0] += total[0] + total[1];
+    _mm_storeu_si128((__m128i *)lanes, squares);
+    sums[1] += (Sint64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_si128((__m128i *)lanes, products);
+    sums[2] += (Sint64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    GV_CorrelateScalar(image + i, tmpl + i, n - i, sums);
+}
+
+GX_TARGET_AVX2 void GV_SadAvx2(const Uint8 *image, int pitch, const Uint8 *tmpl, int tw, int th, int n,
+                               Uint16 *out) {
+    int k = 0;
+
+    for (; k + 32 <= n; k += 32) {
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+
+        for (int y = 0; y < th; y++) {
+            const Uint8 *row = image + y * pitch + k;
+
+            for (int x = 0; x < tw; x++) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)(row + x));
+                __m256i t = _mm256_set1_epi8((char)tmpl[y * tw + x]);
+                __m256i d = _mm256_or_si256(_mm256_subs_epu8(v, t), _mm256_subs_epu8(t, v));
+
+                // Widened a half at a time, unpack would interleave the two lanes
+                lo = _mm256_adds_epu16(lo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)));
+                hi = _mm256_adds_epu16(hi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)));
+            }
+        }
+        _mm256_storeu_si256((__m256i *)(out + k), lo);
+        _mm256_storeu_si256((__m256i *)(out + k + 16), hi);
+    }
+    GV_SadSse2(image + k, pitch, tmpl, tw, th, n - k, out + k);
+}
+
+GX_TARGET_AVX2 void GV_CorrelateAvx2(const Uint8 *image, const Sint16 *tmpl, int n, Sint64 *sums) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m128i sum = _mm_setzero_si128();
+    __m256i squares = zero;
+    __m256i products = zero;
+    Sint32 lanes[8];
+    Sint64 total[2];
+    int i = 0;
+
+    // 16 pixels widened to a whole register, the byte sum stays 128 bits wide
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(image + i));
+        __m256i wide = _mm256_cvtepu8_epi16(v);
+
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(v, _mm_setzero_si128()));
+        squares = _mm256_add_epi32(squares, _mm256_madd_epi16(wide, wide));
+        products = _mm256_add_epi32(products,
+                                    _mm256_madd_epi16(wide, _mm256_loadu_si256((const __m256i *)(tmpl + i))));
+    }
+
+    _mm_storeu_si128((__m128i *)total, sum);
+    sums[0] += total[0] + total[1];
+    _mm256_storeu_si256((__m256i *)lanes, squares);
+    for (int l = 0; l < 8; l++)
+        sums[1] += lanes[l];
+    _mm256_storeu_si256((__m256i *)lanes, products);
+    for (int l = 0; l < 8; l++)
+        sums[2] += lanes[l];
+    GV_CorrelateScalar(image + i, tmpl + i, n - i, sums);
+}
+
+#endif // GX_X86
+
+struct VisionKernels GV_KERNELS = { "scalar", GV_SadScalar, GV_CorrelateScalar };
+
+/********************************************//**
+ * @brief
+ * Picks the fastest kernels this CPU runs. ZT_VISION=scalar|sse2|avx2 in the environment asks
+ * for a particular set (if the CPU has it), for comparing them.
+ * @return const char*
+ * name of the kernels picked
+ ***********************************************/
+const char *GV_InitKernels(void) {
+    const char *wanted = SDL_getenv("ZT_VISION");
+    struct VisionKernels scalar = { "scalar", GV_SadScalar, GV_CorrelateScalar };
+    struct VisionKernels best = scalar;
+#ifdef GX_X86
+    struct VisionKernels sse2 = { "sse2", GV_SadSse2, GV_CorrelateSse2 };
+    struct VisionKernels avx2 = { "avx2", GV_SadAvx2, GV_CorrelateAvx2 };
+
+    if (SDL_HasSSE2())
+        best = sse2;
+    if (SDL_HasAVX2())
+        best = avx2;
+    if (wanted != NULL && strcmp(wanted, "sse2") == 0 && SDL_HasSSE2())
+        best = sse2;
+#endif
+    if (wanted != NULL && strcmp(wanted, "scalar") == 0)
+        best = scalar;
+
+    GV_KERNELS = best;
+    return GV_KERNELS.name;
+}
+
+/********************************************//**
+ * @brief
+ * Halves a plane, every output pixel the rounded average of a 2x2 block
+ * @param from const struct LumaPlane*
+ * @param to struct LumaPlane* sized from->w / 2 x from->h / 2 already
+ * @return void
+ ***********************************************/
+void GV_Halve(const struct LumaPlane *from, struct LumaPlane *to) {
+    for (int y = 0; y < to->h; y++) {
+        const Uint8 *top = from->pixels + (size_t)(2 * y) * from->w;
+        const Uint8 *bottom = top + from->w;
+        Uint8 *out = to->pixels + (size_t)y * to->w;
+
+        for (int x = 0; x < to->w; x++)
+            out[x] = (Uint8)((top[2 * x] + top[2 * x + 1] + bottom[2 * x] + bottom[2 * x + 1] + 2) >> 2);
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Allocates level 0 at w x h and every smaller level under it
+ * @param level struct LumaPlane* GV_LEVELS of them
+ * @param w int
+ * @param h int
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int GV_InitLevels(struct LumaPlane *level, int w, int h) {
+    for (int l = 0; l < GV_LEVELS; l++) {
+        level[l].w = w >> l;
+        level[l].h = h >> l;
+        level[l].pixels = malloc((size_t)level[l].w * level[l].h + 1);
+        if (level[l].pixels == NULL)
+            return -1;
+    }
+    return 0;
+}
+
+void GV_DestroyLevels(struct LumaPlane *level) {
+    for (int l = 0; l < GV_LEVELS; l++) {
+        free(level[l].pixels);
+        level[l].pixels = NULL;
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Reads vision.cfg, see the top of this file
+ * @param config struct VisionConfig*
+ * @param path const char*
+ * @return int
+ * 0 on success, -1 on failure (reported)
+ ***********************************************/
+int GV_LoadConfig(struct VisionConfig *config, const char *path) {
+    char line[256];
+    char message[320];
+    int number = 0;
+    FILE *file = fopen(path, "r");
+
+    config->frame_w = 0;
+    config->frame_h = 0;
+    config->region.x = 0;
+    config->region.y = 0;
+    config->region.w = 0;
+    config->region.h = 0;
+    config->scale_x = 1;
+    config->scale_y = 1;
+    config->threshold = 0.8f;
+    config->background = 0;
+
+    if (file == NULL) {
+        snprintf(message, sizeof(message), "%s: unable to open the file", path);
+        DEBUG_ERR(message);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char key[16];
+        int parsed = 1;
+
+        number++;
+        if (sscanf(line, " %15s", key) != 1 || key[0] == '#')
+            continue;
+
+        if (strcmp(key, "frame") == 0)
+            parsed = sscanf(line, " frame %d %d", &config->frame_w, &config->frame_h) == 2;
+        else if (strcmp(key, "region") == 0)
+            parsed = sscanf(line, " region %d %d %d %d", &config->region.x, &config->region.y,
+                            &config->region.w, &config->region.h) == 4;
+        else if (strcmp(key, "scale") == 0)
+            parsed = sscanf(line, " scale %f %f", &config->scale_x, &config->scale_y) == 2
+                     && config->scale_x > 0 && config->scale_y > 0;
+        else if (strcmp(key, "threshold") == 0)
+            parsed = sscanf(line, " threshold %f", &config->threshold) == 1;
+        else if (strcmp(key, "background") == 0)
+            parsed = sscanf(line, " background %d", &config->background) == 1;
+        else
+            parsed = 0;
+
+        if (parsed == 0) {
+            fclose(file);
+            snprintf(message, sizeof(message), "%s:%d: expected frame, region, scale, threshold or background",
+                     path, number);
+            DEBUG_ERR(message);
+            return -1;
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Reads exactly length bytes from the input, giving up if we're asked to quit while waiting
+ * @param vision struct Vision*
+ * @param into void*
+ * @param length size_t
+ * @return int
+ * 0 on success, -1 at the end of the input (or on quit)
+ ***********************************************/
+int GV_Read(struct Vision *vision, void *into, size_t length) {
+    Uint8 *at = into;
+
+    while (length > 0) {
+#ifdef _WIN32
+        size_t got = fread(at, 1, length, vision->input);
+
+        if (got == 0)
+            return -1;
+#else
+        struct pollfd ready = { fileno(vision->input), POLLIN, 0 };
+        ssize_t got;
+
+        if (SDL_AtomicGet(&vision->quit))
+            return -1;
+        if (poll(&ready, 1, GV_WAIT_MS) <= 0)
+            continue;
+        got = read(ready.fd, at, length);
+        if (got <= 0)
+            return -1;
+#endif
+        at += got;
+        length -= (size_t)got;
+    }
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Reads a header line up to and including its '\n', cut to fit
+ * @param vision struct Vision*
+ * @param line char*
+ * @param length size_t
+ * @return int
+ * 0 on success, -1 at the end of the input
+ ***********************************************/
+int GV_ReadLine(struct Vision *vision, char *line, size_t length) {
+    size_t used = 0;
+    char c;
+
+    do {
+        if (GV_Read(vision, &c, 1) != 0)
+            return -1;
+        if (used + 1 < length)
+            line[used++] = c;
+    } while (c != '\n');
+
+    line[used] = '\0';
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Works out the frame size, from the .y4m header or vision.cfg, and sizes everything for it
+ * @param vision struct Vision*
+ * @return int
+ * 0 on success, -1 on failure (reported)
+ ***********************************************/
+int GV_OpenStream(struct Vision *vision) {
+    struct VisionConfig *config = &vision->config;
+    SDL_Rect *region = &config->region;
+    char header[512];
+    char chroma[16] = "420";
+    size_t luma;
+
+    if (vision->y4m) {
+        if (GV_ReadLine(vision, header, sizeof(header)) != 0 || strncmp(header, "YUV4MPEG2 ", 10) != 0) {
+            DEBUG_ERR("The video input isn't YUV4MPEG2");
+            return -1;
+        }
+        for (char *token = strtok(header + 10, " \n"); token != NULL; token = strtok(NULL, " \n")) {
+            if (token[0] == 'W')
+                vision->frame_w = atoi(token + 1);
+            else if (token[0] == 'H')
+                vision->frame_h = atoi(token + 1);
+            else if (token[0] == 'C')
+                snprintf(chroma, sizeof(chroma), "%s", token + 1);
+        }
+    } else {
+        vision->frame_w = config->frame_w;
+        vision->frame_h = config->frame_h;
+    }
+
+    if (vision->frame_w <= 0 || vision->frame_h <= 0) {
+        DEBUG_ERR("No frame size for the video input, raw RGB needs 'frame <w> <h>' in vision.cfg");
+        return -1;
+    }
+
+    // Only luma is used, the chroma planes are just skipped over
+    luma = (size_t)vision->frame_w * vision->frame_h;
+    if (vision->y4m == 0)
+        vision->frame_bytes = luma * 3;
+    else if (strncmp(chroma, "mono", 4) == 0)
+        vision->frame_bytes = luma;
+    else if (strncmp(chroma, "444", 3) == 0)
+        vision->frame_bytes = luma * 3;
+    else if (strncmp(chroma, "422", 3) == 0)
+        vision->frame_bytes = luma + (size_t)((vision->frame_w + 1) / 2) * vision->frame_h * 2;
+    else
+        vision->frame_bytes = luma + (size_t)((vision->frame_w + 1) / 2) * ((vision->frame_h + 1) / 2) * 2;
+
+    // No region is the whole frame
+    if (region->w <= 0 || region->h <= 0) {
+        region->x = 0;
+        region->y = 0;
+        region->w = vision->frame_w;
+        region->h = vision->frame_h;
+    }
+    if (region->x < 0 || region->y < 0 || region->x + region->w > vision->frame_w
+        || region->y + region->h > vision->frame_h) {
+        DEBUG_ERR("The vision region doesn't fit in the video frame");
+        return -1;
+    }
+
+    vision->frame = malloc(vision->frame_bytes);
+    vision->scores = malloc(sizeof(Uint16) * (region->w + 1));
+    if (vision->frame == NULL || vision->scores == NULL || GV_InitLevels(vision->level, region->w, region->h) != 0) {
+        DEBUG_ERR("Out of memory starting the video input");
+        return -1;
+    }
+
+    for (int t = 0; t < vision->total_templates; t++) {
+        struct VisionTemplate *tmpl = &vision->templates[t];
+
+        // The coarsest level where both are still big enough to tell things apart
+        tmpl->coarse = 0;
+        while (tmpl->coarse + 1 < GV_LEVELS && tmpl->level[tmpl->coarse + 1].w >= GV_MIN_COARSE
+               && tmpl->level[tmpl->coarse + 1].h >= GV_MIN_COARSE
+               && vision->level[tmpl->coarse + 1].w >= tmpl->level[tmpl->coarse + 1].w
+               && vision->level[tmpl->coarse + 1].h >= tmpl->level[tmpl->coarse + 1].h)
+            tmpl->coarse++;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Reads the next frame and puts its region's luma into level 0
+ * @param vision struct Vision*
+ * @return int
+ * 0 on success, -1 at the end of the input
+ ***********************************************/
+int GV_ReadFrame(struct Vision *vision) {
+    const SDL_Rect *region = &vision->config.region;
+    struct LumaPlane *luma = &vision->level[0];
+    char header[256];
+
+    if (vision->y4m && (GV_ReadLine(vision, header, sizeof(header)) != 0 || strncmp(header, "FRAME", 5) != 0))
+        return -1;
+    if (GV_Read(vision, vision->frame, vision->frame_bytes) != 0)
+        return -1;
+
+    for (int y = 0; y < luma->h; y++) {
+        Uint8 *out = luma->pixels + (size_t)y * luma->w;
+
+        if (vision->y4m) {
+            memcpy(out, vision->frame + (size_t)(region->y + y) * vision->frame_w + region->x, (size_t)luma->w);
+            continue;
+        }
+
+        const Uint8 *rgb = vision->frame + ((size_t)(region->y + y) * vision->frame_w + region->x) * 3;
+        for (int x = 0; x < luma->w; x++, rgb += 3)
+            out[x] = (Uint8)((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8);
+    }
+
+    for (int l = 1; l < GV_LEVELS; l++)
+        GV_Halve(&vision->level[l - 1], &vision->level[l]);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Cuts an item's icon out of the sheet, scaled to the capture, and gets it ready for matching
+ * @param vision struct Vision*
+ * @param name const char*
+ * @param sheet SDL_Surface* SDL_PIXELFORMAT_RGBA32
+ * @param from const SDL_Rect* the icon in the sheet
+ * @return int
+ * 0 on success, 1 if the icon is blank (skipped), -1 if we're out of memory
+ ***********************************************/
+int GV_AddTemplate(struct Vision *vision, const char *name, SDL_Surface *sheet, const SDL_Rect *from) {
+    const struct VisionConfig *config = &vision->config;
+    struct VisionTemplate *tmpl;
+    struct LumaPlane *full;
+    int w = (int)(from->w * config->scale_x + 0.5f);
+    int h = (int)(from->h * config->scale_y + 0.5f);
+    Sint64 total = 0;
+    int mean;
+
+    if (w < 1 || h < 1)
+        return 1;
+
+    if (vision->total_templates == vision->capacity) {
+        int capacity = (vision->capacity > 0) ? vision->capacity * 2 : 32;
+        struct VisionTemplate *grown = realloc(vision->templates, sizeof(struct VisionTemplate) * capacity);
+
+        if (grown == NULL)
+            return -1;
+        vision->templates = grown;
+        vision->capacity = capacity;
+    }
+
+    tmpl = &vision->templates[vision->total_templates];
+    memset(tmpl, 0, sizeof(*tmpl));
+    snprintf(tmpl->name, sizeof(tmpl->name), "%s", name);
+    tmpl->slot = -1;
+    tmpl->centered = malloc(sizeof(Sint16) * w * h);
+    if (tmpl->centered == NULL || GV_InitLevels(tmpl->level, w, h) != 0) {
+        free(tmpl->centered);
+        GV_DestroyLevels(tmpl->level);
+        return -1;
+    }
+
+    // Nearest neighbour from the sheet, sampled at pixel centers
+    full = &tmpl->level[0];
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            int sx = from->x + (int)((x + 0.5f) / config->scale_x);
+            int sy = from->y + (int)((y + 0.5f) / config->scale_y);
+            const Uint8 *p = (const Uint8 *)sheet->pixels + (size_t)sy * sheet->pitch + (size_t)sx * 4;
+            int value = config->background;
+
+            if (sx < sheet->w && sy < sheet->h && p[3] >= 128)
+                value = (77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8;
+            full->pixels[y * w + x] = (Uint8)value;
+            total += value;
+        }
+
+    mean = (int)(total / (w * h));
+    tmpl->energy = 0;
+    for (int i = 0; i < w * h; i++) {
+        tmpl->centered[i] = (Sint16)(full->pixels[i] - mean);
+        tmpl->energy += (double)tmpl->centered[i] * tmpl->centered[i];
+    }
+
+    // Flat, it would match any flat patch of the screen
+    if (tmpl->energy < 1) {
+        free(tmpl->centered);
+        GV_DestroyLevels(tmpl->level);
+        return 1;
+    }
+
+    for (int l = 1; l < GV_LEVELS; l++)
+        GV_Halve(&tmpl->level[l - 1], &tmpl->level[l]);
+    vision->total_templates++;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Lowest SAD position of a template level within a range of positions, clamped to the region
+ * @param vision struct Vision*
+ * @param tmpl const struct VisionTemplate*
+ * @param l int level
+ * @param x0 int
+ * @param y0 int
+ * @param x1 int inclusive
+ * @param y1 int inclusive
+ * @param best SDL_Point* receives the position
+ * @return int
+ * 0 on success, -1 if the template doesn't fit anywhere in the range
+ ***********************************************/
+int GV_BestSad(struct Vision *vision, const struct VisionTemplate *tmpl, int l, int x0, int y0, int x1, int y1,
+               SDL_Point *best) {
+    const struct LumaPlane *image = &vision->level[l];
+    const struct LumaPlane *t = &tmpl->level[l];
+    Uint32 lowest = 0xFFFFFFFF;
+
+    x0 = (x0 < 0) ? 0 : x0;
+    y0 = (y0 < 0) ? 0 : y0;
+    x1 = (x1 > image->w - t->w) ? image->w - t->w : x1;
+    y1 = (y1 > image->h - t->h) ? image->h - t->h : y1;
+    if (x1 < x0 || y1 < y0)
+        return -1;
+
+    for (int y = y0; y <= y1; y++) {
+        int n = x1 - x0 + 1;
+
+        GV_KERNELS.sad(image->pixels + (size_t)y * image->w + x0, image->w, t->pixels, t->w, t->h, n,
+                       vision->scores);
+        for (int k = 0; k < n; k++)
+            if (vision->scores[k] < lowest) {
+                lowest = vision->scores[k];
+                best->x = x0 + k;
+                best->y = y;
+            }
+    }
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Normalized cross-correlation of the full size template with the region at x, y
+ * @param vision const struct Vision*
+ * @param tmpl const struct VisionTemplate*
+ * @param x int
+ * @param y int
+ * @return double
+ * -1 to 1, 0 where the region is flat
+ ***********************************************/
+double GV_Correlate(const struct Vision *vision, const struct VisionTemplate *tmpl, int x, int y) {
+    const struct LumaPlane *image = &vision->level[0];
+    int w = tmpl->level[0].w;
+    int h = tmpl->level[0].h;
+    double n = (double)w * h;
+    double variance;
+    Sint64 sums[3] = { 0, 0, 0 };
+
+    for (int row = 0; row < h; row++)
+        GV_KERNELS.correlate(image->pixels + (size_t)(y + row) * image->w + x, tmpl->centered + row * w, w, sums);
+
+    // sum((I - mean) * T') is sum(I * T'), T' already sums to (nearly) 0
+    variance = (double)sums[1] - (double)sums[0] * (double)sums[0] / n;
+    if (variance < 1)
+        return 0;
+    return (double)sums[2] / SDL_sqrt(variance * tmpl->energy);
+}
+
+/********************************************//**
+ * @brief
+ * Best correlation within radius of x, y at full size
+ * @param vision const struct Vision*
+ * @param tmpl const struct VisionTemplate*
+ * @param x int
+ * @param y int
+ * @param radius int
+ * @param best SDL_Point* receives the position
+ * @return double
+ * the score there, -1 if the template doesn't fit
+ ***********************************************/
+double GV_BestCorrelation(const struct Vision *vision, const struct VisionTemplate *tmpl, int x, int y, int radius,
+                          SDL_Point *best) {
+    const struct LumaPlane *image = &vision->level[0];
+    double highest = -1;
+
+    for (int dy = -radius; dy <= radius; dy++)
+        for (int dx = -radius; dx <= radius; dx++) {
+            double score;
+
+            if (x + dx < 0 || y + dy < 0 || x + dx + tmpl->level[0].w > image->w
+                || y + dy + tmpl->level[0].h > image->h)
+                continue;
+
+            score = GV_Correlate(vision, tmpl, x + dx, y + dy);
+            if (score > highest) {
+                highest = score;
+                best->x = x + dx;
+                best->y = y + dy;
+            }
+        }
+    return highest;
+}
+
+/********************************************//**
+ * @brief
+ * Looks for an item over the whole region, coarse to fine
+ * @param vision struct Vision*
+ * @param tmpl const struct VisionTemplate*
+ * @param found SDL_Point* receives where it's most likely to be, at full size
+ * @return double
+ * the correlation there, -1 if the template doesn't fit in the region
+ ***********************************************/
+double GV_Locate(struct Vision *vision, const struct VisionTemplate *tmpl, SDL_Point *found) {
+    SDL_Point best;
+    int l = tmpl->coarse;
+
+    if (GV_BestSad(vision, tmpl, l, 0, 0, vision->level[l].w, vision->level[l].h, &best) != 0)
+        return -1;
+
+    for (l--; l > 0; l--) {
+        int x = best.x * 2;
+        int y = best.y * 2;
+
+        if (GV_BestSad(vision, tmpl, l, x - GV_REFINE_RADIUS, y - GV_REFINE_RADIUS,
+                       x + GV_REFINE_RADIUS, y + GV_REFINE_RADIUS, &best) != 0)
+            return -1;
+    }
+
+    if (tmpl->coarse == 0)
+        return GV_BestCorrelation(vision, tmpl, best.x, best.y, 0, found);
+    return GV_BestCorrelation(vision, tmpl, best.x * 2, best.y * 2, GV_REFINE_RADIUS, found);
+}
+
+/********************************************//**
+ * @brief
+ * Counts a frame an item was or wasn't found in towards its detection
+ * @param tmpl struct VisionTemplate*
+ * @param found int
+ * @return void
+ ***********************************************/
+void GV_Observe(struct VisionTemplate *tmpl, int found) {
+    if (found == 0) {
+        tmpl->tracked = 0;
+        tmpl->streak = 0;
+        tmpl->seen = 0;
+        return;
+    }
+
+    tmpl->tracked = 1;
+    if (++tmpl->streak >= GV_CONFIRM_FRAMES && tmpl->seen == 0) {
+        tmpl->seen = 1;
+        SDL_AtomicAdd(&tmpl->detected, 1);
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Follows the items in view and searches for a few of the others, in the frame in level 0
+ * @param vision struct Vision*
+ * @return void
+ ***********************************************/
+void GV_ProcessFrame(struct Vision *vision) {
+    double threshold = vision->config.threshold;
+    int searches = 0;
+    SDL_Point at;
+
+    for (int t = 0; t < vision->total_templates; t++) {
+        struct VisionTemplate *tmpl = &vision->templates[t];
+
+        if (tmpl->tracked == 0)
+            continue;
+        if (GV_BestCorrelation(vision, tmpl, tmpl->x, tmpl->y, GV_TRACK_RADIUS, &at) >= threshold) {
+            tmpl->x = at.x;
+            tmpl->y = at.y;
+            GV_Observe(tmpl, 1);
+        } else {
+            GV_Observe(tmpl, 0);
+        }
+    }
+
+    for (int k = 0; k < vision->total_templates && searches < GV_SEARCHES_PER_FRAME; k++) {
+        struct VisionTemplate *tmpl = &vision->templates[vision->next_search];
+
+        vision->next_search = (vision->next_search + 1) % vision->total_templates;
+        if (tmpl->tracked)
+            continue;
+
+        searches++;
+        if (GV_Locate(vision, tmpl, &at) >= threshold) {
+            tmpl->x = at.x;
+            tmpl->y = at.y;
+            GV_Observe(tmpl, 1);
+        }
+    }
+}
+
+/********************************************//**
+ * @brief
+ * The reader thread, matches every frame of the input until it ends or we quit
+ * @param data void* the struct Vision
+ * @return int
+ ***********************************************/
+int GV_VisionThread(void *data) {
+    struct Vision *vision = data;
+    char message[128];
+
+    if (GV_OpenStream(vision) != 0)
+        return -1;
+
+    while (SDL_AtomicGet(&vision->quit) == 0 && GV_ReadFrame(vision) == 0) {
+        Uint64 started = SDL_GetPerformanceCounter();
+
+        GV_ProcessFrame(vision);
+        vision->busy_ms += (double)(SDL_GetPerformanceCounter() - started) * 1000.0
+                           / (double)SDL_GetPerformanceFrequency();
+        vision->frames++;
+    }
+
+    snprintf(message, sizeof(message), "Video input done, %llu frames at %.3f ms each (%s kernels)",
+             (unsigned long long)vision->frames, (vision->frames > 0) ? vision->busy_ms / vision->frames : 0.0,
+             GV_KERNELS.name);
+    DEBUG_LOG(message);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Loads vision.cfg and opens the input. Add the templates, then GV_StartVision.
+ * @param vision struct Vision*
+ * @param path const char* vision.cfg
+ * @param source const char* .y4m or raw RGB24 file or pipe, "-" for stdin
+ * @return int
+ * 0 on success, -1 on failure (reported)
+ ***********************************************/
+int GV_InitVision(struct Vision *vision, const char *path, const char *source) {
+    size_t length = strlen(source);
+
+    memset(vision, 0, sizeof(*vision));
+    GV_InitKernels();
+    if (GV_LoadConfig(&vision->config, path) != 0)
+        return -1;
+
+    // stdin has to say which it is, "-" is y4m unless vision.cfg gave a raw frame size
+    vision->y4m = (length > 4 && strcmp(source + length - 4, ".y4m") == 0)
+                  || (strcmp(source, "-") == 0 && vision->config.frame_w == 0);
+    vision->input = (strcmp(source, "-") == 0) ? stdin : fopen(source, "rb");
+    if (vision->input == NULL) {
+        DEBUG_ERR("Unable to open the video input");
+        return -1;
+    }
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Starts matching on a thread of its own
+ * @param vision struct Vision*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GV_StartVision(struct Vision *vision) {
+    vision->thread = SDL_CreateThread(GV_VisionThread, "vision", vision);
+    if (vision->thread == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+void GV_DestroyVision(struct Vision *vision) {
+    if (vision->thread != NULL) {
+        SDL_AtomicSet(&vision->quit, 1);
+        SDL_WaitThread(vision->thread, NULL);
+    }
+    if (vision->input != NULL && vision->input != stdin)
+        fclose(vision->input);
+
+    for (int t = 0; t < vision->total_templates; t++) {
+        free(vision->templates[t].centered);
+        GV_DestroyLevels(vision->templates[t].level);
+    }
+    free(vision->templates);
+    free(vision->frame);
+    free(vision->scores);
+    GV_DestroyLevels(vision->level);
+    memset(vision, 0, sizeof(*vision));
+}
+
+#endif //ZELDATRACKER_GAMEVISION_H
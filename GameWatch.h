@@ -0,0 +1,168 @@
+#ifndef ZELDATRACKER_GAMEWATCH_H
+#define ZELDATRACKER_GAMEWATCH_H
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+/*
+ * Notices when files we loaded change on disk. On Linux the directories holding them are watched
+ * with inotify (directories, not the files, since editors like to save by writing a new file and
+ * renaming it over the old one), anywhere else the files are stat'ed every GW_POLL_MS. Either way
+ * a change is only reported once the file has been left alone for GW_SETTLE_MS, so a save that
+ * lands in several writes comes out as one change.
+ *
+ * GW_Poll never blocks, it's cheap enough to call every frame.
+ */
+
+#define GW_MAX_FILES 8
+#define GW_PATH_LENGTH 256
+
+const Uint32 GW_POLL_MS = 500;
+const Uint32 GW_SETTLE_MS = 150;
+
+struct FileWatch {
+    int total_files;
+    char paths[GW_MAX_FILES][GW_PATH_LENGTH];
+    const char *names[GW_MAX_FILES];        // past the last '/' in paths
+    Sint64 mtime[GW_MAX_FILES];
+    Sint64 size[GW_MAX_FILES];
+    Uint32 pending;                         // bit per file, changed but not settled yet
+    Uint32 changed_at;
+    Uint32 polled_at;
+#ifdef __linux__
+    int inotify;
+    int watches[GW_MAX_FILES];              // directory watch of each file
+#endif
+};
+
+
+/********************************************//**
+ * @brief
+ * Starts watching, bit i of what GW_Poll returns is paths[i]
+ * @param watch struct FileWatch*
+ * @param paths const char**
+ * @param total_files int no more than GW_MAX_FILES
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int GW_InitWatch(struct FileWatch *watch, const char **paths, int total_files) {
+    memset(watch, 0, sizeof(*watch));
+#ifdef __linux__
+    watch->inotify = -1;
+#endif
+    if (total_files > GW_MAX_FILES)
+        return -1;
+
+    watch->total_files = total_files;
+    for (int i = 0; i < total_files; i++) {
+        const char *slash;
+
+        snprintf(watch->paths[i], GW_PATH_LENGTH, "%s", paths[i]);
+        slash = strrchr(watch->paths[i], '/');
+        watch->names[i] = (slash != NULL) ? slash + 1 : watch->paths[i];
+        GCF_StatFile(watch->paths[i], &watch->mtime[i], &watch->size[i]);
+    }
+    watch->polled_at = SDL_GetTicks();
+
+#ifdef __linux__
+    watch->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->inotify == -1) {
+        DEBUG_ERR("inotify is unavailable, falling back to polling");
+        return 0;
+    }
+
+    for (int i = 0; i < total_files; i++) {
+        char directory[GW_PATH_LENGTH] = ".";
+
+        if (watch->names[i] != watch->paths[i])
+            snprintf(directory, sizeof(directory), "%.*s",
+                     (int)(watch->names[i] - watch->paths[i] - 1), watch->paths[i]);
+        // Watching the same directory twice hands back the same descriptor
+        watch->watches[i] = inotify_add_watch(watch->inotify, directory,
+                                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    }
+#endif
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Marks the files that changed since the last look as pending
+ * @param watch struct FileWatch*
+ * @param now Uint32 SDL_GetTicks
+ * @return void
+ ***********************************************/
+void GW_Collect(struct FileWatch *watch, Uint32 now) {
+#ifdef __linux__
+    if (watch->inotify != -1) {
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length;
+
+        while ((length = read(watch->inotify, buffer, sizeof(buffer))) > 0) {
+            for (char *at = buffer; at < buffer + length;) {
+                const struct inotify_event *event = (const struct inotify_event *)at;
+
+                for (int i = 0; i < watch->total_files; i++)
+                    if (event->wd == watch->watches[i] && event->len > 0
+                        && strcmp(event->name, watch->names[i]) == 0) {
+                        watch->pending |= 1u << i;
+                        watch->changed_at = now;
+                    }
+                at += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return;
+    }
+#endif
+
+    if (now - watch->polled_at < GW_POLL_MS)
+        return;
+    watch->polled_at = now;
+
+    for (int i = 0; i < watch->total_files; i++) {
+        Sint64 mtime, size;
+
+        if (GCF_StatFile(watch->paths[i], &mtime, &size) != 0)
+            continue;
+        if (mtime != watch->mtime[i] || size != watch->size[i]) {
+            watch->mtime[i] = mtime;
+            watch->size[i] = size;
+            watch->pending |= 1u << i;
+            watch->changed_at = now;
+        }
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Which files changed and have since settled
+ * @param watch struct FileWatch*
+ * @return Uint32
+ * bit i set if paths[i] changed, 0 if nothing did
+ ***********************************************/
+Uint32 GW_Poll(struct FileWatch *watch) {
+    Uint32 now = SDL_GetTicks();
+    Uint32 settled;
+
+    GW_Collect(watch, now);
+    if (watch->pending == 0 || now - watch->changed_at < GW_SETTLE_MS)
+        return 0;
+
+    settled = watch->pending;
+    watch->pending = 0;
+    return settled;
+}
+
+void GW_DestroyWatch(struct FileWatch *watch) {
+#ifdef __linux__
+    if (watch->inotify != -1)
+        close(watch->inotify);
+#endif
+    memset(watch, 0, sizeof(*watch));
+}
+
+#endif //ZELDATRACKER_GAMEWATCH_H
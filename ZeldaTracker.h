@@ -0,0 +1,2845 @@
+#ifndef ZELDATRACKER_ZELDATRACKER_H
+#define ZELDATRACKER_ZELDATRACKER_H
+
+#include "GameFonts.h"
+#ifdef ZT_EMBEDDED_FONT
+#include "EmbeddedFont.h"
+#endif
+#include "Debug.h"
+#include "GameElements.h"
+#include "GameRaster.h"
+#include "GameAtlas.h"
+#include "GameMath.h"
+#include "GameTimer.h"
+#include "GameStartup.h"
+#include "GameAnimation.h"
+#include "GameCompositor.h"
+#include "GameBatch.h"
+#include "GameText.h"
+#include "GameProfiler.h"
+#include "GameLayout.h"
+#include "GameMap.h"
+#include "GameRing.h"
+#include "GameJournal.h"
+#include "GameHistory.h"
+#include "GameServer.h"
+#include "GameConfig.h"
+#include "GameRam.h"
+#include "GameVision.h"
+#include "GameWatch.h"
+#include "GameExport.h"
+
+#define ZT_TOTAL_DUNGEONS 9
+
+const int WINDOW_WIDTH = 200;
+const int WINDOW_HEIGHT = 720;
+const int TOTAL_SPRITES = 22;
+const int SPRITE_HEIGHT = 48;
+const int SPRITE_WIDTH = 48;
+const int ITEMS_TOP = 376;      // y of the first row of items
+const int ITEMS_ROW_GAP = 16;   // space between rows of items
+const float UPDATES_PER_SECOND = 60;
+const Uint32 ZT_RENDER_IDLE_MS = 100;   // render thread checks for shutdown at least this often
+
+// How ZT_InitTracker runs the renderer, SOFTWARE and HEADLESS can be or'd into either
+const int ZT_RENDER_INLINE = 0;         // ZT_Frame renders on the calling thread
+const int ZT_RENDER_THREADED = 1;       // a render thread owns the renderer, ZT_Frame only publishes
+const int ZT_RENDER_SOFTWARE = 2;       // no SDL_Renderer, drawn on the CPU into the window surface
+const int ZT_RENDER_HEADLESS = 4;       // the window is never shown, frames only go out through ZT_StartExport
+
+#define ZT_MAX_RUNNERS 8                // race mode, trackers side by side in one window
+const SDL_Point ZT_MAP_AT = { 6, 20 };  // map panel, right of a runner's items (see GameMap.h)
+const char *ZT_MAP_JOURNAL_SUFFIX = ".maps";
+
+const double ZT_OVERLAY_REFRESH_MS = 250;   // profiling overlay redraws at least this often
+const int ZT_OVERLAY_TEXT_HEIGHT = 8;
+const char *ZT_PROFILE_PATH = "profile.csv";
+
+// Files ZT_WatchFiles keeps an eye on, as bits of what GW_Poll returns
+const Uint32 ZT_WATCH_SPRITES = 0x01;
+const Uint32 ZT_WATCH_SHEET = 0x02;
+#define ZT_MAX_SHEET_CHANGES 64     // re-uploaded rects tracked per reload, past that everything redraws
+
+// Link's frames by facing (0 = left, 1 = down, 2 = right, 3 = up), straight out of the atlas
+const int LINK_WALK_FRAMES[4][2] = {
+        { GA_LINK_LEFT_0, GA_LINK_LEFT_1 },
+        { GA_LINK_DOWN_0, GA_LINK_DOWN_1 },
+        { GA_LINK_RIGHT_0, GA_LINK_RIGHT_1 },
+        { GA_LINK_UP_0, GA_LINK_UP_1 }
+};
+const int LINK_STAB_FRAMES[4] = { GA_LINK_STAB_LEFT, GA_LINK_STAB_DOWN, GA_LINK_STAB_RIGHT, GA_LINK_STAB_UP };
+// The sword sticks out in front of him, facing left or up he's moved back to make room
+const SDL_Point LINK_STAB_OFFSET[4] = { { -12, 0 }, { 0, 0 }, { 0, 0 }, { 0, -12 } };
+#define LINK_STAB_UPDATES 15
+
+// Link's walk around the board, counter-clockwise from the top right, one px per update
+const struct PathKey LINK_PATROL[4] = {
+        { 170, 30, 0 },
+        { 80, 30, 1 },
+        { 80, 348, 2 },
+        { 170, 348, 3 }
+};
+
+/*
+ * What the render side has to catch up on after sprites.cfg or the sheet changed. The state side
+ * fills it in while the renderer is paused (ZT_Reload), ZT_ApplyReload works through it before
+ * the next frame.
+ */
+struct ReloadPlan {
+    int pending;
+    int sheet;              // the sheet changed, re-upload whatever rects moved
+    int resized;            // the number of slots changed, every layer starts over
+    int *slots;             // slots that moved, changed picture or were switched on/off
+    SDL_Rect *was_at;       // where each of them was drawn before
+    int total;
+    int capacity;
+};
+
+/*
+ * Everything the tracker needs from one frame to the next. main() owns one of these and runs
+ * it against the real window, the frame benchmark drives the same functions headless.
+ *
+ * The state side (events, ZT_Update, the sprite store's state/tag columns, the clock) belongs
+ * to the thread calling ZT_Frame. The render side (renderer, atlas, text, compositor, batch)
+ * belongs to whoever renders, and only ever sees the state through FrameSnapshots. The sprite
+ * store's x/y/frm columns are written during init and read-only after, both sides use them,
+ * except during a reload when the renderer is parked (ZT_Reload).
+ */
+struct Tracker {
+    struct Scene scene;
+    TTF_Font *game_font;
+    struct GlyphAtlas text;     // every string on screen comes out of this
+    struct Atlas atlas;
+
+    // Everything clickable. [0, ZT_TOTAL_DUNGEONS) are the triforces, sprites.cfg entry i is
+    // ZT_TOTAL_DUNGEONS + i (entry 0 is the triforce, it only supplies the sheet coords). The
+    // dense index doubles as the compositor slot and the hit grid id.
+    //
+    // In a race every runner gets a block of runner_slots laid out the same way, runner r's
+    // tile tile_w further right (see ZT_CloneRunners). Runner 0 is the one the config is laid
+    // out for, the others are copies of its places and pictures with their own state and tags.
+    // Everything else (atlas, text, layers, hit grid, the render pass) is shared.
+    struct SpriteConfig sprite_config;
+    struct SpriteStore sprites;
+    int total_sprites;      // sprites.cfg entries
+    int runners;
+    int runner_slots;       // ZT_TOTAL_DUNGEONS + total_sprites
+    int tile_w;             // logical width of a runner's tile
+
+    SDL_Point dungeon_at[ZT_TOTAL_DUNGEONS];    // where the dungeon numbers go
+    int track_for_dungeon;
+
+    SDL_Rect link_walk_frm;
+    SDL_Rect link_walk_to;
+    SDL_Rect cursor;
+    SDL_Rect cursor_draw_at;
+    SDL_Rect font_draw_rect;
+    SDL_Rect item_track_to;
+
+    // Everything above is placed in logical units (scene.w x scene.h), layout says where that
+    // lands on the window. The state side refits it when the window changes size or density,
+    // the render side places every slot in pixels once per new layout (ZT_ApplyLayout).
+    struct Layout layout;
+    struct Layout placed;           // render side, what draw_to was worked out for
+    SDL_Rect *draw_to;              // render side, per slot, in pixels
+    SDL_Rect *draw_frm;             // render side, per slot, in item_texture
+    SDL_Texture *item_texture;      // atlas pre-scaled so items copy 1:1
+    int item_factor;
+    SDL_Texture *sprite_texture;    // atlas pre-scaled for link and the cursor
+    int sprite_factor;
+
+    // Software rendering (ZT_RENDER_SOFTWARE, or no accelerated renderer to be had): the same
+    // layers and damage, blitted out of atlas.raster by GameRaster.h's kernels
+    int software;
+    struct Raster screen;           // the window surface, or a stand-in if it isn't ARGB8888
+
+    // Render side, every presented frame is read back into here (see ZT_StartExport)
+    struct FrameExport export;
+    int exporting;
+
+    // Cached layers, slots [0, ZT_TOTAL_DUNGEONS) are the triforces and the items follow
+    struct Compositor compositor;
+    struct SpriteBatch sprite_batch;
+    int *changed;           // slots to redraw this frame
+    int *tagged_items;
+    int total_tagged;
+    Uint32 layers_lost;     // bumped when the renderer drops its targets, travels with the snapshots
+    Uint32 layers_seen;     // render side, the last layers_lost it rebuilt for
+
+    // State -> render hand-off
+    struct SnapshotRing ring;
+    int threaded;
+    SDL_Thread *render_thread;
+    SDL_sem *render_ready;
+    SDL_atomic_t render_failed; // render side, read by the state side to give up
+    SDL_atomic_t render_quit;
+    SDL_atomic_t render_pause;  // the state side wants the renderer parked (ZT_PauseRenderer)
+    SDL_sem *render_paused;
+    SDL_sem *render_resume;
+    SDL_atomic_t presented;     // render side sets it once the first frame is on screen
+    Uint64 first_presented_at;  // render side, counter at that present, good once presented is set
+    SDL_sem *layout_ready;      // the state side has laid out the items, ZT_InitRenderer can go on
+
+    // Cold start, the font and sprites.cfg load on workers while the window comes up (see GameStartup.h)
+    struct StartupJob font_job;
+    struct StartupJob config_job;
+    SDL_Surface *glyph_sheet;       // rasterized by font_job, uploaded by ZT_InitRenderer
+    SDL_Surface *preloaded_sheet;   // decoded by config_job if sprites.cfg needs unpacked cells
+    char config_error[256];
+
+    // Hot reload of sprites.cfg and the sheet (see ZT_WatchFiles)
+    char sprites_path[GW_PATH_LENGTH];
+    struct FileWatch watch;
+    int watching;
+    struct ReloadPlan reload;
+
+    // Profiling (F3 shows the overlay, F4 dumps the CSV). The Profiler itself is render side,
+    // the state side's phases and clicks reach it through the snapshots
+    int profiling;
+    float state_ms[GP_STATE_PHASES];    // since the last published frame
+    double next_overlay_at;
+    Uint64 pressed_at;      // counter at the last mouse button down
+    Uint64 clicked_at;      // oldest toggle not yet known to be on screen, 0 for none
+    Uint32 clicked_in;      // sequence of the first snapshot carrying clicked_at
+    int click_published;
+    Uint32 dumps_requested;
+    struct Profiler profiler;
+    Uint64 presented_at;    // render side, counter after the last profiled present
+    Uint64 clicked_seen;
+    Uint32 dumps_done;
+
+    // State side, every click and tag goes out to disk from here (see ZT_OpenJournal)
+    struct Journal journal;
+    int journaling;
+
+    // State side, overlays hear about every click and tag from here (see ZT_StartServer)
+    struct StateServer server;
+    int serving;
+    Uint16 server_port;
+
+    // State side, runner r's items follow its emulator's RAM for r < ram_sources (see ZT_TrackRam)
+    struct RamWatch ram[ZT_MAX_RUNNERS];
+    int ram_sources;
+
+    // Same again from captured video, for r < video_sources (see ZT_WatchVideo)
+    struct Vision vision[ZT_MAX_RUNNERS];
+    int video_sources;
+
+    // Hit-testing, ids are the same slot numbers the compositor uses
+    struct HitGrid hit_grid;
+    int hovered;            // slot under the cursor, GM_NO_HIT if nothing
+    int cursor_moved;       // hover only gets recomputed when this or mouse_pressed is set
+
+    // Map panel right of each runner's items, off unless asked for (see GameMap.h). Marks and
+    // which dungeon is shown are state side and travel with the snapshots, the chunks are render side.
+    int showing_maps;
+    struct MapState maps;
+    int map_hovered;        // cell under the cursor, -1 if none
+    Uint8 map_toggles;      // GMP_SHOP/GMP_KEY asked for since the last update
+    struct Journal map_journal;
+    int map_journaling;
+    struct MapCache map_cache;
+
+    struct FrameClock clock;
+    int mouse_pressed;
+    struct History history;
+    int *history_changed;   // slots an undo/redo touched, room for every slot
+    int history_steps;      // redo (> 0) or undo (< 0) asked for since the last update
+    struct Path link_path;
+    struct Hold link_stab;  // the walk stands still while he stabs
+    int redraw;
+    int quit;
+};
+
+
+/********************************************//**
+ * @brief Initializes the game window.
+ *
+ * @param scene struct Scene*
+ * @param WINDOW_WIDTH int
+ * @param WINDOW_HEIGHT int
+ * @param hidden int never show the window (headless)
+ * @return void
+ *
+ ***********************************************/
+int ZT_InitGame(struct Scene *scene, int window_width,
+                int window_height, const char *window_title, int hidden) {
+    DEBUG_LOG("Initializing the Scene/Window");
+    scene->w = window_width;
+    scene->h = window_height;
+    scene->window = SDL_CreateWindow(
+             window_title,
+             SDL_WINDOWPOS_CENTERED,
+             SDL_WINDOWPOS_CENTERED,
+             scene->w,
+             scene->h,
+             (hidden ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN) | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+    SDL_ShowCursor(0);
+    if (scene->window == NULL) {
+            DEBUG_ERR(SDL_GetError());
+            return -1;
+    }
+
+    // Smaller than the layout would cut items off, any bigger scales it up (see GameLayout.h)
+    SDL_SetWindowMinimumSize(scene->window, scene->w, scene->h);
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Creates the renderer and the scene texture. Whichever thread calls this has to do all the
+ * rendering from then on. Without an accelerated renderer (or when asked to) there's neither,
+ * everything is drawn into the window surface.
+ * @param scene struct Scene*
+ * @param software int* in: draw in software anyway, out: whether we are
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_InitSceneRenderer(struct Scene *scene, int *software) {
+    char kernels[64];
+
+    scene->renderer = NULL;
+    scene->texture = NULL;
+    if (*software == 0) {
+        scene->renderer = SDL_CreateRenderer(
+                                    scene->window,
+                                    -1,
+                                    SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+        if (scene->renderer == NULL) {
+                DEBUG_ERR(SDL_GetError());
+                DEBUG_ERR("No accelerated renderer, drawing in software");
+                *software = 1;
+        }
+    }
+
+    if (*software) {
+        scene->surface = SDL_GetWindowSurface(scene->window);
+        if (scene->surface == NULL) {
+                DEBUG_ERR(SDL_GetError());
+                return -1;
+        }
+
+        snprintf(kernels, sizeof(kernels), "Software rendering with %s kernels", GX_InitKernels());
+        DEBUG_LOG(kernels);
+        return 0;
+    }
+
+    scene->surface = SDL_GetWindowSurface(scene->window);
+    if (scene->surface == NULL) {
+            DEBUG_ERR(SDL_GetError());
+            return -1;
+    }
+
+    // Uploaded once, the compositor bakes it into the background layer
+    SDL_FillRect(scene->surface, NULL, SDL_MapRGBA(scene->surface->format, 0, 0, 0, 255));
+    scene->texture = SDL_CreateTextureFromSurface(
+                                         scene->renderer,
+                                         scene->surface);
+
+    if (scene->texture == NULL) {
+            DEBUG_ERR(SDL_GetError());
+            return -1;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Makes room in a reload plan for at least capacity slots
+ * @param plan struct ReloadPlan*
+ * @param capacity int
+ * @return int
+ * 0 on success, -1 if we're out of memory (the plan is as it was)
+ ***********************************************/
+int ZT_ReservePlan(struct ReloadPlan *plan, int capacity) {
+    int *slots;
+    SDL_Rect *was_at;
+
+    if (capacity <= plan->capacity)
+        return 0;
+
+    slots = realloc(plan->slots, sizeof(int) * capacity);
+    if (slots == NULL)
+        return -1;
+    plan->slots = slots;
+
+    was_at = realloc(plan->was_at, sizeof(SDL_Rect) * capacity);
+    if (was_at == NULL)
+        return -1;
+    plan->was_at = was_at;
+
+    plan->capacity = capacity;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Adds a slot to a reload plan, along with where it was drawn
+ * @param plan struct ReloadPlan*
+ * @param slot int
+ * @param was_at SDL_Rect, w of 0 if it wasn't drawn anywhere
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int ZT_PlanSlot(struct ReloadPlan *plan, int slot, SDL_Rect was_at) {
+    if (plan->total == plan->capacity && ZT_ReservePlan(plan, plan->capacity * 2 + 16) != 0)
+        return -1;
+
+    plan->slots[plan->total] = slot;
+    plan->was_at[plan->total] = was_at;
+    plan->total++;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Puts one slot somewhere, with a plan it's added to the plan if that changes anything
+ * @param store struct SpriteStore*
+ * @param at int slot
+ * @param x int
+ * @param y int
+ * @param col Sint16 sheet cell
+ * @param row Sint16
+ * @param disabled Uint8 SPRITE_STATE_DISABLED or 0
+ * @param plan struct ReloadPlan* may be NULL
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int ZT_PlaceSlot(struct SpriteStore *store, int at, int x, int y, Sint16 col, Sint16 row, Uint8 disabled,
+                 struct ReloadPlan *plan) {
+    if (plan != NULL && (store->x[at] != x || store->y[at] != y || store->col[at] != col
+                         || store->row[at] != row
+                         || (store->state[at] & SPRITE_STATE_DISABLED) != disabled)) {
+        SDL_Rect was_at = { store->x[at], store->y[at], SPRITE_WIDTH, SPRITE_HEIGHT };
+
+        if ((store->state[at] & SPRITE_STATE_DISABLED) == SPRITE_STATE_DISABLED)
+            was_at.w = 0;
+        if (ZT_PlanSlot(plan, at, was_at) != 0)
+            return -1;
+    }
+
+    store->x[at] = x;
+    store->y[at] = y;
+    store->col[at] = col;
+    store->row[at] = row;
+    store->state[at] = (Uint8)((store->state[at] & ~SPRITE_STATE_DISABLED) | disabled);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Lays the configured items out in rows of four under the triforces, entry i going to slot
+ * ZT_TOTAL_DUNGEONS + i. The store must already have a slot per entry. With a plan, every slot
+ * that moved, changed cell or was switched on/off is added to it.
+ * @param store struct SpriteStore*
+ * @param entries struct SpriteEntry* from GCF_LoadConfig
+ * @param total_sprites int
+ * @param plan struct ReloadPlan* NULL on the first layout
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int ZT_LayoutItems(struct SpriteStore *store, const struct SpriteEntry *entries, int total_sprites,
+                   struct ReloadPlan *plan) {
+    int cur_sprite_pos = 0;
+    int display_row = 0;
+
+    for (int cur_sprite = 0; cur_sprite < total_sprites; cur_sprite++) {
+        int at = ZT_TOTAL_DUNGEONS + cur_sprite;
+        int x = 0, y = 0;
+        Sint16 col = (Sint16)entries[cur_sprite].col;
+        Sint16 row = (Sint16)entries[cur_sprite].row;
+        Uint8 disabled = SPRITE_STATE_DISABLED;
+
+        if (entries[cur_sprite].enabled) {
+            if (((cur_sprite_pos - 1) % 4 == 0) && cur_sprite_pos != 1)
+                display_row++;
+
+            x = 10 + (((cur_sprite_pos - 1) % 4) * SPRITE_WIDTH);
+            y = ITEMS_TOP + (display_row * SPRITE_HEIGHT) + (display_row * ITEMS_ROW_GAP);
+            cur_sprite_pos++;
+
+            // Entry 0 lends its picture to the triforces and is never drawn itself
+            disabled = (cur_sprite == 0) ? SPRITE_STATE_DISABLED : 0;
+        }
+
+        if (ZT_PlaceSlot(store, at, x, y, col, row, disabled, plan) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Lays every other runner's block out like runner 0's, each a tile further right. The store
+ * must already have runners * runner_slots slots. With a plan, every copy that changed is
+ * added to it.
+ * @param store struct SpriteStore*
+ * @param runners int
+ * @param runner_slots int
+ * @param tile_w int
+ * @param plan struct ReloadPlan* NULL on the first layout
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int ZT_CloneRunners(struct SpriteStore *store, int runners, int runner_slots, int tile_w,
+                    struct ReloadPlan *plan) {
+    for (int r = 1; r < runners; r++)
+        for (int i = 0; i < runner_slots; i++)
+            if (ZT_PlaceSlot(store, r * runner_slots + i, store->x[i] + r * tile_w, store->y[i],
+                             store->col[i], store->row[i], store->state[i] & SPRITE_STATE_DISABLED, plan) != 0)
+                return -1;
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Adds the configured items to the store and lays them out
+ * @param store struct SpriteStore*
+ * @param entries struct SpriteEntry* from GCF_LoadConfig
+ * @param total_sprites int
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int ZT_InitGameSprites(struct SpriteStore *store, const struct SpriteEntry *entries, int total_sprites) {
+    if (GE_ReserveStore(store, store->total + total_sprites) != 0)
+        return -1;
+
+    for (int cur_sprite = 0; cur_sprite < total_sprites; cur_sprite++)
+        if (GE_AddSprite(store, 0, 0, SPRITE_STATE_OFF) == GE_NO_SPRITE)
+            return -1;
+
+    return ZT_LayoutItems(store, entries, total_sprites, NULL);
+}
+
+/********************************************//**
+ * @brief
+ * Window height needed to show every item, never less than WINDOW_HEIGHT
+ * @param total_sprites int
+ * @return int
+ ***********************************************/
+int ZT_HeightForSprites(int total_sprites) {
+    int rows = (total_sprites - 1 + 3) / 4;
+    int needed = ITEMS_TOP + (rows * (SPRITE_HEIGHT + ITEMS_ROW_GAP));
+
+    return (needed > WINDOW_HEIGHT) ? needed : WINDOW_HEIGHT;
+}
+
+/********************************************//**
+ * @brief
+ * (Re)builds the hit-test grid from the current triforce/item layout
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_BuildHitGrid(struct Tracker *tracker) {
+    struct SpriteStore *sprites = &tracker->sprites;
+
+    GM_HitGridClear(&tracker->hit_grid);
+
+    for (int i = 0; i < sprites->total; i++) {
+        if ((sprites->state[i] & SPRITE_STATE_DISABLED) == SPRITE_STATE_DISABLED)
+            continue;
+
+        GM_HitGridAdd(&tracker->hit_grid, i, sprites->x[i], sprites->y[i], SPRITE_WIDTH, SPRITE_HEIGHT);
+    }
+
+    tracker->hovered = GM_NO_HIT;
+    tracker->cursor_moved = 1;
+    return GM_HitGridBuild(&tracker->hit_grid);
+}
+
+/********************************************//**
+ * @brief
+ * Sheet cell -> atlas rect for one slot, from the store's col/row. Every runner's copy of the
+ * slot gets the same picture, and entry 0's goes out to the triforces too. Render side only.
+ * @param tracker struct Tracker*
+ * @param slot int
+ * @return int
+ * 0 on success, -1 if the cell can't be had
+ ***********************************************/
+int ZT_ResolveSlot(struct Tracker *tracker, int slot) {
+    struct SpriteStore *sprites = &tracker->sprites;
+    int local = slot % tracker->runner_slots;
+
+    if (GA_ResolveCell(&tracker->atlas, sprites->col[slot], sprites->row[slot], &sprites->frm[slot]) != 0)
+        return -1;
+
+    for (int r = 0; r < tracker->runners; r++) {
+        int base = r * tracker->runner_slots;
+
+        sprites->frm[base + local] = sprites->frm[slot];
+        if (local == ZT_TOTAL_DUNGEONS)
+            for (int i = 0; i < ZT_TOTAL_DUNGEONS; i++)
+                sprites->frm[base + i] = sprites->frm[slot];
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Works out where every slot is drawn from and to for the current layout. Render side only.
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_PlaceSlots(struct Tracker *tracker) {
+    const struct SpriteStore *sprites = &tracker->sprites;
+
+    for (int i = 0; i < sprites->total; i++) {
+        SDL_Rect cell = { sprites->x[i], sprites->y[i], SPRITE_WIDTH, SPRITE_HEIGHT };
+
+        tracker->draw_to[i] = GLY_ToPixels(&tracker->placed, &cell);
+        tracker->draw_frm[i] = GLY_Scale(&sprites->frm[i], tracker->item_factor);
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Points the software screen at the window surface as it is now, or at a raster of the same
+ * size if the surface isn't in a format the kernels draw (copied over at present). Render side.
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_AttachScreen(struct Tracker *tracker) {
+    SDL_Surface *surface = SDL_GetWindowSurface(tracker->scene.window);
+
+    if (surface == NULL) {
+        DEBUG_ERR(SDL_GetError());
+        return -1;
+    }
+    tracker->scene.surface = surface;
+    GX_DestroyRaster(&tracker->screen);
+
+    // XRGB8888 takes the same blends, its top byte is never looked at
+    if (surface->format->format == SDL_PIXELFORMAT_ARGB8888 || surface->format->format == SDL_PIXELFORMAT_RGB888) {
+        GX_WrapRaster(&tracker->screen, surface->pixels, surface->w, surface->h, surface->pitch);
+        return 0;
+    }
+    return GX_InitRaster(&tracker->screen, surface->w, surface->h);
+}
+
+/********************************************//**
+ * @brief
+ * Puts the software screen on the window
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_PresentScreen(struct Tracker *tracker) {
+    SDL_Surface *surface = tracker->scene.surface;
+    const struct Raster *screen = &tracker->screen;
+
+    if (screen->owned)
+        SDL_ConvertPixels(screen->w, screen->h, SDL_PIXELFORMAT_ARGB8888, screen->pixels, screen->pitch * 4,
+                          surface->format->format, surface->pixels, surface->pitch);
+    // Fails between a resize and the next layout reattaching, that frame is simply lost
+    SDL_UpdateWindowSurface(tracker->scene.window);
+}
+
+/********************************************//**
+ * @brief
+ * Switches the render side over to a new layout: layers at the new pixel size, atlas copies and
+ * map chunks at the new scale and every slot placed again. Render side only.
+ * @param tracker struct Tracker*
+ * @param layout const struct Layout*
+ * @return int
+ * 0 on success, -1 if the layers couldn't be made
+ ***********************************************/
+int ZT_ApplyLayout(struct Tracker *tracker, const struct Layout *layout) {
+    SDL_Renderer *renderer = tracker->scene.renderer;
+    struct Compositor *compositor = &tracker->compositor;
+    int item_factor = layout->scale * SPRITE_WIDTH / GA_CELL_SIZE;
+
+    if (layout->pixel_w != compositor->w || layout->pixel_h != compositor->h)
+        if (GC_ResizeLayers(compositor, renderer, layout->pixel_w, layout->pixel_h) != 0)
+            return -1;
+
+    // The blits scale as they go, there's nothing to pre-scale. A resize invalidates the surface.
+    if (tracker->software) {
+        if (ZT_AttachScreen(tracker) != 0)
+            return -1;
+        tracker->item_factor = 1;
+        tracker->sprite_factor = 1;
+        tracker->placed = *layout;
+        ZT_PlaceSlots(tracker);
+        GC_ClearSprites(compositor, renderer);
+        return (tracker->showing_maps) ? GMP_ResizeCache(&tracker->map_cache, NULL, layout->scale) : 0;
+    }
+
+    // Too big for the renderer, fall back to stretching from the plain atlas
+    tracker->item_texture = GA_ScaledTexture(&tracker->atlas, renderer, item_factor);
+    tracker->item_factor = item_factor;
+    if (tracker->item_texture == NULL) {
+        tracker->item_texture = tracker->atlas.texture;
+        tracker->item_factor = 1;
+    }
+    tracker->sprite_texture = GA_ScaledTexture(&tracker->atlas, renderer, layout->scale);
+    tracker->sprite_factor = layout->scale;
+    if (tracker->sprite_texture == NULL) {
+        tracker->sprite_texture = tracker->atlas.texture;
+        tracker->sprite_factor = 1;
+    }
+    GB_SetTexture(&tracker->sprite_batch, tracker->item_texture);
+
+    tracker->placed = *layout;
+    ZT_PlaceSlots(tracker);
+    GC_ClearSprites(compositor, renderer);
+    return (tracker->showing_maps) ? GMP_ResizeCache(&tracker->map_cache, renderer, layout->scale) : 0;
+}
+
+/********************************************//**
+ * @brief
+ * Startup job: opens the font and rasterizes its glyphs, for ZT_InitRenderer to upload. Runs
+ * on a worker thread while the window and renderer come up.
+ * @param data void* the struct Tracker
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_LoadFont(void *data) {
+    struct Tracker *tracker = data;
+
+#ifdef ZT_EMBEDDED_FONT
+    tracker->game_font = TTF_OpenFontRW(SDL_RWFromConstMem(GF_EMBEDDED_FONT, GF_EMBEDDED_FONT_SIZE), 1, 16);
+#else
+    tracker->game_font = TTF_OpenFont(GF_PRESS_START2P, 16);
+#endif
+    if (tracker->game_font == NULL) {
+        DEBUG_ERR(TTF_GetError());
+        return -1;
+    }
+
+    tracker->glyph_sheet = GTX_RasterizeText(&tracker->text, tracker->game_font);
+    return (tracker->glyph_sheet != NULL) ? 0 : -1;
+}
+
+/********************************************//**
+ * @brief
+ * Startup job: reads and parses sprites.cfg, and decodes the sheet if it asks for cells the
+ * build didn't pack. Runs on a worker thread while the window and renderer come up.
+ * @param data void* the struct Tracker
+ * @return int
+ * 0 on success, -1 if the config didn't load (config_error says why)
+ ***********************************************/
+int ZT_LoadConfig(void *data) {
+    struct Tracker *tracker = data;
+    struct SpriteConfig *config = &tracker->sprite_config;
+
+    if (GCF_LoadConfig(config, tracker->sprites_path) != 0) {
+        GCF_FormatError(config, tracker->sprites_path, tracker->config_error, sizeof(tracker->config_error));
+        return -1;
+    }
+
+    // Same cells ZT_InitRenderer resolves, entry 0 and everything enabled
+    for (int i = 0; i < config->total_entries; i++) {
+        const struct SpriteEntry *entry = &config->entries[i];
+
+        if ((i == 0 || entry->enabled)
+            && GA_FindSheetRect(entry->col * SPRITE_SHEET_GRID_SIZE, entry->row * SPRITE_SHEET_GRID_SIZE,
+                                GA_CELL_SIZE, GA_CELL_SIZE) == -1) {
+            tracker->preloaded_sheet = GA_DecodeSheet();
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * First half of the render side's init, what doesn't need the items laid out: the renderer
+ * and the atlas upload. Runs on whichever thread is going to render, while the state side
+ * waits on sprites.cfg and lays out.
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_StartRenderer(struct Tracker *tracker) {
+    struct Scene *scene = &tracker->scene;
+    const char *thread = tracker->threaded ? "render" : NULL;
+    Uint64 from = SDL_GetPerformanceCounter();
+
+    if (ZT_InitSceneRenderer(scene, &tracker->software) != 0)
+        return -1;
+
+    // Setup the system
+    if (tracker->software == 0)
+        SDL_SetRenderDrawColor(scene->renderer, 0, 0, 0, 255);
+    from = GSU_Mark("renderer", from, thread);
+
+    //////////////////////////////
+    //
+    // Sprites / buttons for clicking
+    //
+    //////////////////////////////
+    if (GA_InitAtlas(&tracker->atlas, scene->renderer) != 0)
+        return -1;
+    // Left at full alpha, per sprite alpha is baked into the batch's vertex colors
+    if (tracker->software == 0)
+        SDL_SetTextureAlphaMod(tracker->atlas.texture, SPRITE_MODA_ON);
+    GSU_Mark("atlas upload", from, thread);
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Second half of the render side's init, once the items are laid out: item atlas rects, text
+ * and the cached layers. Waits for the font if the worker isn't done with it.
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_InitRenderer(struct Tracker *tracker) {
+    struct Scene *scene = &tracker->scene;
+    struct SpriteStore *sprites = &tracker->sprites;
+    int total_slots = sprites->total;
+    const char *thread = tracker->threaded ? "render" : NULL;
+    Uint64 from = SDL_GetPerformanceCounter();
+
+    // Decoded by the config job if sprites.cfg needed it
+    GA_AdoptSheet(&tracker->atlas, tracker->preloaded_sheet);
+    tracker->preloaded_sheet = NULL;
+
+    // Sheet coords -> atlas rects once, the triforce entry is resolved even though it's never drawn
+    for (int i = 0; i < tracker->total_sprites; i++) {
+        int slot = ZT_TOTAL_DUNGEONS + i;
+
+        if (i > 0 && (sprites->state[slot] & SPRITE_STATE_DISABLED) == SPRITE_STATE_DISABLED)
+            continue;
+
+        if (ZT_ResolveSlot(tracker, slot) != 0)
+            return -1;
+    }
+    GA_ReleaseSheet(&tracker->atlas);
+
+    // For our custom cursor
+    tracker->cursor = GA_Rect(GA_CURSOR);
+
+    tracker->font_draw_rect.h = 24;
+    tracker->font_draw_rect.w = 24;
+    tracker->font_draw_rect.x = 10;
+    tracker->font_draw_rect.y = 10;
+
+    SDL_Rect item_track_to = { 0, 0, 16, 16};
+    tracker->item_track_to = item_track_to;
+
+    // Dungeon numbers and item tags, room for a one digit tag on every item
+    if (GSU_FinishJob(&tracker->font_job, thread) != 0)
+        return -1;
+    from = GSU_Mark("item rects", from, thread);
+    if (GTX_UploadText(&tracker->text, scene->renderer, tracker->glyph_sheet, total_slots) != 0) {
+        tracker->glyph_sheet = NULL;
+        return -1;
+    }
+    tracker->glyph_sheet = NULL;
+
+    if (GC_InitCompositor(&tracker->compositor, scene->renderer, tracker->layout.pixel_w,
+                          tracker->layout.pixel_h, total_slots) != 0)
+        return -1;
+    tracker->layers_seen = 0;
+
+    // Every triforce/item quad that changed goes out in a single draw call
+    tracker->changed = malloc(sizeof(int) * total_slots);
+    tracker->tagged_items = malloc(sizeof(int) * total_slots);
+    tracker->draw_to = malloc(sizeof(SDL_Rect) * total_slots);
+    tracker->draw_frm = malloc(sizeof(SDL_Rect) * total_slots);
+    tracker->total_tagged = 0;
+    if (tracker->changed == NULL || tracker->tagged_items == NULL
+        || tracker->draw_to == NULL || tracker->draw_frm == NULL)
+        return -1;
+
+    if (tracker->software == 0 && GB_InitBatch(&tracker->sprite_batch, tracker->atlas.texture, total_slots) != 0)
+        return -1;
+
+    if (tracker->showing_maps && GMP_InitCache(&tracker->map_cache, scene->renderer, tracker->runners) != 0)
+        return -1;
+
+    if (ZT_ApplyLayout(tracker, &tracker->layout) != 0)
+        return -1;
+    GSU_Mark("glyph upload and layers", from, thread);
+    return 0;
+}
+
+int ZT_RenderThread(void *data);
+
+/********************************************//**
+ * @brief
+ * Puts link where he is at now: along his walk with the stabs taken out, in the stab pose while
+ * one is running. Costs the same however far now is from the last call.
+ * @param tracker struct Tracker*
+ * @param now double ms on the tracker's clock
+ * @return int
+ * 1 if he moved or changed frame
+ ***********************************************/
+int ZT_AnimateLink(struct Tracker *tracker, double now) {
+    SDL_Rect frm;
+    SDL_Rect to;
+    SDL_Point at;
+    int facing = GAN_EvalPath(&tracker->link_path, GAN_Unheld(&tracker->link_stab, now), &at);
+
+    if (GAN_Holding(&tracker->link_stab, now)) {
+        frm = GA_Rect(LINK_STAB_FRAMES[facing]);
+        at.x += LINK_STAB_OFFSET[facing].x;
+        at.y += LINK_STAB_OFFSET[facing].y;
+    } else {
+        frm = GA_Rect(LINK_WALK_FRAMES[facing][((Uint64)now / 200) % 2]);
+    }
+
+    to.x = at.x;
+    to.y = at.y;
+    to.w = frm.w;
+    to.h = frm.h;
+    if (memcmp(&to, &tracker->link_walk_to, sizeof(to)) == 0
+        && memcmp(&frm, &tracker->link_walk_frm, sizeof(frm)) == 0)
+        return 0;
+
+    tracker->link_walk_frm = frm;
+    tracker->link_walk_to = to;
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * State side of the init, once sprites.cfg is in: the store, the ring and every runner's items
+ * laid out. Runs on the main thread while the renderer comes up.
+ * @param tracker struct Tracker*
+ * @param window_width int of one runner's tile before the map panel
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_PlaceItems(struct Tracker *tracker, int window_width) {
+    struct SpriteStore *sprites = &tracker->sprites;
+
+    if (GSU_FinishJob(&tracker->config_job, NULL) != 0) {
+        DEBUG_ERR(tracker->config_error);
+        return -1;
+    }
+    Uint64 from = SDL_GetPerformanceCounter();
+
+    tracker->total_sprites = tracker->sprite_config.total_entries;
+    if (tracker->total_sprites < 1) {
+        DEBUG_ERR("The sprites configuration file is empty");
+        return -1;
+    }
+
+    tracker->runner_slots = ZT_TOTAL_DUNGEONS + tracker->total_sprites;
+    int total_slots = tracker->runners * tracker->runner_slots;
+    if (tracker->showing_maps) {
+        SDL_Point map_at = { window_width + ZT_MAP_AT.x, ZT_MAP_AT.y };
+
+        if (GMP_InitMaps(&tracker->maps, tracker->runners, map_at, tracker->tile_w) != 0)
+            return -1;
+    }
+    tracker->map_hovered = -1;
+
+    if (GE_InitStore(sprites, total_slots) != 0
+        || GR_InitRing(&tracker->ring, total_slots, tracker->maps.total) != 0)
+        return -1;
+    GP_InitProfiler(&tracker->profiler);
+
+    // Triforces first so they get slots [0, ZT_TOTAL_DUNGEONS), the dungeon numbers sit beside them
+    for (int i = 0; i < ZT_TOTAL_DUNGEONS; i++) {
+        tracker->dungeon_at[i].x = 10;
+        tracker->dungeon_at[i].y = 20 + (i * 40);
+        GE_AddSprite(sprites, 30, tracker->dungeon_at[i].y - 16, SPRITE_STATE_OFF);
+    }
+
+    if (ZT_InitGameSprites(sprites, tracker->sprite_config.entries, tracker->total_sprites) != 0)
+        return -1;
+
+    // The other runners' blocks follow, laid out by copying
+    while (sprites->total < total_slots)
+        if (GE_AddSprite(sprites, 0, 0, SPRITE_STATE_OFF) == GE_NO_SPRITE)
+            return -1;
+    ZT_CloneRunners(sprites, tracker->runners, tracker->runner_slots, tracker->tile_w, NULL);
+
+    GSU_Mark("items laid out", from, NULL);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Starts the undo history over from the store as it is, sized for however many slots it has
+ * now. Undo is off until the next reset if there isn't the memory for it.
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_ResetHistory(struct Tracker *tracker) {
+    struct SpriteStore *sprites = &tracker->sprites;
+    int *changed = realloc(tracker->history_changed, sizeof(int) * (sprites->total > 0 ? sprites->total : 1));
+
+    if (changed == NULL) {
+        GH_Reset(&tracker->history, sprites->state, sprites->tag, 0);
+        DEBUG_ERR("Unable to make room for the undo history, undo is off");
+        return -1;
+    }
+    tracker->history_changed = changed;
+
+    return GH_Reset(&tracker->history, sprites->state, sprites->tag, sprites->total);
+}
+
+/********************************************//**
+ * @brief
+ * Loads the item layout, opens the window and brings up the renderer, on a render thread of its
+ * own if mode is ZT_RENDER_THREADED. SDL, SDL_ttf and SDL_image must already be up.
+ * ZT_RENDER_SOFTWARE skips looking for an accelerated renderer.
+ * @param tracker struct Tracker*
+ * @param window_width int of one runner's tile before the map panel, the window is runners tiles wide
+ * @param window_height int
+ * @param window_title const char*
+ * @param sprites_path const char* sprites configuration to load
+ * @param target_fps float presentation cap
+ * @param mode int ZT_RENDER_INLINE or ZT_RENDER_THREADED, or'd with ZT_RENDER_SOFTWARE and/or
+ * ZT_RENDER_HEADLESS
+ * @param runners int trackers side by side, 1 outside of races, no more than ZT_MAX_RUNNERS
+ * @param show_maps int put the map panel right of every runner's items, their tiles widen to fit
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int ZT_InitTracker(struct Tracker *tracker, int window_width, int window_height,
+                   const char *window_title, const char *sprites_path, float target_fps, int mode,
+                   int runners, int show_maps) {
+    struct Scene *scene = &tracker->scene;
+    struct SpriteStore *sprites = &tracker->sprites;
+
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->threaded = (mode & ZT_RENDER_THREADED) != 0;
+    tracker->software = (mode & ZT_RENDER_SOFTWARE) != 0;
+    tracker->runners = (runners < 1) ? 1 : (runners > ZT_MAX_RUNNERS) ? ZT_MAX_RUNNERS : runners;
+    tracker->showing_maps = (show_maps != 0);
+    tracker->tile_w = window_width + (tracker->showing_maps ? GMP_PANEL_W + 2 * ZT_MAP_AT.x : 0);
+    snprintf(tracker->sprites_path, sizeof(tracker->sprites_path), "%s", sprites_path);
+
+    // Off to the workers, everything up to ZT_PlaceItems only needs the window
+    GSU_StartJob(&tracker->font_job, "font", ZT_LoadFont, tracker);
+    GSU_StartJob(&tracker->config_job, "sprites.cfg", ZT_LoadConfig, tracker);
+
+    Uint64 from = SDL_GetPerformanceCounter();
+    if (ZT_InitGame(scene, tracker->tile_w * tracker->runners, window_height, window_title,
+                    (mode & ZT_RENDER_HEADLESS) != 0) != 0)
+        return -1;
+    GLY_FitWindow(&tracker->layout, scene->window, scene->w, scene->h);
+    GSU_Mark("window", from, NULL);
+
+    //////////////////////////////
+    //
+    // Rendering, here or on its own thread. The renderer comes up while the items are laid out.
+    //
+    //////////////////////////////
+    int placed;
+    if (tracker->threaded) {
+        SDL_AtomicSet(&tracker->render_quit, 0);
+        SDL_AtomicSet(&tracker->render_pause, 0);
+        tracker->render_ready = SDL_CreateSemaphore(0);
+        tracker->render_paused = SDL_CreateSemaphore(0);
+        tracker->render_resume = SDL_CreateSemaphore(0);
+        tracker->layout_ready = SDL_CreateSemaphore(0);
+        tracker->render_thread = (tracker->render_ready != NULL && tracker->render_paused != NULL
+                                  && tracker->render_resume != NULL && tracker->layout_ready != NULL)
+                                 ? SDL_CreateThread(ZT_RenderThread, "ZT_Render", tracker) : NULL;
+        if (tracker->render_thread == NULL) {
+            DEBUG_ERR(SDL_GetError());
+            return -1;
+        }
+
+        // The renderer waits on the layout to fill in frm, nothing below touches the store until it has
+        placed = ZT_PlaceItems(tracker, window_width);
+        SDL_AtomicSet(&tracker->render_quit, placed != 0);
+        SDL_SemPost(tracker->layout_ready);
+        SDL_SemWait(tracker->render_ready);
+        if (placed != 0 || SDL_AtomicGet(&tracker->render_failed))
+            return -1;
+    } else if (ZT_StartRenderer(tracker) != 0 || ZT_PlaceItems(tracker, window_width) != 0
+               || ZT_InitRenderer(tracker) != 0) {
+        return -1;
+    }
+    int total_slots = sprites->total;
+
+    tracker->cursor_draw_at.x = 0;
+    tracker->cursor_draw_at.y = 0;
+    tracker->cursor_draw_at.h = 32;
+    tracker->cursor_draw_at.w = 20;
+
+    //////////////////////////////
+    //
+    // Managing the boards/levels
+    //
+    //////////////////////////////
+    tracker->track_for_dungeon = -1;
+
+    if (GM_InitHitGrid(&tracker->hit_grid, SPRITE_WIDTH, SPRITE_HEIGHT, total_slots) != 0
+        || ZT_BuildHitGrid(tracker) != 0)
+        return -1;
+
+    if (GH_InitHistory(&tracker->history) != 0 || ZT_ResetHistory(tracker) != 0)
+        return -1;
+    tracker->history_steps = 0;
+
+    //////////////////////////////
+    //
+    // For handling the game loop
+    //
+    //////////////////////////////
+    GT_InitClock(&tracker->clock, UPDATES_PER_SECOND, target_fps);
+    tracker->mouse_pressed = 0;
+    if (GAN_InitPath(&tracker->link_path, LINK_PATROL, 4, 1.0 / tracker->clock.ms_per_update) != 0)
+        return -1;
+    memset(&tracker->link_stab, 0, sizeof(tracker->link_stab));
+    ZT_AnimateLink(tracker, tracker->clock.now);
+    tracker->layers_lost = 0;
+    tracker->redraw = 1;
+    tracker->quit = 0;
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * ZT_OpenJournal for the map panel, its marks and tags go in a journal of their own next to
+ * the tracker's so a change to sprites.cfg never throws them away
+ * @param tracker struct Tracker*
+ * @param path const char* the tracker's journal, ZT_MAP_JOURNAL_SUFFIX is added
+ * @return int
+ * 0 on success, -1 if we couldn't start journaling
+ ***********************************************/
+int ZT_OpenMapJournal(struct Tracker *tracker, const char *path) {
+    struct MapState *maps = &tracker->maps;
+    char map_path[sizeof(tracker->map_journal.path)];
+    Uint32 epoch;
+
+    snprintf(map_path, sizeof(map_path), "%s%s", path, ZT_MAP_JOURNAL_SUFFIX);
+    if (GJ_Restore(map_path, maps->marks, maps->tag, maps->total, &epoch) < 0) {
+        memset(maps->marks, 0, sizeof(Uint8) * maps->total);
+        memset(maps->tag, -1, sizeof(Sint8) * maps->total);
+    }
+
+    // A snapshot can have caught a cell hovered
+    for (int i = 0; i < maps->total; i++)
+        maps->marks[i] &= ~GMP_HOVER;
+    tracker->map_hovered = -1;
+
+    if (GJ_OpenJournal(&tracker->map_journal, map_path, maps->marks, maps->tag, maps->total, epoch) != 0) {
+        GJ_CloseJournal(&tracker->map_journal, NULL, NULL);
+        return -1;
+    }
+
+    tracker->map_journaling = 1;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Puts back the clicks and tags from the last run saved at path, then keeps saving to it.
+ * Call it after ZT_InitTracker and before the first ZT_Frame.
+ * @param tracker struct Tracker*
+ * @param path const char* journal, the snapshot and the maps' journal go next to it
+ * @return int
+ * 0 on success, -1 if we couldn't start journaling (the tracker still works, it just forgets)
+ ***********************************************/
+int ZT_OpenJournal(struct Tracker *tracker, const char *path) {
+    struct SpriteStore *sprites = &tracker->sprites;
+    Uint8 *saved_state = malloc(sizeof(Uint8) * sprites->total);
+    Sint8 *saved_tag = malloc(sizeof(Sint8) * sprites->total);
+    Uint64 started = SDL_GetPerformanceCounter();
+    char restored[96];
+    Uint32 epoch;
+    int replayed;
+
+    if (saved_state == NULL || saved_tag == NULL) {
+        free(saved_state);
+        free(saved_tag);
+        return -1;
+    }
+
+    memcpy(saved_state, sprites->state, sizeof(Uint8) * sprites->total);
+    memcpy(saved_tag, sprites->tag, sizeof(Sint8) * sprites->total);
+    replayed = GJ_Restore(path, saved_state, saved_tag, sprites->total, &epoch);
+
+    // Hover and disabled belong to this run, only ON and the tags come back
+    if (replayed >= 0) {
+        for (int i = 0; i < sprites->total; i++) {
+            sprites->state[i] = (sprites->state[i] & ~SPRITE_STATE_ON) | (saved_state[i] & SPRITE_STATE_ON);
+            sprites->tag[i] = saved_tag[i];
+        }
+        snprintf(restored, sizeof(restored), "Restored the tracker (%d journal records) in %.3f ms", replayed,
+                 (double)(SDL_GetPerformanceCounter() - started) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+        DEBUG_LOG(restored);
+    }
+    free(saved_state);
+    free(saved_tag);
+    ZT_ResetHistory(tracker);
+
+    if (tracker->showing_maps && ZT_OpenMapJournal(tracker, path) != 0)
+        DEBUG_ERR("Unable to journal the maps");
+
+    if (GJ_OpenJournal(&tracker->journal, path, sprites->state, sprites->tag, sprites->total, epoch) != 0) {
+        GJ_CloseJournal(&tracker->journal, NULL, NULL);
+        return -1;
+    }
+
+    tracker->journaling = 1;
+    tracker->redraw = 1;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Starts serving the tracker's state to overlays on 127.0.0.1:port (see GameServer.h). Call
+ * it after ZT_OpenJournal so new clients start from the restored state.
+ * @param tracker struct Tracker*
+ * @param port Uint16
+ * @return int
+ * 0 on success, -1 on failure (the tracker carries on without it)
+ ***********************************************/
+int ZT_StartServer(struct Tracker *tracker, Uint16 port) {
+    struct SpriteStore *sprites = &tracker->sprites;
+    const char **names = malloc(sizeof(const char *) * sprites->total);
+    char *labels = malloc((size_t)GS_NAME_LENGTH * sprites->total);
+    int result;
+
+    if (names == NULL || labels == NULL) {
+        free(names);
+        free(labels);
+        return -1;
+    }
+
+    // In a race every name is prefixed with its runner, "2/bow"
+    for (int i = 0; i < sprites->total; i++) {
+        int local = i % tracker->runner_slots;
+        char name[GS_NAME_LENGTH];
+
+        if (local < ZT_TOTAL_DUNGEONS)
+            snprintf(name, sizeof(name), "triforce_%d", local + 1);
+        else
+            snprintf(name, sizeof(name), "%s", tracker->sprite_config.entries[local - ZT_TOTAL_DUNGEONS].name);
+
+        names[i] = labels + (size_t)i * GS_NAME_LENGTH;
+        if (tracker->runners > 1)
+            snprintf(labels + (size_t)i * GS_NAME_LENGTH, GS_NAME_LENGTH, "%d/%s",
+                     i / tracker->runner_slots + 1, name);
+        else
+            snprintf(labels + (size_t)i * GS_NAME_LENGTH, GS_NAME_LENGTH, "%s", name);
+    }
+
+    result = GS_StartServer(&tracker->server, port, sprites->state, sprites->tag, names, sprites->total,
+                            SPRITE_STATE_ON | SPRITE_STATE_DISABLED);
+    free(names);
+    free(labels);
+    if (result != 0) {
+        GS_StopServer(&tracker->server);
+        return -1;
+    }
+
+    tracker->serving = 1;
+    tracker->server_port = port;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Runner 0's slot for a sprites.cfg #name or triforce_1 to triforce_9
+ * @param tracker const struct Tracker*
+ * @param name const char*
+ * @return int
+ * -1 if there's no such item
+ ***********************************************/
+int ZT_SlotForName(const struct Tracker *tracker, const char *name) {
+    int dungeon;
+
+    if (strncmp(name, "triforce_", 9) == 0) {
+        dungeon = atoi(name + 9);
+        return (dungeon >= 1 && dungeon <= ZT_TOTAL_DUNGEONS) ? dungeon - 1 : -1;
+    }
+
+    for (int e = 0; e < tracker->total_sprites; e++)
+        if (strcmp(name, tracker->sprite_config.entries[e].name) == 0)
+            return ZT_TOTAL_DUNGEONS + e;
+    return -1;
+}
+
+/********************************************//**
+ * @brief
+ * Points a RAM watch's rules at the slots they drive, by name. Slots are runner 0's, the
+ * caller offsets them by runner.
+ * @param tracker struct Tracker*
+ * @param watch struct RamWatch*
+ * @return void
+ ***********************************************/
+void ZT_BindRam(const struct Tracker *tracker, struct RamWatch *watch) {
+    for (int i = 0; i < watch->total_rules; i++)
+        watch->rules[i].slot = ZT_SlotForName(tracker, watch->rules[i].name);
+}
+
+/********************************************//**
+ * @brief
+ * Auto-tracks the next runner (the first call is runner 0, then 1...) from an emulator's RAM
+ * dump, see GameRam.h. The dump doesn't have to exist yet.
+ * @param tracker struct Tracker*
+ * @param rules_path const char* ram.cfg
+ * @param source const char* RAM dump file, or "shm:<name>"
+ * @return int
+ * 0 on success, -1 on failure (that runner is tracked by hand)
+ ***********************************************/
+int ZT_TrackRam(struct Tracker *tracker, const char *rules_path, const char *source) {
+    struct RamWatch *watch = &tracker->ram[tracker->ram_sources];
+
+    if (tracker->ram_sources >= tracker->runners) {
+        DEBUG_ERR("More RAM sources than runners");
+        return -1;
+    }
+
+    if (GRM_InitWatch(watch, rules_path, source) != 0) {
+        GRM_DestroyWatch(watch);
+        return -1;
+    }
+    ZT_BindRam(tracker, watch);
+    tracker->ram_sources++;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Auto-tracks the next runner (the first call is runner 0, then 1...) by looking for the
+ * sprites.cfg icons in captured video, see GameVision.h
+ * @param tracker struct Tracker*
+ * @param config_path const char* vision.cfg
+ * @param source const char* .y4m or raw RGB24 file or pipe, "-" for stdin
+ * @return int
+ * 0 on success, -1 on failure (that runner is tracked by hand)
+ ***********************************************/
+int ZT_WatchVideo(struct Tracker *tracker, const char *config_path, const char *source) {
+    struct Vision *vision = &tracker->vision[tracker->video_sources];
+    SDL_Surface *loaded;
+    SDL_Surface *sheet;
+    int result = 0;
+
+    if (tracker->video_sources >= tracker->runners) {
+        DEBUG_ERR("More video sources than runners");
+        return -1;
+    }
+
+    if (GV_InitVision(vision, config_path, source) != 0) {
+        GV_DestroyVision(vision);
+        return -1;
+    }
+
+    // Straight from the PNG, the atlas may never have decoded it
+    loaded = IMG_Load(GA_SHEET_PATH);
+    sheet = (loaded != NULL) ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0) : NULL;
+    SDL_FreeSurface(loaded);
+    if (sheet == NULL) {
+        DEBUG_ERR(IMG_GetError());
+        GV_DestroyVision(vision);
+        return -1;
+    }
+
+    // Entry 0 is the triforce, there's no one icon for it on screen
+    for (int e = 1; e < tracker->total_sprites && result >= 0; e++) {
+        const struct SpriteEntry *entry = &tracker->sprite_config.entries[e];
+        SDL_Rect from = {
+                entry->col * SPRITE_SHEET_GRID_SIZE, entry->row * SPRITE_SHEET_GRID_SIZE,
+                GA_CELL_SIZE, GA_CELL_SIZE
+        };
+
+        result = GV_AddTemplate(vision, entry->name, sheet, &from);
+    }
+    SDL_FreeSurface(sheet);
+
+    if (result < 0 || GV_StartVision(vision) != 0) {
+        GV_DestroyVision(vision);
+        return -1;
+    }
+
+    for (int t = 0; t < vision->total_templates; t++)
+        vision->templates[t].slot = ZT_SlotForName(tracker, vision->templates[t].name);
+    tracker->video_sources++;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Starts watching sprites.cfg and the sprite sheet, ZT_Frame reloads whichever of them changes
+ * (see ZT_Reload). Call it once everything else is up.
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 on success, -1 on failure (the files are just never reloaded)
+ ***********************************************/
+int ZT_WatchFiles(struct Tracker *tracker) {
+    const char *paths[2] = { tracker->sprites_path, GA_SHEET_PATH };
+
+    if (GW_InitWatch(&tracker->watch, paths, 2) != 0) {
+        GW_DestroyWatch(&tracker->watch);
+        return -1;
+    }
+
+    tracker->watching = 1;
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Performance counter reading at the start of a profiled phase
+ * @param tracker const struct Tracker*
+ * @return Uint64
+ * 0 if profiling is off
+ ***********************************************/
+Uint64 ZT_ProfileBegin(const struct Tracker *tracker) {
+    return tracker->profiling ? SDL_GetPerformanceCounter() : 0;
+}
+
+/********************************************//**
+ * @brief
+ * Adds the time since ZT_ProfileBegin to a state side phase, it goes out with the next frame
+ * @param tracker struct Tracker*
+ * @param phase int GP_EVENTS, GP_UPDATE or GP_PUBLISH
+ * @param started Uint64 from ZT_ProfileBegin
+ * @return void
+ ***********************************************/
+void ZT_ProfileEnd(struct Tracker *tracker, int phase, Uint64 started) {
+    if (tracker->profiling && started != 0)
+        tracker->state_ms[phase] += GP_Ms(&tracker->profiler, started, SDL_GetPerformanceCounter());
+}
+
+/********************************************//**
+ * @brief
+ * Estimates the performance counter when SDL queued an event, so time spent sitting in the
+ * queue counts towards latency. SDL stamps events in whole ms.
+ * @param tracker const struct Tracker*
+ * @param timestamp Uint32 the event's SDL_GetTicks stamp
+ * @return Uint64
+ ***********************************************/
+Uint64 ZT_EventCounter(const struct Tracker *tracker, Uint32 timestamp) {
+    Uint64 counter = SDL_GetPerformanceCounter();
+    Uint32 ticks = SDL_GetTicks();
+
+    // Replayed and pushed events may not carry a real stamp
+    if (timestamp == 0 || timestamp > ticks)
+        return counter;
+
+    return counter - (Uint64)(ticks - timestamp) * tracker->profiler.frequency / 1000;
+}
+
+/********************************************//**
+ * @brief
+ * Feeds one SDL event into the tracker
+ * @param tracker struct Tracker*
+ * @param e SDL_Event*
+ * @return void
+ ***********************************************/
+void ZT_HandleEvent(struct Tracker *tracker, const SDL_Event *e) {
+    char fps_display[32];
+
+    if (e->type == SDL_QUIT) {
+        tracker->quit = -1;
+    }
+
+    if (e->type == SDL_KEYDOWN) {
+        switch(e->key.keysym.scancode) {
+            case SDL_SCANCODE_0:
+                // CLEAR a tracked item
+                tracker->track_for_dungeon = 0;
+                break;
+            case SDL_SCANCODE_1:
+                tracker->track_for_dungeon = 1;
+                break;
+            case SDL_SCANCODE_2:
+                tracker->track_for_dungeon = 2;
+                break;
+            case SDL_SCANCODE_3:
+                tracker->track_for_dungeon = 3;
+                break;
+            case SDL_SCANCODE_4:
+                tracker->track_for_dungeon = 4;
+                break;
+            case SDL_SCANCODE_5:
+                tracker->track_for_dungeon = 5;
+                break;
+            case SDL_SCANCODE_6:
+                tracker->track_for_dungeon = 6;
+                break;
+            case SDL_SCANCODE_7:
+                tracker->track_for_dungeon = 7;
+                break;
+            case SDL_SCANCODE_8:
+                tracker->track_for_dungeon = 8;
+                break;
+            case SDL_SCANCODE_9:
+                tracker->track_for_dungeon = 9;
+                break;
+
+            // Frame cap can be changed on the fly, - and = (the + key)
+            case SDL_SCANCODE_MINUS:
+            case SDL_SCANCODE_KP_MINUS:
+                GT_SetTargetFps(&tracker->clock, tracker->clock.target_fps - GT_FPS_STEP);
+                sprintf(fps_display, "Target FPS: %.0f", tracker->clock.target_fps);
+                DEBUG_LOG(fps_display);
+                break;
+            case SDL_SCANCODE_EQUALS:
+            case SDL_SCANCODE_KP_PLUS:
+                GT_SetTargetFps(&tracker->clock, tracker->clock.target_fps + GT_FPS_STEP);
+                sprintf(fps_display, "Target FPS: %.0f", tracker->clock.target_fps);
+                DEBUG_LOG(fps_display);
+                break;
+
+            // Profiling overlay on/off, and dump what's been recorded so far
+            case SDL_SCANCODE_F3:
+                tracker->profiling = !tracker->profiling;
+                tracker->next_overlay_at = 0;
+                memset(tracker->state_ms, 0, sizeof(tracker->state_ms));
+                break;
+            case SDL_SCANCODE_F4:
+                tracker->dumps_requested++;
+                DEBUG_LOG("Writing the profile");
+                break;
+
+            // Ctrl+Z to undo, Ctrl+Y or Ctrl+Shift+Z to redo
+            case SDL_SCANCODE_Z:
+                if (e->key.keysym.mod & KMOD_CTRL)
+                    tracker->history_steps += (e->key.keysym.mod & KMOD_SHIFT) ? 1 : -1;
+                break;
+            case SDL_SCANCODE_Y:
+                if (e->key.keysym.mod & KMOD_CTRL)
+                    tracker->history_steps++;
+                break;
+
+            // Shop and key marks on the map cell under the cursor
+            case SDL_SCANCODE_S:
+                tracker->map_toggles |= GMP_SHOP;
+                break;
+            case SDL_SCANCODE_K:
+                tracker->map_toggles |= GMP_KEY;
+                break;
+
+            case SDL_SCANCODE_ESCAPE:
+                tracker->quit = -1;
+            default:
+                break;
+        }
+    }
+
+    // Resized, or dragged onto a display with another pixel density
+    if (e->type == SDL_WINDOWEVENT && (e->window.event == SDL_WINDOWEVENT_SIZE_CHANGED
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+                                       || e->window.event == SDL_WINDOWEVENT_DISPLAY_CHANGED
+#endif
+                                       ))
+        GLY_FitWindow(&tracker->layout, tracker->scene.window, tracker->scene.w, tracker->scene.h);
+
+    // Cursor follows the events rather than SDL_GetMouseState so replayed input behaves the same
+    if (e->type == SDL_MOUSEMOTION) {
+        GLY_ToLogical(&tracker->layout, e->motion.x, e->motion.y,
+                      &tracker->cursor_draw_at.x, &tracker->cursor_draw_at.y);
+        tracker->cursor_moved = 1;
+    }
+
+    if (e->type == SDL_MOUSEBUTTONDOWN) {
+        GLY_ToLogical(&tracker->layout, e->button.x, e->button.y,
+                      &tracker->cursor_draw_at.x, &tracker->cursor_draw_at.y);
+        tracker->cursor_moved = 1;
+        if (e->button.button & SDL_BUTTON_LEFT) {
+            tracker->mouse_pressed = 1;
+        }
+        if (tracker->profiling)
+            tracker->pressed_at = ZT_EventCounter(tracker, e->button.timestamp);
+    }
+
+    // The renderer dropped our layers on the floor, whoever renders builds them again
+    if (e->type == SDL_RENDER_TARGETS_RESET || e->type == SDL_RENDER_DEVICE_RESET)
+        tracker->layers_lost++;
+
+    // Anything that gets us out of bed is worth a redraw (cursor moved, window exposed, etc)
+    tracker->redraw = 1;
+}
+
+/********************************************//**
+ * @brief
+ * Sends a slot's new click state and tag out to the history, the journal and the overlays
+ * @param tracker struct Tracker*
+ * @param slot int
+ * @return void
+ ***********************************************/
+void ZT_SlotChanged(struct Tracker *tracker, int slot) {
+    GH_Set(&tracker->history, slot, tracker->sprites.state[slot] & SPRITE_STATE_ON, tracker->sprites.tag[slot]);
+
+    // Only ON is worth keeping, hover and disabled belong to this run
+    if (tracker->journaling)
+        GJ_Append(&tracker->journal, slot, tracker->sprites.state[slot] & SPRITE_STATE_ON,
+                  tracker->sprites.tag[slot]);
+    if (tracker->serving)
+        GS_Publish(&tracker->server, slot, tracker->sprites.state[slot], tracker->sprites.tag[slot]);
+}
+
+/********************************************//**
+ * @brief
+ * Switches items on and off as the emulators' RAM says, only the ones whose bytes changed
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_PollRam(struct Tracker *tracker) {
+    Uint8 *state = tracker->sprites.state;
+
+    for (int r = 0; r < tracker->ram_sources; r++) {
+        struct RamWatch *watch = &tracker->ram[r];
+        int total_changed = GRM_Poll(watch);
+
+        for (int c = 0; c < total_changed; c++) {
+            const struct RamRule *rule = &watch->rules[watch->changed[c]];
+            int slot = r * tracker->runner_slots + rule->slot;
+            Uint8 was;
+
+            if (rule->slot < 0)
+                continue;
+
+            was = state[slot];
+            state[slot] = (Uint8)(rule->on ? (was | SPRITE_STATE_ON) : (was & ~SPRITE_STATE_ON));
+            if (state[slot] != was) {
+                ZT_SlotChanged(tracker, slot);
+                tracker->redraw = 1;
+            }
+        }
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Switches on whatever the video threads saw come into view since the last call
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_PollVision(struct Tracker *tracker) {
+    Uint8 *state = tracker->sprites.state;
+
+    for (int r = 0; r < tracker->video_sources; r++) {
+        struct Vision *vision = &tracker->vision[r];
+
+        for (int t = 0; t < vision->total_templates; t++) {
+            struct VisionTemplate *tmpl = &vision->templates[t];
+            int detected = SDL_AtomicGet(&tmpl->detected);
+            int slot = r * tracker->runner_slots + tmpl->slot;
+
+            if (detected == tmpl->applied)
+                continue;
+            tmpl->applied = detected;
+
+            if (tmpl->slot < 0 || (state[slot] & SPRITE_STATE_ON))
+                continue;
+            state[slot] |= SPRITE_STATE_ON;
+            ZT_SlotChanged(tracker, slot);
+            tracker->redraw = 1;
+        }
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Undoes (steps < 0) or redoes (steps > 0) that many steps of what was tracked, as far as the
+ * history goes. Anything not yet committed is committed first.
+ * @param tracker struct Tracker*
+ * @param steps int
+ * @return void
+ ***********************************************/
+void ZT_StepHistory(struct Tracker *tracker, int steps) {
+    struct History *history = &tracker->history;
+    struct SpriteStore *sprites = &tracker->sprites;
+    int *changed = tracker->history_changed;
+
+    GH_Commit(history);
+    for (; steps != 0; steps += (steps < 0) ? 1 : -1) {
+        int total = (steps < 0) ? GH_Undo(history, changed) : GH_Redo(history, changed);
+
+        if (total == 0)
+            break;
+        for (int i = 0; i < total; i++) {
+            int slot = changed[i];
+            int tag = GH_Tag(history, slot);
+
+            sprites->state[slot] = (Uint8)((sprites->state[slot] & ~SPRITE_STATE_ON)
+                                           | (GH_On(history, slot) ? SPRITE_STATE_ON : 0));
+            // No tag is 0 or -1, leave whichever it was
+            if (tag != 0 || sprites->tag[slot] > 0)
+                sprites->tag[slot] = (Sint8)tag;
+            ZT_SlotChanged(tracker, slot);
+        }
+        tracker->redraw = 1;
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Sends a map cell's new marks and tag out to the journal
+ * @param tracker struct Tracker*
+ * @param cell int
+ * @return void
+ ***********************************************/
+void ZT_MapCellChanged(struct Tracker *tracker, int cell) {
+    if (tracker->map_journaling)
+        GJ_Append(&tracker->map_journal, cell, tracker->maps.marks[cell] & ~GMP_HOVER, tracker->maps.tag[cell]);
+    tracker->redraw = 1;
+}
+
+/********************************************//**
+ * @brief
+ * Hover, clicks, tab switches, shop/key toggles and dungeon tags on the map panel. A click
+ * steps a cell through unvisited, visited and cleared. Before the items get their turn.
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_UpdateMaps(struct Tracker *tracker) {
+    struct MapState *maps = &tracker->maps;
+    int x = tracker->cursor_draw_at.x;
+    int y = tracker->cursor_draw_at.y;
+    int hovered = tracker->map_hovered;
+    int runner, dungeon;
+
+    // Plain arithmetic on the grid, no hit grid needed
+    if (tracker->cursor_moved == 1 || tracker->mouse_pressed == 1) {
+        int hit = GMP_CellAt(maps, x, y);
+
+        if (hit != hovered) {
+            if (hovered >= 0)
+                maps->marks[hovered] &= ~GMP_HOVER;
+            if (hit >= 0)
+                maps->marks[hit] |= GMP_HOVER;
+            tracker->map_hovered = hovered = hit;
+            tracker->redraw = 1;
+        }
+    }
+
+    if (tracker->mouse_pressed == 1 && (dungeon = GMP_TabAt(maps, x, y, &runner)) > 0
+        && dungeon != maps->shown[runner]) {
+        maps->shown[runner] = (Uint8)dungeon;
+        tracker->redraw = 1;
+    }
+
+    if (hovered < 0) {
+        tracker->map_toggles = 0;
+        return;
+    }
+
+    if (tracker->mouse_pressed == 1) {
+        Uint8 mark = maps->marks[hovered];
+        Uint8 next = (mark & GMP_CLEARED) ? 0 : (mark & GMP_VISITED) ? GMP_VISITED | GMP_CLEARED : GMP_VISITED;
+
+        maps->marks[hovered] = (Uint8)((mark & ~(GMP_VISITED | GMP_CLEARED)) | next);
+        ZT_MapCellChanged(tracker, hovered);
+    }
+
+    if (tracker->map_toggles != 0) {
+        maps->marks[hovered] ^= tracker->map_toggles;
+        tracker->map_toggles = 0;
+        ZT_MapCellChanged(tracker, hovered);
+    }
+
+    // Same 0-9 as the items, 0 takes the tag off
+    if (tracker->track_for_dungeon >= 0) {
+        maps->tag[hovered] = (Sint8)((tracker->track_for_dungeon > 0) ? tracker->track_for_dungeon : -1);
+        tracker->track_for_dungeon = -1;
+        ZT_MapCellChanged(tracker, hovered);
+    }
+}
+
+/********************************************//**
+ * @brief
+ * Moves link on to where he is at the clock's time and applies hover/clicks/dungeon tags.
+ * Advance the clock first.
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_Update(struct Tracker *tracker) {
+    struct FrameClock *clock = &tracker->clock;
+    SDL_Rect *cursor_draw_at = &tracker->cursor_draw_at;
+    Uint8 *state = tracker->sprites.state;
+    double current = clock->now;
+    double ms_per_update = clock->ms_per_update;
+
+    // A click makes link stop and stab, unless he's still at it from the last one
+    if (tracker->mouse_pressed == 1)
+        GAN_StartHold(&tracker->link_stab, current, ms_per_update * LINK_STAB_UPDATES);
+
+    // Nothing is stepped, however many updates are banked they're used up at once
+    if (clock->lag >= ms_per_update)
+        clock->lag -= SDL_floor(clock->lag / ms_per_update) * ms_per_update;
+    if (ZT_AnimateLink(tracker, current))
+        tracker->redraw = 1;
+
+    if (tracker->showing_maps)
+        ZT_UpdateMaps(tracker);
+
+    // Hover only moves when the mouse does, and then only the old and new sprite are touched
+    if (tracker->cursor_moved == 1 || tracker->mouse_pressed == 1) {
+        int hit = GM_HitGridQuery(&tracker->hit_grid, cursor_draw_at->x, cursor_draw_at->y);
+
+        if (hit != tracker->hovered) {
+            if (tracker->hovered != GM_NO_HIT)
+                state[tracker->hovered] &= ~SPRITE_STATE_HOVER;
+            if (hit != GM_NO_HIT)
+                state[hit] |= SPRITE_STATE_HOVER;
+            tracker->hovered = hit;
+        }
+        tracker->cursor_moved = 0;
+    }
+
+    if (tracker->hovered != GM_NO_HIT) {
+        // Did we click? HANDLE IT
+        state[tracker->hovered] ^= (Uint8)(tracker->mouse_pressed == 1) * SPRITE_STATE_ON;
+        if (tracker->mouse_pressed == 1)
+            ZT_SlotChanged(tracker, tracker->hovered);
+
+        // Start the click-to-photon clock, unless an older click is still on its way
+        if (tracker->mouse_pressed == 1 && tracker->profiling && tracker->clicked_at == 0) {
+            tracker->clicked_at = tracker->pressed_at;
+            tracker->click_published = 0;
+        }
+
+        // Maybe we just pressed a 0-9 button, only items take a dungeon tag
+        if (tracker->track_for_dungeon >= 0 && tracker->hovered % tracker->runner_slots >= ZT_TOTAL_DUNGEONS) {
+            tracker->sprites.tag[tracker->hovered] = (Sint8)tracker->track_for_dungeon;
+            tracker->track_for_dungeon = -1;
+            ZT_SlotChanged(tracker, tracker->hovered);
+        }
+    }
+
+    // Whatever this update changed is one step to undo, clicks and the game's own alike
+    GH_Commit(&tracker->history);
+    if (tracker->history_steps != 0) {
+        ZT_StepHistory(tracker, tracker->history_steps);
+        tracker->history_steps = 0;
+    }
+
+    // Clicks are consumed once the update has seen them
+    tracker->mouse_pressed = 0;
+}
+
+/********************************************//**
+ * @brief
+ * Draws p50/p99/max for every phase over whatever is on the back buffer. Render side only.
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_DrawOverlay(struct Tracker *tracker) {
+    SDL_Renderer *renderer = tracker->scene.renderer;
+    const struct Profiler *profiler = &tracker->profiler;
+    int scale = tracker->placed.scale;
+    int height = ZT_OVERLAY_TEXT_HEIGHT * scale;
+    int line = height + 2 * scale;
+    SDL_Rect panel = { 0, 0, tracker->placed.pixel_w, line * (GP_TOTAL_PHASES + 1) + 4 * scale };
+    char row[48];
+
+    if (tracker->software) {
+        GX_BlendRect(&tracker->screen, &panel, 0xC0000000);
+    } else {
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xC0);
+        SDL_RenderFillRect(renderer, &panel);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    }
+
+    for (int p = -1; p < GP_TOTAL_PHASES; p++) {
+        if (p < 0)
+            snprintf(row, sizeof(row), "ms        p50   p99   max");
+        else
+            snprintf(row, sizeof(row), "%-7s %5.2f %5.2f %5.2f", GP_PHASE_NAMES[p],
+                     GP_Percentile(profiler, p, 50), GP_Percentile(profiler, p, 99), profiler->phases[p].max);
+
+        if (tracker->software)
+            GTX_DrawText(&tracker->text, &tracker->screen, row, 2 * scale, 2 * scale + line * (p + 1), height,
+                         SPRITE_MODA_ON);
+        else
+            GTX_PushText(&tracker->text, row, 2 * scale, 2 * scale + line * (p + 1), height, SPRITE_MODA_ON);
+    }
+    if (tracker->software == 0)
+        GTX_Flush(&tracker->text, renderer);
+}
+
+/********************************************//**
+ * @brief
+ * Files a presented frame's timings away: the state side's from the snapshot, the render
+ * side's from the counters taken along the way. Render side only.
+ *
+ * The click is measured up to SDL_RenderPresent returning, the nearest we can get to photons
+ * without a camera; with vsync on that's when the frame is queued for scan out.
+ * @param tracker struct Tracker*
+ * @param frame const struct FrameSnapshot*
+ * @param started Uint64 counter when rendering began
+ * @param layered Uint64 counter after the layers were brought up to date
+ * @param composed Uint64 counter after the layers were stacked
+ * @return void
+ ***********************************************/
+void ZT_RecordFrame(struct Tracker *tracker, const struct FrameSnapshot *frame,
+                    Uint64 started, Uint64 layered, Uint64 composed) {
+    struct Profiler *profiler = &tracker->profiler;
+    Uint64 presented = SDL_GetPerformanceCounter();
+
+    for (int p = 0; p < GP_STATE_PHASES; p++)
+        GP_Record(profiler, p, frame->state_ms[p]);
+    GP_Record(profiler, GP_LAYERS, GP_Ms(profiler, started, layered));
+    GP_Record(profiler, GP_COMPOSE, GP_Ms(profiler, layered, composed));
+    GP_Record(profiler, GP_PRESENT, GP_Ms(profiler, composed, presented));
+
+    if (tracker->presented_at != 0)
+        GP_Record(profiler, GP_FRAME, GP_Ms(profiler, tracker->presented_at, presented));
+    tracker->presented_at = presented;
+
+    // The same click rides along until the state side sees it's been shown, count it once
+    if (frame->clicked_at != 0 && frame->clicked_at != tracker->clicked_seen) {
+        GP_Record(profiler, GP_CLICK_TO_PHOTON, GP_Ms(profiler, frame->clicked_at, presented));
+        tracker->clicked_seen = frame->clicked_at;
+    }
+
+    GP_EndFrame(profiler, frame->sequence);
+}
+
+/********************************************//**
+ * @brief
+ * Reads the finished frame back into the export, if there is one. Goes right before the
+ * present, so it's exactly what the window shows and the one readback the frame gets. Render
+ * side only.
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_ExportFrame(struct Tracker *tracker) {
+    const struct Raster *screen = &tracker->screen;
+    Uint8 *slot;
+    int w, h;
+
+    if (tracker->exporting == 0)
+        return;
+
+    if (tracker->software) {
+        w = screen->w;
+        h = screen->h;
+    } else if (SDL_GetRendererOutputSize(tracker->scene.renderer, &w, &h) != 0) {
+        return;
+    }
+
+    slot = GEX_BeginFrame(&tracker->export, w, h);
+    if (slot == NULL)
+        return;
+
+    if (tracker->software) {
+        for (int y = 0; y < h; y++)
+            memcpy(slot + (size_t)y * tracker->export.pitch, screen->pixels + (size_t)y * screen->pitch,
+                   (size_t)w * 4);
+    } else if (SDL_RenderReadPixels(tracker->scene.renderer, NULL, SDL_PIXELFORMAT_ARGB8888, slot,
+                                    tracker->export.pitch) != 0) {
+        return;
+    }
+
+    GEX_EndFrame(&tracker->export, SDL_GetPerformanceCounter());
+}
+
+/********************************************//**
+ * @brief
+ * What has to happen before either renderer draws a snapshot: profile dumps, a new layout,
+ * lost layers. Render side only.
+ * @param tracker struct Tracker*
+ * @param frame const struct FrameSnapshot*
+ * @return int
+ * 0 to go ahead and draw, -1 if the render side can't go on
+ ***********************************************/
+int ZT_BeginRender(struct Tracker *tracker, const struct FrameSnapshot *frame) {
+    if (frame->dumps_requested != tracker->dumps_done) {
+        GP_WriteCsv(&tracker->profiler, ZT_PROFILE_PATH);
+        tracker->dumps_done = frame->dumps_requested;
+    }
+
+    // The window changed size or density, everything moves (and gets redrawn)
+    if (GLY_SameLayout(&frame->layout, &tracker->placed) == 0 && ZT_ApplyLayout(tracker, &frame->layout) != 0) {
+        SDL_AtomicSet(&tracker->render_failed, 1);
+        return -1;
+    }
+
+    // The renderer dropped our layers on the floor, build them again
+    if (frame->layers_lost != tracker->layers_seen) {
+        GC_Invalidate(&tracker->compositor);
+        if (tracker->showing_maps)
+            GMP_Invalidate(&tracker->map_cache);
+        tracker->layers_seen = frame->layers_lost;
+    }
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Brings the cached layers up to date from a snapshot, composites them with link/the cursor
+ * and presents. Render side only.
+ * @param tracker struct Tracker*
+ * @param frame const struct FrameSnapshot*
+ * @return void
+ ***********************************************/
+void ZT_Render(struct Tracker *tracker, const struct FrameSnapshot *frame) {
+    SDL_Renderer *renderer = tracker->scene.renderer;
+    struct Compositor *compositor = &tracker->compositor;
+    const struct Layout *placed = &tracker->placed;
+    SDL_Rect frm, to;
+    char label[12];
+    int total_changed;
+    Uint64 started = frame->profiling ? SDL_GetPerformanceCounter() : 0;
+    Uint64 layered = 0;
+    Uint64 composed = 0;
+
+    if (ZT_BeginRender(tracker, frame) != 0)
+        return;
+
+    // Static stuff only gets drawn the first time around (or after a reset)
+    if (compositor->background_dirty) {
+        GC_BeginBackground(compositor, renderer);
+        SDL_RenderCopy(renderer, tracker->scene.texture, NULL, NULL);
+        for (int r = 0; r < tracker->runners; r++)
+            for (int i = 0; i < ZT_TOTAL_DUNGEONS; i++) {
+                snprintf(label, sizeof(label), "%d", i + 1);
+                GTX_PushText(&tracker->text, label,
+                             placed->offset_x + (tracker->dungeon_at[i].x + r * tracker->tile_w) * placed->scale,
+                             placed->offset_y + tracker->dungeon_at[i].y * placed->scale,
+                             tracker->font_draw_rect.h * placed->scale, SPRITE_MODA_ON);
+            }
+        GTX_Flush(&tracker->text, renderer);
+        GC_EndLayer(renderer);
+    }
+
+    // Only the cells that look different from last time are redrawn into the sprite layer
+    GC_BeginSprites(compositor, renderer);
+    total_changed = GC_CollectChanged(compositor, frame->state, frame->tag, frame->total_slots, tracker->changed);
+
+    // Straight 1:1 copies, placed once per layout and drawn from the atlas scaled to match
+    for (int c = 0; c < total_changed; c++) {
+        int i = tracker->changed[c];
+
+        GC_Damage(compositor, &tracker->draw_to[i]);
+        GB_Push(&tracker->sprite_batch, &tracker->draw_frm[i], &tracker->draw_to[i],
+                SPRITE_MODA_FOR_STATE[frame->state[i] & (SPRITE_STATE_ON | SPRITE_STATE_HOVER)]);
+
+        tracker->tagged_items[tracker->total_tagged] = i;
+        tracker->total_tagged += (frame->tag[i] >= 1);
+    }
+
+    GC_ClearDamaged(compositor, renderer);
+    GB_Flush(&tracker->sprite_batch, renderer);
+
+    // Dungeon tags go on top of the freshly drawn items
+    for (int t = 0; t < tracker->total_tagged; t++) {
+        int i = tracker->tagged_items[t];
+        int height = tracker->item_track_to.h * placed->scale;
+
+        snprintf(label, sizeof(label), "%d", frame->tag[i]);
+        to.w = GTX_MeasureText(&tracker->text, label, height);
+        to.x = tracker->draw_to[i].x + (tracker->draw_to[i].w - to.w);
+        to.y = tracker->draw_to[i].y + (tracker->draw_to[i].h - height);
+        GTX_PushText(&tracker->text, label, to.x, to.y, height, SPRITE_MODA_ON);
+    }
+    GTX_Flush(&tracker->text, renderer);
+    tracker->total_tagged = 0;
+    GC_EndLayer(renderer);
+
+    // Only chunks with a cell that changed, plus a few of the hidden maps'
+    if (frame->total_cells > 0)
+        GMP_Refresh(&tracker->map_cache, renderer, &tracker->text, frame->map_marks, frame->map_tag,
+                    frame->map_shown);
+    if (frame->profiling)
+        layered = SDL_GetPerformanceCounter();
+
+    // Back to front: background, link, sprites (triforces sit on top of his stab), maps, cursor
+    GC_DrawBackground(compositor, renderer);
+    frm = GLY_Scale(&frame->link_walk_frm, tracker->sprite_factor);
+    to = GLY_ToPixels(placed, &frame->link_walk_to);
+    SDL_RenderCopy(renderer, tracker->sprite_texture, &frm, &to);
+    GC_DrawSprites(compositor, renderer);
+    if (frame->total_cells > 0)
+        GMP_Compose(&tracker->map_cache, renderer, NULL, &tracker->text, placed, tracker->maps.at,
+                    tracker->tile_w, frame->map_shown);
+    frm = GLY_Scale(&tracker->cursor, tracker->sprite_factor);
+    to = GLY_ToPixels(placed, &frame->cursor_draw_at);
+    SDL_RenderCopy(renderer, tracker->sprite_texture, &frm, &to);
+
+    if (frame->profiling == 0) {
+        tracker->presented_at = 0;
+        ZT_ExportFrame(tracker);
+        SDL_RenderPresent(renderer);
+        return;
+    }
+
+    composed = SDL_GetPerformanceCounter();
+    ZT_DrawOverlay(tracker);
+    ZT_ExportFrame(tracker);
+    SDL_RenderPresent(renderer);
+    ZT_RecordFrame(tracker, frame, started, layered, composed);
+}
+
+/********************************************//**
+ * @brief
+ * ZT_Render on the CPU: the same layers and damage, blitted straight into the window surface
+ * with no SDL_Renderer in between. Render side only.
+ * @param tracker struct Tracker*
+ * @param frame const struct FrameSnapshot*
+ * @return void
+ ***********************************************/
+void ZT_RenderSoftware(struct Tracker *tracker, const struct FrameSnapshot *frame) {
+    struct Compositor *compositor = &tracker->compositor;
+    const struct Layout *placed = &tracker->placed;
+    const struct Raster *atlas = &tracker->atlas.raster;
+    struct Raster *screen = &tracker->screen;
+    SDL_Rect to;
+    char label[12];
+    int total_changed;
+    Uint64 started = frame->profiling ? SDL_GetPerformanceCounter() : 0;
+    Uint64 layered = 0;
+    Uint64 composed = 0;
+
+    if (ZT_BeginRender(tracker, frame) != 0)
+        return;
+
+    // The scene texture is plain black, clearing the layer is all it would add
+    if (compositor->background_dirty) {
+        GC_BeginBackground(compositor, NULL);
+        for (int r = 0; r < tracker->runners; r++)
+            for (int i = 0; i < ZT_TOTAL_DUNGEONS; i++) {
+                snprintf(label, sizeof(label), "%d", i + 1);
+                GTX_DrawText(&tracker->text, &compositor->background_pixels, label,
+                             placed->offset_x + (tracker->dungeon_at[i].x + r * tracker->tile_w) * placed->scale,
+                             placed->offset_y + tracker->dungeon_at[i].y * placed->scale,
+                             tracker->font_draw_rect.h * placed->scale, SPRITE_MODA_ON);
+            }
+    }
+
+    // Every damaged cell is punched out before anything is drawn, a moved slot may overlap another
+    total_changed = GC_CollectChanged(compositor, frame->state, frame->tag, frame->total_slots, tracker->changed);
+    for (int c = 0; c < total_changed; c++)
+        GC_Damage(compositor, &tracker->draw_to[tracker->changed[c]]);
+    GC_ClearDamaged(compositor, NULL);
+
+    for (int c = 0; c < total_changed; c++) {
+        int i = tracker->changed[c];
+
+        GX_Blit(&compositor->sprite_pixels, &tracker->draw_to[i], atlas, &tracker->draw_frm[i],
+                SPRITE_MODA_FOR_STATE[frame->state[i] & (SPRITE_STATE_ON | SPRITE_STATE_HOVER)]);
+        tracker->tagged_items[tracker->total_tagged] = i;
+        tracker->total_tagged += (frame->tag[i] >= 1);
+    }
+
+    for (int t = 0; t < tracker->total_tagged; t++) {
+        int i = tracker->tagged_items[t];
+        int height = tracker->item_track_to.h * placed->scale;
+
+        snprintf(label, sizeof(label), "%d", frame->tag[i]);
+        to.w = GTX_MeasureText(&tracker->text, label, height);
+        GTX_DrawText(&tracker->text, &compositor->sprite_pixels, label,
+                     tracker->draw_to[i].x + (tracker->draw_to[i].w - to.w),
+                     tracker->draw_to[i].y + (tracker->draw_to[i].h - height), height, SPRITE_MODA_ON);
+    }
+    tracker->total_tagged = 0;
+    if (frame->total_cells > 0)
+        GMP_Refresh(&tracker->map_cache, NULL, &tracker->text, frame->map_marks, frame->map_tag,
+                    frame->map_shown);
+    if (frame->profiling)
+        layered = SDL_GetPerformanceCounter();
+
+    // Back to front: background, link, sprites (triforces sit on top of his stab), maps, cursor
+    GX_Copy(screen, &compositor->background_pixels);
+    to = GLY_ToPixels(placed, &frame->link_walk_to);
+    GX_Blit(screen, &to, atlas, &frame->link_walk_frm, SPRITE_MODA_ON);
+    GX_Over(screen, &compositor->sprite_pixels);
+    if (frame->total_cells > 0)
+        GMP_Compose(&tracker->map_cache, NULL, screen, &tracker->text, placed, tracker->maps.at,
+                    tracker->tile_w, frame->map_shown);
+    to = GLY_ToPixels(placed, &frame->cursor_draw_at);
+    GX_Blit(screen, &to, atlas, &tracker->cursor, SPRITE_MODA_ON);
+
+    if (frame->profiling == 0) {
+        tracker->presented_at = 0;
+        ZT_ExportFrame(tracker);
+        ZT_PresentScreen(tracker);
+        return;
+    }
+
+    composed = SDL_GetPerformanceCounter();
+    ZT_DrawOverlay(tracker);
+    ZT_ExportFrame(tracker);
+    ZT_PresentScreen(tracker);
+    ZT_RecordFrame(tracker, frame, started, layered, composed);
+}
+
+/********************************************//**
+ * @brief
+ * Renders the newest published snapshot, if there is one. Render side only.
+ * @param tracker struct Tracker*
+ * @return int
+ * 1 if a frame was presented, 0 if not
+ ***********************************************/
+int ZT_RenderLatest(struct Tracker *tracker) {
+    const struct FrameSnapshot *frame = GR_AcquireLatest(&tracker->ring, NULL);
+
+    if (frame == NULL)
+        return 0;
+
+    if (tracker->software)
+        ZT_RenderSoftware(tracker, frame);
+    else
+        ZT_Render(tracker, frame);
+    GR_Release(&tracker->ring);
+
+    // For the startup report, the state side only knows when it published
+    if (SDL_AtomicGet(&tracker->presented) == 0) {
+        tracker->first_presented_at = SDL_GetPerformanceCounter();
+        SDL_AtomicSet(&tracker->presented, 1);
+    }
+    return 1;
+}
+
+/********************************************//**
+ * @brief
+ * Resizes everything the render side keeps per slot, slot numbers no longer mean what they did
+ * so every layer is redrawn. Render side only.
+ * @param tracker struct Tracker*
+ * @param total_slots int
+ * @return int
+ * 0 on success, -1 if we're out of memory
+ ***********************************************/
+int ZT_ResizeRenderSlots(struct Tracker *tracker, int total_slots) {
+    int *changed = realloc(tracker->changed, sizeof(int) * total_slots);
+    int *tagged_items;
+    SDL_Rect *draw_to;
+    SDL_Rect *draw_frm;
+
+    if (changed == NULL)
+        return -1;
+    tracker->changed = changed;
+
+    tagged_items = realloc(tracker->tagged_items, sizeof(int) * total_slots);
+    if (tagged_items == NULL)
+        return -1;
+    tracker->tagged_items = tagged_items;
+
+    draw_to = realloc(tracker->draw_to, sizeof(SDL_Rect) * total_slots);
+    if (draw_to == NULL)
+        return -1;
+    tracker->draw_to = draw_to;
+
+    draw_frm = realloc(tracker->draw_frm, sizeof(SDL_Rect) * total_slots);
+    if (draw_frm == NULL)
+        return -1;
+    tracker->draw_frm = draw_frm;
+
+    return GC_ResizeSlots(&tracker->compositor, tracker->scene.renderer, total_slots);
+}
+
+/********************************************//**
+ * @brief
+ * Render side of a reload (see ZT_Reload): re-resolves the slots that changed, punches out
+ * where they were and re-uploads whatever moved in the sheet. Only what changed is redrawn,
+ * unless the number of slots did.
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_ApplyReload(struct Tracker *tracker) {
+    struct ReloadPlan *plan = &tracker->reload;
+    struct Compositor *compositor = &tracker->compositor;
+    struct SpriteStore *sprites = &tracker->sprites;
+    SDL_Rect sheet_changed[ZT_MAX_SHEET_CHANGES];
+    int total_changed;
+
+    if (plan->pending == 0)
+        return;
+
+    if (plan->resized) {
+        if (ZT_ResizeRenderSlots(tracker, sprites->total) != 0) {
+            DEBUG_ERR("Out of memory reloading the sprites, quitting");
+            SDL_AtomicSet(&tracker->render_failed, 1);
+        }
+
+        // Runner 0's block is enough, ZT_ResolveSlot hands every picture on to the others
+        for (int i = ZT_TOTAL_DUNGEONS;
+             i < tracker->runner_slots && SDL_AtomicGet(&tracker->render_failed) == 0; i++)
+            if (i == ZT_TOTAL_DUNGEONS || (sprites->state[i] & SPRITE_STATE_DISABLED) == 0)
+                ZT_ResolveSlot(tracker, i);
+    } else {
+        for (int p = 0; p < plan->total; p++) {
+            int slot = plan->slots[p];
+            int local = slot % tracker->runner_slots;
+
+            if (plan->was_at[p].w > 0) {
+                SDL_Rect was_at = GLY_ToPixels(&tracker->placed, &plan->was_at[p]);
+                GC_Damage(compositor, &was_at);
+            }
+            GC_ForgetSlot(compositor, slot);
+            if (local != ZT_TOTAL_DUNGEONS && (sprites->state[slot] & SPRITE_STATE_DISABLED) == SPRITE_STATE_DISABLED)
+                continue;
+
+            ZT_ResolveSlot(tracker, slot);
+            if (local == ZT_TOTAL_DUNGEONS)
+                for (int i = slot - local; i < slot - local + ZT_TOTAL_DUNGEONS; i++)
+                    GC_ForgetSlot(compositor, i);
+        }
+    }
+
+    // Same rects, new pixels, anything drawn from one of them has to be drawn again
+    if (plan->sheet && SDL_AtomicGet(&tracker->render_failed) == 0) {
+        total_changed = GA_ReloadSheet(&tracker->atlas, sheet_changed, ZT_MAX_SHEET_CHANGES);
+        if (total_changed > ZT_MAX_SHEET_CHANGES) {
+            GC_Invalidate(compositor);
+        } else {
+            for (int c = 0; c < total_changed; c++)
+                for (int i = 0; i < sprites->total; i++)
+                    if (SDL_HasIntersection(&sprites->frm[i], &sheet_changed[c]))
+                        GC_ForgetSlot(compositor, i);
+        }
+    }
+    GA_ReleaseSheet(&tracker->atlas);
+    if (SDL_AtomicGet(&tracker->render_failed) == 0)
+        ZT_PlaceSlots(tracker);
+
+    plan->pending = 0;
+    plan->sheet = 0;
+    plan->resized = 0;
+    plan->total = 0;
+}
+
+void ZT_DestroyRenderer(struct Tracker *tracker) {
+    GTX_DestroyText(&tracker->text);
+    GB_DestroyBatch(&tracker->sprite_batch);
+    GC_DestroyCompositor(&tracker->compositor);
+    GMP_DestroyCache(&tracker->map_cache);
+    free(tracker->changed);
+    free(tracker->tagged_items);
+    free(tracker->draw_to);
+    free(tracker->draw_frm);
+    tracker->changed = NULL;
+    tracker->tagged_items = NULL;
+    tracker->draw_to = NULL;
+    tracker->draw_frm = NULL;
+
+    if (tracker->exporting)
+        GEX_CloseExport(&tracker->export);
+    tracker->exporting = 0;
+
+    GX_DestroyRaster(&tracker->screen);
+    SDL_FreeSurface(tracker->scene.surface);
+    GA_DestroyAtlas(&tracker->atlas);
+    if (tracker->scene.renderer != NULL) {
+        SDL_DestroyTexture(tracker->scene.texture);
+        SDL_DestroyRenderer(tracker->scene.renderer);
+    }
+    tracker->scene.renderer = NULL;
+}
+
+/********************************************//**
+ * @brief
+ * The render thread, owns the renderer from creation to destruction. Sleeps until the state
+ * side publishes and then draws the newest snapshot, so a present stuck on vsync never holds
+ * up input.
+ * @param data void* the struct Tracker
+ * @return int
+ ***********************************************/
+int ZT_RenderThread(void *data) {
+    struct Tracker *tracker = data;
+
+    SDL_AtomicSet(&tracker->render_failed, ZT_StartRenderer(tracker) != 0);
+    if (SDL_AtomicGet(&tracker->render_failed) == 0) {
+        SDL_SemWait(tracker->layout_ready);
+        SDL_AtomicSet(&tracker->render_failed,
+                      SDL_AtomicGet(&tracker->render_quit) || ZT_InitRenderer(tracker) != 0);
+    }
+    SDL_SemPost(tracker->render_ready);
+    if (SDL_AtomicGet(&tracker->render_failed)) {
+        ZT_DestroyRenderer(tracker);
+        return -1;
+    }
+
+    while (SDL_AtomicGet(&tracker->render_quit) == 0 && SDL_AtomicGet(&tracker->render_failed) == 0) {
+        GR_Wait(&tracker->ring, ZT_RENDER_IDLE_MS);
+
+        // The state side is reloading, stay out of its way until it's done
+        if (SDL_AtomicGet(&tracker->render_pause)) {
+            SDL_SemPost(tracker->render_paused);
+            SDL_SemWait(tracker->render_resume);
+            ZT_ApplyReload(tracker);
+            continue;
+        }
+
+        ZT_RenderLatest(tracker);
+    }
+
+    ZT_DestroyRenderer(tracker);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Copies what the renderer needs out of the state side
+ * @param tracker struct Tracker*
+ * @param frame struct FrameSnapshot*
+ * @return void
+ ***********************************************/
+void ZT_TakeSnapshot(const struct Tracker *tracker, struct FrameSnapshot *frame) {
+    memcpy(frame->state, tracker->sprites.state, sizeof(Uint8) * frame->total_slots);
+    memcpy(frame->tag, tracker->sprites.tag, sizeof(Sint8) * frame->total_slots);
+    if (frame->total_cells > 0) {
+        memcpy(frame->map_marks, tracker->maps.marks, sizeof(Uint8) * frame->total_cells);
+        memcpy(frame->map_tag, tracker->maps.tag, sizeof(Sint8) * frame->total_cells);
+        memcpy(frame->map_shown, tracker->maps.shown, sizeof(frame->map_shown));
+    }
+    frame->link_walk_frm = tracker->link_walk_frm;
+    frame->link_walk_to = tracker->link_walk_to;
+    frame->cursor_draw_at = tracker->cursor_draw_at;
+    frame->layers_lost = tracker->layers_lost;
+    frame->layout = tracker->layout;
+
+    frame->profiling = tracker->profiling;
+    memcpy(frame->state_ms, tracker->state_ms, sizeof(frame->state_ms));
+    frame->clicked_at = tracker->clicked_at;
+    frame->dumps_requested = tracker->dumps_requested;
+}
+
+/********************************************//**
+ * @brief
+ * Parks the render thread where it can't see the state side, so the layout and the ring can be
+ * changed under it. Does nothing when rendering inline.
+ * @param tracker struct Tracker*
+ * @return int
+ * 0 once the renderer is parked, -1 if it's gone
+ ***********************************************/
+int ZT_PauseRenderer(struct Tracker *tracker) {
+    if (tracker->threaded == 0)
+        return 0;
+
+    SDL_AtomicSet(&tracker->render_pause, 1);
+    GR_Wake(&tracker->ring);
+    while (SDL_SemWaitTimeout(tracker->render_paused, ZT_RENDER_IDLE_MS) != 0)
+        if (SDL_AtomicGet(&tracker->render_failed))
+            return -1;
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Lets the renderer go again, it works through the reload plan before its next frame
+ * @param tracker struct Tracker*
+ * @return void
+ ***********************************************/
+void ZT_ResumeRenderer(struct Tracker *tracker) {
+    if (tracker->threaded == 0) {
+        ZT_ApplyReload(tracker);
+        return;
+    }
+
+    SDL_AtomicSet(&tracker->render_pause, 0);
+    SDL_SemPost(tracker->render_resume);
+}
+
+/********************************************//**
+ * @brief
+ * Publishes every presented frame to a shared memory ring and/or appends it to a file (see
+ * GameExport.h). The renderer is parked while it's set up.
+ * @param tracker struct Tracker*
+ * @param shm_name const char* shared memory object ("/zelda-tracker"), NULL for none
+ * @param sink_path const char* .y4m or raw ARGB8888 file, NULL for none
+ * @param fps int frame rate of a .y4m
+ * @return int
+ * 0 on success, -1 on failure (the tracker carries on without it)
+ ***********************************************/
+int ZT_StartExport(struct Tracker *tracker, const char *shm_name, const char *sink_path, int fps) {
+    int result;
+
+    if (ZT_PauseRenderer(tracker) != 0)
+        return -1;
+
+    result = GEX_OpenExport(&tracker->export, shm_name, sink_path, fps);
+    if (result != 0)
+        GEX_CloseExport(&tracker->export);
+    tracker->exporting = (result == 0);
+    ZT_ResumeRenderer(tracker);
+
+    // Something to read straight away, nothing else is presented until something changes
+    tracker->redraw = 1;
+    return result;
+}
+
+/********************************************//**
+ * @brief
+ * Swaps in a freshly loaded sprites config with the renderer parked. Items are matched to the
+ * old ones by name, so clicks and tags follow an item wherever it moves, and only the slots
+ * whose place or picture changed go into the reload plan. If the number of items changed the
+ * ring, the hit grid and the journal are rebuilt for the new slot count. Every runner keeps its
+ * own clicks and tags.
+ * @param tracker struct Tracker*
+ * @param next struct SpriteConfig* the tracker owns it on success
+ * @return int
+ * 0 on success, -1 if we're out of memory (nothing was changed)
+ ***********************************************/
+int ZT_Relayout(struct Tracker *tracker, struct SpriteConfig *next) {
+    struct SpriteStore *sprites = &tracker->sprites;
+    struct ReloadPlan *plan = &tracker->reload;
+    const struct SpriteEntry *was = tracker->sprite_config.entries;
+    int was_total = tracker->total_sprites;
+    int was_slots = tracker->runner_slots;
+    int total = next->total_entries;
+    int runner_slots = ZT_TOTAL_DUNGEONS + total;
+    int total_slots = tracker->runners * runner_slots;
+    int resized = (total != was_total);
+    int names_changed = resized;
+    Uint8 *kept_state = calloc(total_slots, sizeof(Uint8));
+    Sint8 *kept_tag = malloc(sizeof(Sint8) * total_slots);
+    Uint8 *claimed = calloc(was_total, sizeof(Uint8));
+    int *was_entry = malloc(sizeof(int) * total);
+    int buckets = 16;
+    int *by_name;
+    struct SnapshotRing ring;
+    struct HitGrid hit_grid;
+
+    memset(&ring, 0, sizeof(ring));
+    memset(&hit_grid, 0, sizeof(hit_grid));
+
+    // Old entries by name, open addressing at most half full
+    while (buckets < 2 * was_total)
+        buckets *= 2;
+    by_name = malloc(sizeof(int) * buckets);
+
+    // Everything that can fail comes first, so a failure leaves the old layout alone
+    if (kept_state == NULL || kept_tag == NULL || claimed == NULL || was_entry == NULL || by_name == NULL
+        || GE_ReserveStore(sprites, total_slots) != 0 || ZT_ReservePlan(plan, plan->total + total_slots) != 0
+        || (resized && (GR_InitRing(&ring, total_slots, tracker->maps.total) != 0
+                        || GM_InitHitGrid(&hit_grid, SPRITE_WIDTH, SPRITE_HEIGHT, total_slots) != 0))) {
+        free(kept_state);
+        free(kept_tag);
+        free(claimed);
+        free(was_entry);
+        free(by_name);
+        GR_DestroyRing(&ring);
+        GM_DestroyHitGrid(&hit_grid);
+        return -1;
+    }
+
+    memset(by_name, -1, sizeof(int) * buckets);
+    for (int w = 0; w < was_total; w++) {
+        int at = (int)(GCF_HashName(was[w].name) & (Uint64)(buckets - 1));
+
+        while (by_name[at] >= 0)
+            at = (at + 1) & (buckets - 1);
+        by_name[at] = w;
+    }
+
+    // Same names come up in the order they were added, so duplicates still pair off first to first
+    for (int i = 0; i < total; i++) {
+        int at = (int)(GCF_HashName(next->entries[i].name) & (Uint64)(buckets - 1));
+
+        was_entry[i] = -1;
+        if (i < was_total && strcmp(next->entries[i].name, was[i].name) != 0)
+            names_changed = 1;
+
+        for (; by_name[at] >= 0; at = (at + 1) & (buckets - 1)) {
+            int w = by_name[at];
+
+            if (claimed[w] || strcmp(next->entries[i].name, was[w].name) != 0)
+                continue;
+
+            claimed[w] = 1;
+            was_entry[i] = w;
+            break;
+        }
+    }
+    free(by_name);
+
+    // Every runner's block moves if the number of items changed, collect before anything does
+    for (int r = 0; r < tracker->runners; r++) {
+        for (int i = 0; i < runner_slots; i++) {
+            int slot = r * runner_slots + i;
+            int was_slot = (i < ZT_TOTAL_DUNGEONS) ? r * was_slots + i
+                           : (was_entry[i - ZT_TOTAL_DUNGEONS] >= 0)
+                             ? r * was_slots + ZT_TOTAL_DUNGEONS + was_entry[i - ZT_TOTAL_DUNGEONS] : -1;
+
+            kept_state[slot] = (was_slot >= 0) ? sprites->state[was_slot] & SPRITE_STATE_ON : 0;
+            kept_tag[slot] = (was_slot >= 0) ? sprites->tag[was_slot] : -1;
+        }
+    }
+
+    while (sprites->total < total_slots)
+        GE_AddSprite(sprites, 0, 0, SPRITE_STATE_OFF);
+    while (sprites->total > total_slots)
+        GE_RemoveSprite(sprites, GE_HandleAt(sprites, sprites->total - 1));
+
+    // Whatever was hovered may not even be there any more, the next update finds out
+    for (int i = 0; i < sprites->total; i++)
+        sprites->state[i] &= ~SPRITE_STATE_HOVER;
+
+    ZT_LayoutItems(sprites, next->entries, total, resized ? NULL : plan);
+    ZT_CloneRunners(sprites, tracker->runners, runner_slots, tracker->tile_w, resized ? NULL : plan);
+    for (int slot = 0; slot < total_slots; slot++) {
+        sprites->state[slot] = (Uint8)((sprites->state[slot] & ~SPRITE_STATE_ON) | kept_state[slot]);
+        sprites->tag[slot] = kept_tag[slot];
+    }
+    free(kept_state);
+    free(kept_tag);
+    free(claimed);
+    free(was_entry);
+
+    GCF_UnloadConfig(&tracker->sprite_config);
+    tracker->sprite_config = *next;
+    tracker->total_sprites = total;
+    tracker->runner_slots = runner_slots;
+
+    // Snapshots already published were taken against the old layout
+    if (resized) {
+        GR_DestroyRing(&tracker->ring);
+        tracker->ring = ring;
+        GM_DestroyHitGrid(&tracker->hit_grid);
+        tracker->hit_grid = hit_grid;
+        plan->resized = 1;
+    } else {
+        GR_Drop(&tracker->ring);
+    }
+
+    if (ZT_BuildHitGrid(tracker) != 0)
+        DEBUG_ERR("Unable to rebuild the hit grid");
+
+    // Slots moved, history recorded against the old ones would undo the wrong items
+    ZT_ResetHistory(tracker);
+
+    // More rows than fit, the layout grows and the window with it
+    if (ZT_HeightForSprites(total) > tracker->scene.h) {
+        tracker->scene.h = ZT_HeightForSprites(total);
+        SDL_SetWindowMinimumSize(tracker->scene.window, tracker->scene.w, tracker->scene.h);
+        GLY_FitWindow(&tracker->layout, tracker->scene.window, tracker->scene.w, tracker->scene.h);
+    }
+
+    // Slot numbers on disk mean something else now, start over from a snapshot
+    if (tracker->journaling && resized) {
+        char path[sizeof(tracker->journal.path)];
+        Uint32 epoch;
+
+        snprintf(path, sizeof(path), "%s", tracker->journal.path);
+        epoch = GJ_CloseJournal(&tracker->journal, NULL, NULL);
+        tracker->journaling = 0;
+        if (GJ_OpenJournal(&tracker->journal, path, sprites->state, sprites->tag, sprites->total, epoch) != 0) {
+            GJ_CloseJournal(&tracker->journal, NULL, NULL);
+            DEBUG_ERR("Unable to reopen the tracker journal");
+        } else {
+            tracker->journaling = 1;
+        }
+    } else if (tracker->journaling) {
+        tracker->journal.behind = 1;
+    }
+
+    // Overlays only get the names when they connect, make them connect again if those changed
+    if (tracker->serving && names_changed) {
+        GS_StopServer(&tracker->server);
+        tracker->serving = 0;
+        if (ZT_StartServer(tracker, tracker->server_port) != 0)
+            DEBUG_ERR("Unable to restart the state server");
+    } else if (tracker->serving) {
+        tracker->server.behind = 1;
+    }
+
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Picks up edits to sprites.cfg and/or the sprite sheet without a restart. A config that
+ * doesn't parse is reported and the old one kept. The state side does its half with the
+ * renderer parked, the render side catches up in ZT_ApplyReload.
+ * @param tracker struct Tracker*
+ * @param changed Uint32 ZT_WATCH_* bits
+ * @return void
+ ***********************************************/
+void ZT_Reload(struct Tracker *tracker, Uint32 changed) {
+    struct SpriteConfig next;
+    Uint64 started = SDL_GetPerformanceCounter();
+    char message[256];
+    int relayout = 0;
+
+    if (changed & ZT_WATCH_SPRITES) {
+        if (GCF_LoadConfig(&next, tracker->sprites_path) != 0) {
+            GCF_FormatError(&next, tracker->sprites_path, message, sizeof(message));
+            DEBUG_ERR(message);
+        } else if (next.total_entries < 1) {
+            DEBUG_ERR("The sprites configuration file is empty, keeping the old one");
+            GCF_UnloadConfig(&next);
+        } else {
+            relayout = 1;
+        }
+    }
+
+    if (relayout == 0 && (changed & ZT_WATCH_SHEET) == 0)
+        return;
+
+    if (ZT_PauseRenderer(tracker) != 0) {
+        if (relayout)
+            GCF_UnloadConfig(&next);
+        return;
+    }
+
+    if (relayout && ZT_Relayout(tracker, &next) != 0) {
+        DEBUG_ERR("Out of memory reloading the sprites, keeping the old ones");
+        GCF_UnloadConfig(&next);
+    } else if (relayout) {
+        for (int r = 0; r < tracker->ram_sources; r++)
+            ZT_BindRam(tracker, &tracker->ram[r]);
+        for (int r = 0; r < tracker->video_sources; r++)
+            for (int t = 0; t < tracker->vision[r].total_templates; t++)
+                tracker->vision[r].templates[t].slot = ZT_SlotForName(tracker, tracker->vision[r].templates[t].name);
+    }
+    if (changed & ZT_WATCH_SHEET)
+        tracker->reload.sheet = 1;
+    tracker->reload.pending = 1;
+
+    // A click in flight was published against the old ring
+    tracker->clicked_at = 0;
+    tracker->redraw = 1;
+    ZT_ResumeRenderer(tracker);
+
+    snprintf(message, sizeof(message), "Reloaded %s%s%s in %.3f ms",
+             (relayout) ? tracker->sprites_path : "", (relayout && (changed & ZT_WATCH_SHEET)) ? " and " : "",
+             (changed & ZT_WATCH_SHEET) ? GA_SHEET_PATH : "",
+             (double)(SDL_GetPerformanceCounter() - started) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    DEBUG_LOG(message);
+}
+
+/********************************************//**
+ * @brief
+ * Advances, updates and (if there's something new and the frame cap allows) hands a frame to
+ * the renderer, rendering it right here in ZT_RENDER_INLINE mode. Events should already have
+ * gone through ZT_HandleEvent.
+ * @param tracker struct Tracker*
+ * @return int
+ * 1 if a frame was handed over (and presented, inline), 0 if not
+ ***********************************************/
+int ZT_Frame(struct Tracker *tracker) {
+    struct FrameSnapshot *frame;
+    Uint64 started = ZT_ProfileBegin(tracker);
+
+    // A click is off the books once the renderer has let go of a snapshot showing it
+    if (tracker->clicked_at != 0 && tracker->click_published
+        && (Uint32)SDL_AtomicGet(&tracker->ring.tail) > tracker->clicked_in)
+        tracker->clicked_at = 0;
+
+    // The renderer gave up, there's nothing left to show
+    if (SDL_AtomicGet(&tracker->render_failed)) {
+        tracker->quit = -1;
+        return 0;
+    }
+
+    if (tracker->watching) {
+        Uint32 changed = GW_Poll(&tracker->watch);
+        if (changed != 0)
+            ZT_Reload(tracker, changed);
+    }
+
+    if (tracker->ram_sources > 0)
+        ZT_PollRam(tracker);
+    if (tracker->video_sources > 0)
+        ZT_PollVision(tracker);
+
+    ZT_Update(tracker);
+    if (tracker->journaling)
+        GJ_Maintain(&tracker->journal, tracker->sprites.state, tracker->sprites.tag);
+    if (tracker->map_journaling)
+        GJ_Maintain(&tracker->map_journal, tracker->maps.marks, tracker->maps.tag);
+    if (tracker->serving)
+        GS_Maintain(&tracker->server, tracker->sprites.state, tracker->sprites.tag);
+    ZT_ProfileEnd(tracker, GP_UPDATE, started);
+
+    // Keep the overlay's numbers moving even when nothing else is
+    if (tracker->profiling && tracker->clock.now >= tracker->next_overlay_at) {
+        tracker->next_overlay_at = tracker->clock.now + ZT_OVERLAY_REFRESH_MS;
+        tracker->redraw = 1;
+    }
+
+    // Nothing moved and nothing was clicked, or we're ahead of the frame cap
+    if (tracker->redraw == 0 || GT_CanPresent(&tracker->clock) == 0)
+        return 0;
+
+    // The renderer is a whole ring behind, keep the redraw and try again a frame from now
+    frame = GR_BeginWrite(&tracker->ring);
+    if (frame == NULL) {
+        GT_FramePresented(&tracker->clock);
+        return 0;
+    }
+
+    started = ZT_ProfileBegin(tracker);
+    ZT_TakeSnapshot(tracker, frame);
+    if (tracker->clicked_at != 0 && tracker->click_published == 0) {
+        tracker->clicked_in = (Uint32)SDL_AtomicGet(&tracker->ring.head);
+        tracker->click_published = 1;
+    }
+    if (tracker->profiling) {
+        frame->state_ms[GP_PUBLISH] = GP_Ms(&tracker->profiler, started, SDL_GetPerformanceCounter());
+        memset(tracker->state_ms, 0, sizeof(tracker->state_ms));
+    }
+    GR_Publish(&tracker->ring);
+    GT_FramePresented(&tracker->clock);
+    tracker->redraw = 0;
+
+    if (tracker->threaded == 0) {
+        GR_Wait(&tracker->ring, 0);
+        ZT_RenderLatest(tracker);
+    }
+
+    return 1;
+}
+
+/////////////////////
+//
+// ALWAYS CLEANUP ASSETS DUDE
+//
+/////////////////////
+void ZT_DestroyTracker(struct Tracker *tracker) {
+    // A failed start can leave the loaders running, or their results never picked up
+    GSU_FinishJob(&tracker->font_job, NULL);
+    GSU_FinishJob(&tracker->config_job, NULL);
+    SDL_FreeSurface(tracker->glyph_sheet);
+    SDL_FreeSurface(tracker->preloaded_sheet);
+    tracker->glyph_sheet = NULL;
+    tracker->preloaded_sheet = NULL;
+
+    if (tracker->threaded) {
+        if (tracker->render_thread != NULL) {
+            SDL_AtomicSet(&tracker->render_quit, 1);
+            GR_Wake(&tracker->ring);
+            SDL_WaitThread(tracker->render_thread, NULL);
+        }
+        if (tracker->render_ready != NULL)
+            SDL_DestroySemaphore(tracker->render_ready);
+        if (tracker->render_paused != NULL)
+            SDL_DestroySemaphore(tracker->render_paused);
+        if (tracker->render_resume != NULL)
+            SDL_DestroySemaphore(tracker->render_resume);
+        if (tracker->layout_ready != NULL)
+            SDL_DestroySemaphore(tracker->layout_ready);
+    } else {
+        ZT_DestroyRenderer(tracker);
+    }
+
+    if (tracker->watching)
+        GW_DestroyWatch(&tracker->watch);
+    free(tracker->reload.slots);
+    free(tracker->reload.was_at);
+    for (int r = 0; r < tracker->ram_sources; r++)
+        GRM_DestroyWatch(&tracker->ram[r]);
+    for (int r = 0; r < tracker->video_sources; r++)
+        GV_DestroyVision(&tracker->vision[r]);
+    if (tracker->serving)
+        GS_StopServer(&tracker->server);
+    if (tracker->journaling)
+        GJ_CloseJournal(&tracker->journal, tracker->sprites.state, tracker->sprites.tag);
+    if (tracker->map_journaling)
+        GJ_CloseJournal(&tracker->map_journal, tracker->maps.marks, tracker->maps.tag);
+    GMP_DestroyMaps(&tracker->maps);
+    GR_DestroyRing(&tracker->ring);
+    GM_DestroyHitGrid(&tracker->hit_grid);
+    GH_DestroyHistory(&tracker->history);
+    free(tracker->history_changed);
+    GCF_UnloadConfig(&tracker->sprite_config);
+    GE_DestroyStore(&tracker->sprites);
+
+    SDL_DestroyWindow(tracker->scene.window);
+    if (tracker->game_font != NULL)
+        TTF_CloseFont(tracker->game_font);
+}
+
+#endif //ZELDATRACKER_ZELDATRACKER_H
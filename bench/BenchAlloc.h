@@ -0,0 +1,43 @@
+#ifndef ZELDATRACKER_BENCHALLOC_H
+#define ZELDATRACKER_BENCHALLOC_H
+
+/*
+ * Allocation counting for the benchmarks, glibc lets us wrap malloc and friends from the
+ * executable. Include it from the one file that has main(). Counts only move while
+ * bench_counting is set, and stay at 0 anywhere but glibc.
+ */
+static int bench_counting = 0;
+static unsigned long long bench_allocs = 0;
+static unsigned long long bench_alloc_bytes = 0;
+
+#if defined(__GLIBC__)
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+void *malloc(size_t size) {
+    if (__atomic_load_n(&bench_counting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bench_alloc_bytes, size, __ATOMIC_RELAXED);
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (__atomic_load_n(&bench_counting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bench_alloc_bytes, count * size, __ATOMIC_RELAXED);
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (__atomic_load_n(&bench_counting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&bench_alloc_bytes, size, __ATOMIC_RELAXED);
+    }
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+#endif //ZELDATRACKER_BENCHALLOC_H
@@ -0,0 +1,311 @@
+/*
+ * Headless frame benchmark. Runs the tracker's real update/render path (ZT_HandleEvent /
+ * ZT_Frame) on SDL's dummy video driver with the software renderer, replays a recorded
+ * input script on a fixed 60 Hz clock and reports frame time percentiles, frames/sec and
+ * allocations.
+ *
+ * Run it from the repo root so the sheet/font/sprites.cfg are found:
+ *   ZeldaTrackerFrameBench [--frames N] [--scale N] [--script path] [--fps N] [--runners N] [--maps]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL2/SDL.h"
+#include "SDL2/SDL_ttf.h"
+#include "SDL2/SDL_image.h"
+
+#include "ZeldaTracker.h"
+#include "BenchAlloc.h"
+
+#ifndef ZT_BENCH_SCRIPT
+#define ZT_BENCH_SCRIPT "bench/replay.txt"
+#endif
+#ifndef ZT_BENCH_SCRATCH
+#define ZT_BENCH_SCRATCH "bench_sprites.cfg"
+#endif
+
+const int BENCH_MAX_EVENTS = 4096;
+const int BENCH_WARMUP_FRAMES = 60;
+
+//////////////////////////////
+//
+// Input script, one event per line: <frame> motion|click <x> <y>  or  <frame> key <0-9>
+// The script loops, its length is the last frame mentioned + 1 (or an explicit "<frame> end")
+//
+//////////////////////////////
+struct ReplayEvent {
+    int frame;
+    SDL_Event event;
+};
+
+int BENCH_LoadScript(const char *path, struct ReplayEvent *events, int max_events, int *length) {
+    FILE *script = fopen(path, "r");
+    char line[128];
+    char kind[16];
+    int frame, a, b, args;
+    int total = 0;
+
+    *length = 1;
+    if (script == NULL) {
+        DEBUG_ERR("Unable to open the replay script");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), script) != NULL && total < max_events - 1) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+
+        args = sscanf(line, "%d %15s %d %d", &frame, kind, &a, &b);
+        if (args < 2)
+            continue;
+
+        if (frame + 1 > *length)
+            *length = frame + 1;
+
+        struct ReplayEvent *re = &events[total];
+        memset(re, 0, sizeof(*re));
+        re->frame = frame;
+
+        if (strcmp(kind, "motion") == 0 && args == 4) {
+            re->event.type = SDL_MOUSEMOTION;
+            re->event.motion.x = a;
+            re->event.motion.y = b;
+        } else if (strcmp(kind, "click") == 0 && args == 4) {
+            re->event.type = SDL_MOUSEBUTTONDOWN;
+            re->event.button.button = SDL_BUTTON_LEFT;
+            re->event.button.state = SDL_PRESSED;
+            re->event.button.x = a;
+            re->event.button.y = b;
+        } else if (strcmp(kind, "key") == 0 && args >= 3 && a >= 0 && a <= 9) {
+            re->event.type = SDL_KEYDOWN;
+            re->event.key.state = SDL_PRESSED;
+            re->event.key.keysym.scancode = (a == 0) ? SDL_SCANCODE_0 : (SDL_Scancode)(SDL_SCANCODE_1 + a - 1);
+        } else if (strcmp(kind, "end") == 0) {
+            continue;
+        } else {
+            fprintf(stderr, "replay: skipping bad line: %s", line);
+            continue;
+        }
+
+        total++;
+    }
+
+    fclose(script);
+    return total;
+}
+
+/********************************************//**
+ * @brief
+ * Writes sprites.cfg out scale times back to back so the tracker lays out 22 x scale items
+ * @param scale int
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int BENCH_WriteScaledSprites(int scale) {
+    FILE *in = fopen("sprites.cfg", "r");
+    FILE *out = fopen(ZT_BENCH_SCRATCH, "w");
+    char line[128];
+
+    if (in == NULL || out == NULL) {
+        DEBUG_ERR("Unable to write the scaled sprites configuration");
+        if (in != NULL)
+            fclose(in);
+        if (out != NULL)
+            fclose(out);
+        return -1;
+    }
+
+    for (int i = 0; i < scale; i++) {
+        rewind(in);
+        while (fgets(line, sizeof(line), in) != NULL) {
+            fputs(line, out);
+            if (strchr(line, '\n') == NULL)
+                fputc('\n', out);
+        }
+    }
+
+    fclose(in);
+    fclose(out);
+    return 0;
+}
+
+int BENCH_CompareDoubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+double BENCH_Percentile(const double *sorted, int total, double p) {
+    int at = (int)(p * (total - 1) + 0.5);
+    return sorted[at];
+}
+
+/********************************************//**
+ * @brief
+ * The measured run, SDL and SDL_ttf are up. Tears down whatever of the tracker came up.
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int BENCH_Run(const char *sprites_path, const struct ReplayEvent *script, int total_events, int script_length,
+              double *frame_ms, int frames, float target_fps, int mode, int runners, int show_maps) {
+    struct Tracker tracker;
+    SDL_Event e;
+    int next_event, presented = 0;
+    double total_ms = 0;
+    double ms_per_frame;
+    Uint64 frequency, started, finished;
+
+    // Size the window to fit every item, this also primes the sprites cache
+    struct SpriteConfig sizing;
+    if (GCF_LoadConfig(&sizing, sprites_path) != 0)
+        return -1;
+    int total_sprites = sizing.total_entries;
+    GCF_UnloadConfig(&sizing);
+
+    if (ZT_InitTracker(&tracker, WINDOW_WIDTH, ZT_HeightForSprites(total_sprites),
+                       "Zelda Tracker Bench", sprites_path, target_fps, mode, runners, show_maps) != 0) {
+        ZT_DestroyTracker(&tracker);
+        return -1;
+    }
+    GSU_Mark("tracker", GSU_STARTUP.started, NULL);
+    GSU_Report();
+
+    ms_per_frame = tracker.clock.ms_per_update;
+    frequency = SDL_GetPerformanceFrequency();
+    next_event = 0;
+
+    for (int frame = -BENCH_WARMUP_FRAMES; frame < frames; frame++) {
+        int script_frame = ((frame % script_length) + script_length) % script_length;
+
+        if (frame == 0) {
+            bench_allocs = 0;
+            bench_alloc_bytes = 0;
+            __atomic_store_n(&bench_counting, 1, __ATOMIC_RELAXED);
+        }
+
+        if (script_frame == 0)
+            next_event = 0;
+
+        // Scripted input goes through the real event queue
+        while (next_event < total_events && script[next_event].frame == script_frame) {
+            e = script[next_event++].event;
+            SDL_PushEvent(&e);
+        }
+
+        started = SDL_GetPerformanceCounter();
+        while (SDL_PollEvent(&e))
+            ZT_HandleEvent(&tracker, &e);
+
+        GT_AdvanceBy(&tracker.clock, ms_per_frame);
+        int drew = ZT_Frame(&tracker);
+        finished = SDL_GetPerformanceCounter();
+
+        if (frame >= 0) {
+            frame_ms[frame] = (double)(finished - started) * 1000.0 / (double)frequency;
+            total_ms += frame_ms[frame];
+            presented += drew;
+        }
+    }
+    __atomic_store_n(&bench_counting, 0, __ATOMIC_RELAXED);
+
+    qsort(frame_ms, frames, sizeof(double), BENCH_CompareDoubles);
+
+    printf("renderer: software (dummy video)   items: %d   frames: %d   presented: %d\n",
+           tracker.total_sprites, frames, presented);
+    printf("frame ms   p50 %.4f   p90 %.4f   p99 %.4f   max %.4f   mean %.4f\n",
+           BENCH_Percentile(frame_ms, frames, 0.50),
+           BENCH_Percentile(frame_ms, frames, 0.90),
+           BENCH_Percentile(frame_ms, frames, 0.99),
+           frame_ms[frames - 1],
+           total_ms / frames);
+    printf("frames/sec %.1f\n", (total_ms > 0) ? frames * 1000.0 / total_ms : 0.0);
+#if defined(__GLIBC__)
+    printf("allocations %llu (%.2f/frame)   bytes %llu (%.1f/frame)\n",
+           bench_allocs, (double)bench_allocs / frames,
+           bench_alloc_bytes, (double)bench_alloc_bytes / frames);
+#else
+    printf("allocations n/a (needs glibc)\n");
+#endif
+
+    ZT_DestroyTracker(&tracker);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    struct ReplayEvent *script;
+    const char *script_path = ZT_BENCH_SCRIPT;
+    const char *sprites_path = "sprites.cfg";
+    int frames = 3600;
+    int scale = 1;
+    float target_fps = UPDATES_PER_SECOND;
+    int mode = ZT_RENDER_INLINE;
+    int runners = 1;
+    int show_maps = 0;
+    int total_events, script_length;
+    int result = EXIT_FAILURE;
+    double *frame_ms;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--software") == 0)
+            mode |= ZT_RENDER_SOFTWARE;
+        else if (strcmp(argv[i], "--maps") == 0)
+            show_maps = 1;
+        else if (i + 1 >= argc)
+            break;
+        else if (strcmp(argv[i], "--frames") == 0)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scale") == 0)
+            scale = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--script") == 0)
+            script_path = argv[++i];
+        else if (strcmp(argv[i], "--fps") == 0)
+            target_fps = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--runners") == 0)
+            runners = atoi(argv[++i]);
+    }
+    if (frames < 1)
+        frames = 1;
+    if (scale < 1)
+        scale = 1;
+
+    script = malloc(sizeof(struct ReplayEvent) * BENCH_MAX_EVENTS);
+    frame_ms = malloc(sizeof(double) * frames);
+    if (script == NULL || frame_ms == NULL) {
+        DEBUG_ERR("Out of memory");
+        free(script);
+        free(frame_ms);
+        return EXIT_FAILURE;
+    }
+
+    total_events = BENCH_LoadScript(script_path, script, BENCH_MAX_EVENTS, &script_length);
+    if (total_events < 0 || (scale > 1 && BENCH_WriteScaledSprites(scale) != 0)) {
+        free(script);
+        free(frame_ms);
+        return EXIT_FAILURE;
+    }
+    if (scale > 1)
+        sprites_path = ZT_BENCH_SCRATCH;
+
+    // No window, no GPU: dummy video + the software renderer (or --software, none at all)
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    GSU_Begin();
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
+        DEBUG_ERR(SDL_GetError());
+    } else if (TTF_Init() != 0) {
+        DEBUG_ERR(TTF_GetError());
+        SDL_Quit();
+    } else {
+        if (BENCH_Run(sprites_path, script, total_events, script_length, frame_ms, frames, target_fps,
+                      mode, runners, show_maps) == 0)
+            result = 0;
+        TTF_Quit();
+        IMG_Quit();
+        SDL_Quit();
+    }
+
+    free(frame_ms);
+    free(script);
+    return result;
+}
@@ -0,0 +1,459 @@
+/*
+ * Micro benchmarks for the pieces a frame is built from: hit-testing the layout, parsing and
+ * laying out sprites.cfg (22 lines up to 100k), the per-slot passes the update and the
+ * compositor run, the sprite store and the undo history. Nothing is rendered and SDL is never
+ * initialised, so it runs without a display.
+ *
+ * Every case is run with twice the repetitions until one run takes --min-ms, that run is the one
+ * reported: ns per op, and allocations/bytes per op. --json writes the same numbers out for
+ * diffing between releases.
+ *
+ * Run it from the repo root so sprites.cfg is found:
+ *   ZeldaTrackerMicroBench [--min-ms N] [--filter text] [--json path]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL2/SDL.h"
+#include "SDL2/SDL_ttf.h"
+#include "SDL2/SDL_image.h"
+
+#include "ZeldaTracker.h"
+#include "BenchAlloc.h"
+
+#ifndef ZT_MICRO_SCRATCH
+#define ZT_MICRO_SCRATCH "micro_sprites"
+#endif
+
+#define MICRO_MAX_RESULTS 64
+#define MICRO_POINTS 1024           // cursor positions per hit-test run
+#define MICRO_SLOTS 256             // 8 runners of a full tracker
+
+const int MICRO_CONFIG_LINES[3] = { 22, 1000, 100000 };
+
+struct MicroResult {
+    char name[64];
+    const char *unit;       // what one op is
+    Uint64 ops;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+};
+
+struct Micro {
+    double min_ms;
+    const char *filter;
+    struct MicroResult results[MICRO_MAX_RESULTS];
+    int total_results;
+};
+
+typedef void (*MicroCase)(void *ctx, Uint64 calls);
+
+// Results go here so nothing gets optimised away
+volatile Uint64 micro_sink;
+
+/********************************************//**
+ * @brief
+ * Times run until a run takes min_ms and records it
+ * @param micro struct Micro*
+ * @param name const char*
+ * @param unit const char* what an op is
+ * @param run MicroCase
+ * @param ctx void*
+ * @param ops_per_call Uint64 ops one call of run does
+ * @return void
+ ***********************************************/
+void MICRO_Run(struct Micro *micro, const char *name, const char *unit, MicroCase run, void *ctx,
+               Uint64 ops_per_call) {
+    struct MicroResult *result;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 calls = 1;
+    double ms;
+
+    if (micro->filter != NULL && strstr(name, micro->filter) == NULL)
+        return;
+    if (micro->total_results == MICRO_MAX_RESULTS)
+        return;
+
+    run(ctx, 1);
+    for (;;) {
+        Uint64 started;
+
+        bench_allocs = 0;
+        bench_alloc_bytes = 0;
+        __atomic_store_n(&bench_counting, 1, __ATOMIC_RELAXED);
+        started = SDL_GetPerformanceCounter();
+        run(ctx, calls);
+        ms = (double)(SDL_GetPerformanceCounter() - started) * 1000.0 / (double)frequency;
+        __atomic_store_n(&bench_counting, 0, __ATOMIC_RELAXED);
+
+        if (ms >= micro->min_ms || calls >= ((Uint64)1 << 40))
+            break;
+        calls *= 2;
+    }
+
+    result = &micro->results[micro->total_results++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->unit = unit;
+    result->ops = calls * ops_per_call;
+    result->ns_per_op = ms * 1e6 / (double)result->ops;
+    result->allocs_per_op = (double)bench_allocs / (double)result->ops;
+    result->bytes_per_op = (double)bench_alloc_bytes / (double)result->ops;
+
+    printf("%-36s %12.2f ns/%-8s %10.3f allocs %12.1f bytes\n", result->name, result->ns_per_op,
+           result->unit, result->allocs_per_op, result->bytes_per_op);
+}
+
+int MICRO_WriteJson(const struct Micro *micro, const char *path) {
+    FILE *out = fopen(path, "w");
+
+    if (out == NULL) {
+        DEBUG_ERR("Unable to write the benchmark results");
+        return -1;
+    }
+
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (int i = 0; i < micro->total_results; i++) {
+        const struct MicroResult *result = &micro->results[i];
+
+        fprintf(out, "    { \"name\": \"%s\", \"unit\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.3f, "
+                     "\"allocs_per_op\": %.6f, \"bytes_per_op\": %.3f }%s\n",
+                result->name, result->unit, (unsigned long long)result->ops, result->ns_per_op,
+                result->allocs_per_op, result->bytes_per_op, (i + 1 < micro->total_results) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    return (fclose(out) == 0) ? 0 : -1;
+}
+
+//////////////////////////////
+//
+// Hit-testing: the old scan over every rect against the grid the tracker queries
+//
+//////////////////////////////
+struct HitCase {
+    const struct SpriteStore *store;
+    struct HitGrid grid;
+    int x[MICRO_POINTS];
+    int y[MICRO_POINTS];
+};
+
+void MICRO_PointCollides(void *ctx, Uint64 calls) {
+    const struct HitCase *hit = ctx;
+    const struct SpriteStore *store = hit->store;
+    Uint64 found = 0;
+
+    for (Uint64 c = 0; c < calls; c++)
+        for (int p = 0; p < MICRO_POINTS; p++)
+            for (int i = 0; i < store->total; i++)
+                if ((store->state[i] & SPRITE_STATE_DISABLED) == 0
+                    && GM_PointCollides(hit->x[p], hit->y[p], store->x[i], store->y[i], SPRITE_WIDTH, SPRITE_HEIGHT)) {
+                    found += (Uint64)i;
+                    break;
+                }
+
+    micro_sink = found;
+}
+
+void MICRO_HitGridQuery(void *ctx, Uint64 calls) {
+    const struct HitCase *hit = ctx;
+    Uint64 found = 0;
+
+    for (Uint64 c = 0; c < calls; c++)
+        for (int p = 0; p < MICRO_POINTS; p++)
+            found += (Uint64)GM_HitGridQuery(&hit->grid, hit->x[p], hit->y[p]);
+
+    micro_sink = found;
+}
+
+//////////////////////////////
+//
+// sprites.cfg: parsing, loading through the cache, and laying it out
+//
+//////////////////////////////
+struct ConfigCase {
+    char path[256];
+    int lines;
+    struct SpriteConfig config;     // parsed once, for the layout cases
+};
+
+/********************************************//**
+ * @brief
+ * Writes sprites.cfg's lines over and over until there are lines of them
+ * @param path const char*
+ * @param lines int
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int MICRO_WriteConfig(const char *path, int lines) {
+    FILE *in = fopen("sprites.cfg", "r");
+    FILE *out = fopen(path, "w");
+    char line[128];
+    int written = 0;
+
+    if (in == NULL || out == NULL) {
+        DEBUG_ERR("Unable to write the generated sprites configuration");
+        if (in != NULL)
+            fclose(in);
+        if (out != NULL)
+            fclose(out);
+        return -1;
+    }
+
+    while (written < lines) {
+        if (fgets(line, sizeof(line), in) == NULL) {
+            rewind(in);
+            continue;
+        }
+        fputs(line, out);
+        if (strchr(line, '\n') == NULL)
+            fputc('\n', out);
+        written++;
+    }
+
+    fclose(in);
+    fclose(out);
+    return 0;
+}
+
+/********************************************//**
+ * @brief
+ * Removes a config MICRO_WriteConfig wrote and the cache GCF_LoadConfig left next to it
+ * @param path const char*
+ * @return void
+ ***********************************************/
+void MICRO_RemoveConfig(const char *path) {
+    char cache_path[300];
+
+    snprintf(cache_path, sizeof(cache_path), "%s%s", path, GCF_CACHE_SUFFIX);
+    remove(path);
+    remove(cache_path);
+}
+
+void MICRO_ParseConfig(void *ctx, Uint64 calls) {
+    const struct ConfigCase *cfg = ctx;
+
+    for (Uint64 c = 0; c < calls; c++) {
+        struct SpriteConfig config;
+
+        memset(&config, 0, sizeof(config));
+        if (GCF_ParseFile(cfg->path, GCF_AppendEntry, &config, &config.error, NULL) == 0)
+            micro_sink = (Uint64)config.total_entries;
+        free(config.owned);
+    }
+}
+
+void MICRO_LoadConfig(void *ctx, Uint64 calls) {
+    const struct ConfigCase *cfg = ctx;
+
+    for (Uint64 c = 0; c < calls; c++) {
+        struct SpriteConfig config;
+
+        if (GCF_LoadConfig(&config, cfg->path) == 0)
+            micro_sink = (Uint64)config.total_entries;
+        GCF_UnloadConfig(&config);
+    }
+}
+
+void MICRO_InitGameSprites(void *ctx, Uint64 calls) {
+    const struct ConfigCase *cfg = ctx;
+
+    for (Uint64 c = 0; c < calls; c++) {
+        struct SpriteStore store;
+
+        if (GE_InitStore(&store, ZT_TOTAL_DUNGEONS) == 0) {
+            for (int i = 0; i < ZT_TOTAL_DUNGEONS; i++)
+                GE_AddSprite(&store, 30, i * 40, SPRITE_STATE_OFF);
+            ZT_InitGameSprites(&store, cfg->config.entries, cfg->config.total_entries);
+            micro_sink = (Uint64)store.total;
+        }
+        GE_DestroyStore(&store);
+    }
+}
+
+//////////////////////////////
+//
+// Per-slot passes over a race's worth of slots
+//
+//////////////////////////////
+struct SlotCase {
+    struct SpriteStore store;
+    struct Compositor compositor;   // only drawn is used
+    int drawn[MICRO_SLOTS];
+    int changed[MICRO_SLOTS];
+    struct History history;
+};
+
+void MICRO_AddSprites(void *ctx, Uint64 calls) {
+    for (Uint64 c = 0; c < calls; c++) {
+        struct SpriteStore store;
+
+        GE_InitStore(&store, 0);
+        for (int i = 0; i < MICRO_SLOTS; i++)
+            GE_AddSprite(&store, i, i, SPRITE_STATE_OFF);
+        micro_sink = (Uint64)store.total;
+        GE_DestroyStore(&store);
+    }
+}
+
+// Every slot's hover bit cleared and the one under the cursor set, what each mouse event did
+// before the hit grid
+void MICRO_HoverPass(void *ctx, Uint64 calls) {
+    struct SlotCase *slots = ctx;
+    Uint8 *state = slots->store.state;
+
+    for (Uint64 c = 0; c < calls; c++) {
+        int hovered = (int)(c % MICRO_SLOTS);
+
+        for (int i = 0; i < MICRO_SLOTS; i++)
+            state[i] = (Uint8)((state[i] & ~SPRITE_STATE_HOVER) | ((i == hovered) ? SPRITE_STATE_HOVER : 0));
+    }
+    micro_sink = state[0];
+}
+
+void MICRO_TogglePass(void *ctx, Uint64 calls) {
+    struct SlotCase *slots = ctx;
+    Uint8 *state = slots->store.state;
+
+    for (Uint64 c = 0; c < calls; c++)
+        for (int i = 0; i < MICRO_SLOTS; i++)
+            state[i] ^= SPRITE_STATE_ON;
+    micro_sink = state[0];
+}
+
+// A toggle on every other slot, then what the compositor finds changed
+void MICRO_CollectChanged(void *ctx, Uint64 calls) {
+    struct SlotCase *slots = ctx;
+    Uint8 *state = slots->store.state;
+    Uint64 total = 0;
+
+    for (Uint64 c = 0; c < calls; c++) {
+        for (int i = (int)(c & 1); i < MICRO_SLOTS; i += 2)
+            state[i] ^= SPRITE_STATE_ON;
+        total += (Uint64)GC_CollectChanged(&slots->compositor, state, slots->store.tag, MICRO_SLOTS,
+                                           slots->changed);
+    }
+    micro_sink = total;
+}
+
+// One click recorded, then undone and redone
+void MICRO_History(void *ctx, Uint64 calls) {
+    struct SlotCase *slots = ctx;
+
+    for (Uint64 c = 0; c < calls; c++) {
+        int slot = (int)(c % MICRO_SLOTS);
+
+        GH_Set(&slots->history, slot, !GH_On(&slots->history, slot), (int)(c % 10));
+        GH_Commit(&slots->history);
+        GH_Undo(&slots->history, slots->changed);
+        micro_sink = (Uint64)GH_Redo(&slots->history, slots->changed);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    struct Micro micro;
+    struct SpriteConfig layout_config;
+    struct SpriteStore layout;
+    struct HitCase *hit = malloc(sizeof(struct HitCase));
+    struct SlotCase *slots = malloc(sizeof(struct SlotCase));
+    struct ConfigCase configs[3];
+    const char *json_path = NULL;
+    char name[64];
+    Uint32 seed = 12345;
+
+    memset(&micro, 0, sizeof(micro));
+    micro.min_ms = 200;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--min-ms") == 0)
+            micro.min_ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0)
+            micro.filter = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0)
+            json_path = argv[++i];
+    }
+    if (hit == NULL || slots == NULL)
+        return EXIT_FAILURE;
+
+    // The real layout: triforces down the left, sprites.cfg's items in rows of four
+    if (GCF_LoadConfig(&layout_config, "sprites.cfg") != 0 || GE_InitStore(&layout, 0) != 0)
+        return EXIT_FAILURE;
+    for (int i = 0; i < ZT_TOTAL_DUNGEONS; i++)
+        GE_AddSprite(&layout, 30, i * 40, SPRITE_STATE_OFF);
+    if (ZT_InitGameSprites(&layout, layout_config.entries, layout_config.total_entries) != 0)
+        return EXIT_FAILURE;
+
+    hit->store = &layout;
+    if (GM_InitHitGrid(&hit->grid, SPRITE_WIDTH, SPRITE_HEIGHT, layout.total) != 0)
+        return EXIT_FAILURE;
+    for (int i = 0; i < layout.total; i++)
+        if ((layout.state[i] & SPRITE_STATE_DISABLED) == 0)
+            GM_HitGridAdd(&hit->grid, i, layout.x[i], layout.y[i], SPRITE_WIDTH, SPRITE_HEIGHT);
+    if (GM_HitGridBuild(&hit->grid) != 0)
+        return EXIT_FAILURE;
+    for (int p = 0; p < MICRO_POINTS; p++) {
+        seed = seed * 1664525u + 1013904223u;
+        hit->x[p] = (int)((seed >> 8) % WINDOW_WIDTH);
+        seed = seed * 1664525u + 1013904223u;
+        hit->y[p] = (int)((seed >> 8) % (Uint32)ZT_HeightForSprites(layout_config.total_entries));
+    }
+
+    MICRO_Run(&micro, "hit/point_collides_scan", "point", MICRO_PointCollides, hit, MICRO_POINTS);
+    MICRO_Run(&micro, "hit/grid_query", "point", MICRO_HitGridQuery, hit, MICRO_POINTS);
+
+    for (int i = 0; i < 3; i++) {
+        struct ConfigCase *cfg = &configs[i];
+
+        cfg->lines = MICRO_CONFIG_LINES[i];
+        snprintf(cfg->path, sizeof(cfg->path), "%s_%d.cfg", ZT_MICRO_SCRATCH, cfg->lines);
+        if (MICRO_WriteConfig(cfg->path, cfg->lines) != 0) {
+            MICRO_RemoveConfig(cfg->path);
+            return EXIT_FAILURE;
+        }
+        memset(&cfg->config, 0, sizeof(cfg->config));
+        if (GCF_ParseFile(cfg->path, GCF_AppendEntry, &cfg->config, &cfg->config.error, NULL) != 0) {
+            MICRO_RemoveConfig(cfg->path);
+            return EXIT_FAILURE;
+        }
+        cfg->config.entries = cfg->config.owned;
+
+        snprintf(name, sizeof(name), "config/parse/%d", cfg->lines);
+        MICRO_Run(&micro, name, "line", MICRO_ParseConfig, cfg, (Uint64)cfg->lines);
+        snprintf(name, sizeof(name), "config/load_cached/%d", cfg->lines);
+        MICRO_Run(&micro, name, "line", MICRO_LoadConfig, cfg, (Uint64)cfg->lines);
+        snprintf(name, sizeof(name), "layout/init_game_sprites/%d", cfg->lines);
+        MICRO_Run(&micro, name, "sprite", MICRO_InitGameSprites, cfg, (Uint64)cfg->config.total_entries);
+
+        // The parsed entries are ours, nothing needs the files past here
+        MICRO_RemoveConfig(cfg->path);
+    }
+
+    memset(slots, 0, sizeof(*slots));
+    if (GE_InitStore(&slots->store, MICRO_SLOTS) != 0 || GH_InitHistory(&slots->history) != 0)
+        return EXIT_FAILURE;
+    for (int i = 0; i < MICRO_SLOTS; i++)
+        GE_AddSprite(&slots->store, 0, 0, SPRITE_STATE_OFF);
+    slots->compositor.drawn = slots->drawn;
+    if (GH_Reset(&slots->history, slots->store.state, slots->store.tag, MICRO_SLOTS) != 0)
+        return EXIT_FAILURE;
+
+    MICRO_Run(&micro, "store/add_sprite", "sprite", MICRO_AddSprites, NULL, MICRO_SLOTS);
+    MICRO_Run(&micro, "slots/hover_pass", "slot", MICRO_HoverPass, slots, MICRO_SLOTS);
+    MICRO_Run(&micro, "slots/toggle_pass", "slot", MICRO_TogglePass, slots, MICRO_SLOTS);
+    MICRO_Run(&micro, "slots/collect_changed", "slot", MICRO_CollectChanged, slots, MICRO_SLOTS);
+    MICRO_Run(&micro, "history/commit_undo_redo", "click", MICRO_History, slots, 1);
+
+    if (json_path != NULL && MICRO_WriteJson(&micro, json_path) != 0)
+        return EXIT_FAILURE;
+
+    GH_DestroyHistory(&slots->history);
+    GE_DestroyStore(&slots->store);
+    for (int i = 0; i < 3; i++)
+        GCF_UnloadConfig(&configs[i].config);
+    GM_DestroyHitGrid(&hit->grid);
+    GE_DestroyStore(&layout);
+    GCF_UnloadConfig(&layout_config);
+    free(slots);
+    free(hit);
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+ * Drives the journal's writer by hand (no writer thread) through the cases the thread can only
+ * hit by bad timing or a misbehaving disk, and checks what ends up on disk. Exits non-zero if
+ * any check failed.
+ *
+ *   ZeldaTrackerJournalTest
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <direct.h>
+#define TEST_MakeDir(path) _mkdir(path)
+#define TEST_RemoveDir(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define TEST_MakeDir(path) mkdir(path, 0700)
+#define TEST_RemoveDir(path) rmdir(path)
+#endif
+
+#include "SDL2/SDL.h"
+
+#include "Debug.h"
+#include "GameJournal.h"
+
+#ifndef ZT_TEST_SCRATCH
+#define ZT_TEST_SCRATCH "journal_test"
+#endif
+
+#define TEST_SLOTS 4
+
+int test_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+/********************************************//**
+ * @brief
+ * A journal with its first snapshot written, of all slots off and untagged
+ * @param journal struct Journal*
+ * @param state Uint8* TEST_SLOTS, cleared
+ * @param tag Sint8* TEST_SLOTS, cleared
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int TEST_StartJournal(struct Journal *journal, Uint8 *state, Sint8 *tag) {
+    memset(state, 0, sizeof(Uint8) * TEST_SLOTS);
+    memset(tag, -1, sizeof(Sint8) * TEST_SLOTS);
+    remove(ZT_TEST_SCRATCH);
+    remove(ZT_TEST_SCRATCH ".snap");
+
+    if (GJ_SetupJournal(journal, ZT_TEST_SCRATCH, TEST_SLOTS, 0) != 0
+        || GJ_RequestSnapshot(journal, state, tag) != 0)
+        return -1;
+    GJ_Drain(journal);
+
+    return (journal->file != NULL) ? 0 : -1;
+}
+
+void TEST_EndJournal(struct Journal *journal) {
+    GJ_CloseJournal(journal, NULL, NULL);
+    remove(ZT_TEST_SCRATCH);
+    remove(ZT_TEST_SCRATCH ".snap");
+}
+
+// The state side's copy and the journal both see the change
+void TEST_Set(struct Journal *journal, Uint8 *state, Sint8 *tag, int slot, Uint8 on, Sint8 dungeon) {
+    state[slot] = on;
+    tag[slot] = dungeon;
+    GJ_Append(journal, slot, on, dungeon);
+}
+
+long TEST_JournalRecords(struct Journal *journal) {
+    long size;
+
+    if (journal->file == NULL || fflush(journal->file) != 0 || fseek(journal->file, 0, SEEK_END) != 0)
+        return -1;
+    size = ftell(journal->file);
+    return (size - (long)sizeof(struct JournalHeader)) / (long)sizeof(struct JournalRecord);
+}
+
+// What a restart would come back to matches state/tag
+int TEST_Restores(struct Journal *journal, const Uint8 *state, const Sint8 *tag) {
+    Uint8 restored_state[TEST_SLOTS];
+    Sint8 restored_tag[TEST_SLOTS];
+    Uint32 epoch;
+
+    if (journal->file != NULL)
+        fflush(journal->file);
+    memset(restored_state, 0xAA, sizeof(restored_state));
+    memset(restored_tag, 0x55, sizeof(restored_tag));
+    if (GJ_Restore(ZT_TEST_SCRATCH, restored_state, restored_tag, TEST_SLOTS, &epoch) < 0)
+        return 0;
+
+    return memcmp(restored_state, state, sizeof(restored_state)) == 0
+           && memcmp(restored_tag, tag, sizeof(restored_tag)) == 0;
+}
+
+/********************************************//**
+ * @brief
+ * A snapshot taken at head H only reaches the writer after it has drained past H, and the state
+ * side has since filled the whole queue. The writer mustn't move tail back to H: the records in
+ * [H, tail) are gone from the queue, reading them again would write overwritten ones twice.
+ * @return void
+ ***********************************************/
+void TEST_SnapshotBehindTail(void) {
+    struct Journal journal;
+    Uint8 state[TEST_SLOTS];
+    Sint8 tag[TEST_SLOTS];
+    int head;
+
+    if (TEST_StartJournal(&journal, state, tag) != 0) {
+        TEST_CHECK(!"journal started");
+        TEST_EndJournal(&journal);
+        return;
+    }
+    TEST_CHECK(TEST_JournalRecords(&journal) == 0);
+
+    // Two records, the snapshot is taken after the first but the writer gets both first
+    TEST_Set(&journal, state, tag, 0, 1, -1);
+    memcpy(journal.snapshot_state, state, sizeof(state));
+    memcpy(journal.snapshot_tag, tag, sizeof(tag));
+    TEST_Set(&journal, state, tag, 1, 1, -1);
+    GJ_Drain(&journal);
+    TEST_CHECK(SDL_AtomicGet(&journal.tail) == 2);
+    SDL_AtomicSet(&journal.snapshot_at, 1 + 1);
+
+    // The state side fills the queue right up, record 1's slot is reused
+    for (int i = 0; i < GJ_QUEUE_SIZE; i++)
+        TEST_Set(&journal, state, tag, 2 + (i % 2), (Uint8)(i & 1), (Sint8)(i % 8));
+    head = SDL_AtomicGet(&journal.head);
+    TEST_CHECK(head == 2 + GJ_QUEUE_SIZE);
+    TEST_CHECK(journal.behind == 0);
+
+    GJ_Drain(&journal);
+    TEST_CHECK(SDL_AtomicGet(&journal.snapshot_at) == 0);
+    TEST_CHECK(SDL_AtomicGet(&journal.tail) == head);
+    TEST_CHECK(TEST_JournalRecords(&journal) == GJ_QUEUE_SIZE);
+
+    // And nothing left over for the next drain to write again
+    GJ_Drain(&journal);
+    TEST_CHECK(TEST_JournalRecords(&journal) == GJ_QUEUE_SIZE);
+
+    TEST_EndJournal(&journal);
+}
+
+/********************************************//**
+ * @brief
+ * A snapshot that can't be written (its temp file's name is taken by a directory) mustn't cost
+ * the records before it: the old snapshot and journal stay in charge and keep being appended
+ * to, and the state side asks again
+ * @return void
+ ***********************************************/
+void TEST_SnapshotFails(void) {
+    struct Journal journal;
+    Uint8 state[TEST_SLOTS];
+    Sint8 tag[TEST_SLOTS];
+    Uint32 epoch;
+
+    if (TEST_StartJournal(&journal, state, tag) != 0) {
+        TEST_CHECK(!"journal started");
+        TEST_EndJournal(&journal);
+        return;
+    }
+    epoch = journal.epoch;
+
+    TEST_Set(&journal, state, tag, 0, 1, 3);
+    TEST_Set(&journal, state, tag, 1, 1, -1);
+    GJ_Drain(&journal);
+    TEST_CHECK(TEST_JournalRecords(&journal) == 2);
+
+    TEST_CHECK(TEST_MakeDir(ZT_TEST_SCRATCH ".snap.tmp") == 0);
+    TEST_Set(&journal, state, tag, 2, 1, 5);
+    TEST_CHECK(GJ_RequestSnapshot(&journal, state, tag) == 0);
+    TEST_Set(&journal, state, tag, 0, 0, -1);
+    GJ_Drain(&journal);
+
+    TEST_CHECK(journal.epoch == epoch);
+    TEST_CHECK(SDL_AtomicGet(&journal.snapshot_failed) == 1);
+    TEST_CHECK(SDL_AtomicGet(&journal.tail) == SDL_AtomicGet(&journal.head));
+    TEST_CHECK(TEST_JournalRecords(&journal) == 4);
+    TEST_CHECK(TEST_Restores(&journal, state, tag));
+
+    // Not straight away, the disk gets a rest first
+    GJ_Maintain(&journal, state, tag);
+    TEST_CHECK(SDL_AtomicGet(&journal.snapshot_at) == 0);
+
+    // Once the disk is back the next one goes through and the journal starts over
+    TEST_CHECK(TEST_RemoveDir(ZT_TEST_SCRATCH ".snap.tmp") == 0);
+    journal.requested_at = SDL_GetTicks() - GJ_RETRY_MS;
+    GJ_Maintain(&journal, state, tag);
+    TEST_CHECK(SDL_AtomicGet(&journal.snapshot_at) != 0);
+    GJ_Drain(&journal);
+    TEST_CHECK(journal.epoch == epoch + 1);
+    TEST_CHECK(SDL_AtomicGet(&journal.snapshot_failed) == 0);
+    TEST_CHECK(TEST_JournalRecords(&journal) == 0);
+    TEST_CHECK(TEST_Restores(&journal, state, tag));
+
+    TEST_EndJournal(&journal);
+}
+
+/********************************************//**
+ * @brief
+ * The snapshot goes out but its journal can't be started (its name is taken by a directory).
+ * Records wait in the queue rather than being dropped, and go out once the journal starts.
+ * @return void
+ ***********************************************/
+void TEST_JournalRestartFails(void) {
+    struct Journal journal;
+    Uint8 state[TEST_SLOTS];
+    Sint8 tag[TEST_SLOTS];
+
+    if (TEST_StartJournal(&journal, state, tag) != 0) {
+        TEST_CHECK(!"journal started");
+        TEST_EndJournal(&journal);
+        return;
+    }
+
+    TEST_Set(&journal, state, tag, 3, 1, 2);
+    GJ_Drain(&journal);
+
+    fclose(journal.file);
+    journal.file = NULL;
+    remove(ZT_TEST_SCRATCH);
+    TEST_CHECK(TEST_MakeDir(ZT_TEST_SCRATCH) == 0);
+
+    TEST_CHECK(GJ_RequestSnapshot(&journal, state, tag) == 0);
+    TEST_Set(&journal, state, tag, 1, 1, 4);
+    TEST_Set(&journal, state, tag, 2, 1, -1);
+    GJ_Drain(&journal);
+    TEST_CHECK(journal.file == NULL);
+    TEST_CHECK(SDL_AtomicGet(&journal.head) - SDL_AtomicGet(&journal.tail) == 2);
+
+    // Still held, not dropped
+    GJ_Drain(&journal);
+    TEST_CHECK(SDL_AtomicGet(&journal.head) - SDL_AtomicGet(&journal.tail) == 2);
+
+    TEST_CHECK(TEST_RemoveDir(ZT_TEST_SCRATCH) == 0);
+    GJ_Drain(&journal);
+    TEST_CHECK(journal.file != NULL);
+    TEST_CHECK(SDL_AtomicGet(&journal.tail) == SDL_AtomicGet(&journal.head));
+    TEST_CHECK(TEST_JournalRecords(&journal) == 2);
+    TEST_CHECK(TEST_Restores(&journal, state, tag));
+
+    TEST_EndJournal(&journal);
+}
+
+int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+
+    TEST_SnapshotBehindTail();
+    TEST_SnapshotFails();
+    TEST_JournalRestartFails();
+
+    if (test_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", test_failures);
+        return EXIT_FAILURE;
+    }
+    printf("journal: ok\n");
+    return 0;
+}
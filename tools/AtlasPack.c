@@ -0,0 +1,334 @@
+/*
+ * Build step: packs the rects the tracker actually draws out of sprites-link.png into a tight
+ * atlas and writes it as a header, pre-decoded RGBA pixels plus a table of named rects.
+ *
+ *   AtlasPack <sheet.png> <atlas.cfg> <sprites.cfg> <out.h>
+ *   AtlasPack --embed <file> <symbol> <out.h>
+ *
+ * atlas.cfg names the irregular rects (link's frames, the cursor), every sprites.cfg entry adds
+ * its 16x16 grid cell. The second form dumps any file as a byte array (the font).
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "SDL2/SDL.h"
+#include "SDL2/SDL_image.h"
+
+#include "Debug.h"
+#include "GameConfig.h"
+
+#define PACK_MAX_RECTS 4096
+#define PACK_NAME_LENGTH 48
+
+const int PACK_ATLAS_WIDTH = 128;
+const int PACK_PADDING = 1;     // transparent gutter so scaled/filtered copies never bleed
+const int PACK_GRID_SIZE = 15;  // SPRITE_SHEET_GRID_SIZE
+const int PACK_CELL_SIZE = 16;
+
+struct PackRect {
+    char name[PACK_NAME_LENGTH];
+    int sheet_x;
+    int sheet_y;
+    int w;
+    int h;
+    int x;          // in the atlas
+    int y;
+    int alias;      // index of an identical sheet rect packed earlier, -1 if this one owns pixels
+};
+
+struct PackRect pack_rects[PACK_MAX_RECTS];
+int pack_total = 0;
+
+int PACK_Add(const char *name, int sheet_x, int sheet_y, int w, int h) {
+    struct PackRect *rect;
+
+    if (pack_total == PACK_MAX_RECTS) {
+        fprintf(stderr, "AtlasPack: too many rects\n");
+        return -1;
+    }
+
+    // Every shelf is the atlas width, a rect that can't fit one with its gutter can't be packed
+    if (w <= 0 || h <= 0 || w + PACK_PADDING * 2 > PACK_ATLAS_WIDTH) {
+        fprintf(stderr, "AtlasPack: %s (%dx%d) doesn't fit a %d px wide atlas\n",
+                name, w, h, PACK_ATLAS_WIDTH);
+        return -1;
+    }
+
+    rect = &pack_rects[pack_total];
+    snprintf(rect->name, sizeof(rect->name), "%s", name);
+    rect->sheet_x = sheet_x;
+    rect->sheet_y = sheet_y;
+    rect->w = w;
+    rect->h = h;
+    rect->alias = -1;
+
+    for (int i = 0; i < pack_total; i++)
+        if (pack_rects[i].alias == -1 && pack_rects[i].sheet_x == sheet_x && pack_rects[i].sheet_y == sheet_y
+            && pack_rects[i].w == w && pack_rects[i].h == h) {
+            rect->alias = i;
+            break;
+        }
+
+    pack_total++;
+    return 0;
+}
+
+int PACK_LoadManifest(const char *path) {
+    FILE *manifest = fopen(path, "r");
+    char line[256];
+    char name[PACK_NAME_LENGTH];
+    int x, y, w, h, line_number = 0;
+
+    if (!manifest) {
+        fprintf(stderr, "AtlasPack: unable to open %s\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), manifest)) {
+        line_number++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+            continue;
+
+        if (sscanf(line, "%47s %d %d %d %d", name, &x, &y, &w, &h) != 5) {
+            fprintf(stderr, "%s:%d: expected <name> <x> <y> <w> <h>\n", path, line_number);
+            fclose(manifest);
+            return -1;
+        }
+
+        if (PACK_Add(name, x, y, w, h) != 0) {
+            fclose(manifest);
+            return -1;
+        }
+    }
+
+    fclose(manifest);
+    return 0;
+}
+
+int PACK_AddSpriteEntry(void *ctx, const struct SpriteEntry *entry, int line) {
+    char name[PACK_NAME_LENGTH];
+
+    snprintf(name, sizeof(name), "item_%s", entry->name[0] ? entry->name : "unnamed");
+    return PACK_Add(name, entry->col * PACK_GRID_SIZE, entry->row * PACK_GRID_SIZE,
+                    PACK_CELL_SIZE, PACK_CELL_SIZE);
+}
+
+int PACK_CompareHeight(const void *a, const void *b) {
+    const struct PackRect *ra = &pack_rects[*(const int *)a];
+    const struct PackRect *rb = &pack_rects[*(const int *)b];
+
+    if (ra->h != rb->h)
+        return rb->h - ra->h;
+    return *(const int *)a - *(const int *)b;
+}
+
+/********************************************//**
+ * @brief
+ * Shelf packs every rect that owns pixels, tallest first
+ * @return int
+ * atlas height
+ ***********************************************/
+int PACK_Shelves(void) {
+    int order[PACK_MAX_RECTS];
+    int total = 0;
+    int x = 0, y = 0, shelf_h = 0;
+
+    for (int i = 0; i < pack_total; i++)
+        if (pack_rects[i].alias == -1)
+            order[total++] = i;
+
+    qsort(order, total, sizeof(int), PACK_CompareHeight);
+
+    for (int i = 0; i < total; i++) {
+        struct PackRect *rect = &pack_rects[order[i]];
+        int w = rect->w + PACK_PADDING * 2;
+        int h = rect->h + PACK_PADDING * 2;
+
+        if (x + w > PACK_ATLAS_WIDTH) {
+            y += shelf_h;
+            x = 0;
+            shelf_h = 0;
+        }
+
+        rect->x = x + PACK_PADDING;
+        rect->y = y + PACK_PADDING;
+        x += w;
+        if (h > shelf_h)
+            shelf_h = h;
+    }
+
+    for (int i = 0; i < pack_total; i++)
+        if (pack_rects[i].alias != -1) {
+            pack_rects[i].x = pack_rects[pack_rects[i].alias].x;
+            pack_rects[i].y = pack_rects[pack_rects[i].alias].y;
+        }
+
+    return y + shelf_h;
+}
+
+/********************************************//**
+ * @brief
+ * Writes name as the inside of a C string literal, names are free text from sprites.cfg
+ * @param out FILE*
+ * @param name const char*
+ * @return void
+ ***********************************************/
+void PACK_WriteString(FILE *out, const char *name) {
+    for (const char *c = name; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\' || *c == '?')     // '?' so "??x" can't become a trigraph
+            fprintf(out, "\\%c", *c);
+        else if (isprint((unsigned char)*c))
+            fputc(*c, out);
+        else
+            fprintf(out, "\\%03o", (unsigned char)*c);
+    }
+}
+
+void PACK_WriteBytes(FILE *out, const Uint8 *bytes, size_t length) {
+    for (size_t i = 0; i < length; i++)
+        fprintf(out, "%s0x%02x,%s", (i % 16 == 0) ? "    " : "", bytes[i],
+                (i % 16 == 15 || i == length - 1) ? "\n" : "");
+}
+
+int PACK_Atlas(const char *sheet_path, const char *manifest_path, const char *sprites_path,
+               const char *out_path) {
+    struct ConfigError error;
+    SDL_Surface *loaded, *sheet;
+    Uint8 *pixels;
+    FILE *out;
+    int atlas_h;
+    char symbol[PACK_NAME_LENGTH];
+
+    if (PACK_LoadManifest(manifest_path) != 0)
+        return -1;
+
+    if (GCF_ParseFile(sprites_path, PACK_AddSpriteEntry, NULL, &error, NULL) != 0) {
+        fprintf(stderr, "%s:%d:%d: %s\n", sprites_path, error.line, error.column, error.message);
+        return -1;
+    }
+
+    loaded = IMG_Load(sheet_path);
+    if (loaded == NULL) {
+        fprintf(stderr, "AtlasPack: %s\n", IMG_GetError());
+        return -1;
+    }
+    sheet = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (sheet == NULL) {
+        fprintf(stderr, "AtlasPack: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    atlas_h = PACK_Shelves();
+    pixels = calloc((size_t)PACK_ATLAS_WIDTH * atlas_h, 4);
+    if (pixels == NULL)
+        return -1;
+
+    for (int i = 0; i < pack_total; i++) {
+        struct PackRect *rect = &pack_rects[i];
+
+        if (rect->sheet_x < 0 || rect->sheet_y < 0
+            || rect->sheet_x + rect->w > sheet->w || rect->sheet_y + rect->h > sheet->h) {
+            fprintf(stderr, "AtlasPack: %s (%d,%d %dx%d) is outside the sheet\n",
+                    rect->name, rect->sheet_x, rect->sheet_y, rect->w, rect->h);
+            return -1;
+        }
+        if (rect->alias != -1)
+            continue;
+
+        for (int row = 0; row < rect->h; row++)
+            memcpy(&pixels[((rect->y + row) * PACK_ATLAS_WIDTH + rect->x) * 4],
+                   (Uint8 *)sheet->pixels + (rect->sheet_y + row) * sheet->pitch + rect->sheet_x * 4,
+                   (size_t)rect->w * 4);
+    }
+
+    out = fopen(out_path, "w");
+    if (!out) {
+        fprintf(stderr, "AtlasPack: unable to write %s\n", out_path);
+        return -1;
+    }
+
+    fprintf(out, "// Generated by tools/AtlasPack from %s, %s and %s. Do not edit.\n",
+            sheet_path, manifest_path, sprites_path);
+    fprintf(out, "#ifndef ZELDATRACKER_SPRITEATLAS_H\n#define ZELDATRACKER_SPRITEATLAS_H\n\n");
+    fprintf(out, "#define GA_ATLAS_WIDTH %d\n#define GA_ATLAS_HEIGHT %d\n#define GA_ATLAS_TOTAL_RECTS %d\n\n",
+            PACK_ATLAS_WIDTH, atlas_h, pack_total);
+
+    for (int i = 0; i < pack_total; i++) {
+        if (strncmp(pack_rects[i].name, "item_", 5) == 0)
+            continue;
+
+        for (int c = 0; c < PACK_NAME_LENGTH; c++)
+            symbol[c] = (char)toupper((unsigned char)pack_rects[i].name[c]);
+        fprintf(out, "#define GA_%s %d\n", symbol, i);
+    }
+
+    fprintf(out, "\n// name, sheet x/y, w/h, atlas x/y\n");
+    fprintf(out, "const struct AtlasRect GA_ATLAS_RECTS[GA_ATLAS_TOTAL_RECTS] = {\n");
+    for (int i = 0; i < pack_total; i++) {
+        fprintf(out, "    { \"");
+        PACK_WriteString(out, pack_rects[i].name);
+        fprintf(out, "\", %d, %d, %d, %d, %d, %d },\n",
+                pack_rects[i].sheet_x, pack_rects[i].sheet_y, pack_rects[i].w, pack_rects[i].h,
+                pack_rects[i].x, pack_rects[i].y);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "// RGBA, one byte per channel\n");
+    fprintf(out, "const Uint8 GA_ATLAS_PIXELS[GA_ATLAS_WIDTH * GA_ATLAS_HEIGHT * 4] = {\n");
+    PACK_WriteBytes(out, pixels, (size_t)PACK_ATLAS_WIDTH * atlas_h * 4);
+    fprintf(out, "};\n\n#endif //ZELDATRACKER_SPRITEATLAS_H\n");
+
+    fclose(out);
+    free(pixels);
+    SDL_FreeSurface(sheet);
+    return 0;
+}
+
+int PACK_Embed(const char *path, const char *symbol, const char *out_path) {
+    size_t length = 0;
+    Uint8 *bytes = SDL_LoadFile(path, &length);
+    FILE *out;
+
+    if (bytes == NULL) {
+        fprintf(stderr, "AtlasPack: unable to read %s\n", path);
+        return -1;
+    }
+
+    out = fopen(out_path, "w");
+    if (!out) {
+        SDL_free(bytes);
+        return -1;
+    }
+
+    fprintf(out, "// Generated by tools/AtlasPack from %s. Do not edit.\n", path);
+    fprintf(out, "const int %s_SIZE = %d;\n", symbol, (int)length);
+    fprintf(out, "const Uint8 %s[] = {\n", symbol);
+    PACK_WriteBytes(out, bytes, length);
+    fprintf(out, "};\n");
+
+    fclose(out);
+    SDL_free(bytes);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int result;
+
+    if (argc == 5 && strcmp(argv[1], "--embed") == 0)
+        return PACK_Embed(argv[2], argv[3], argv[4]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (argc != 5) {
+        fprintf(stderr, "usage: AtlasPack <sheet.png> <atlas.cfg> <sprites.cfg> <out.h>\n"
+                        "       AtlasPack --embed <file> <symbol> <out.h>\n");
+        return EXIT_FAILURE;
+    }
+
+    IMG_Init(IMG_INIT_PNG);
+    result = PACK_Atlas(argv[1], argv[2], argv[3], argv[4]);
+    IMG_Quit();
+
+    return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+/*
+ * Stands in for an emulator script feeding --ram (see GameRam.h): keeps a 2 KB NES RAM dump
+ * at path, written in place like the real thing, and pokes bytes into it.
+ *
+ *   RamFeed <path> [script]
+ *
+ * A script has one poke per line, "<ms> <address> <value>", ms counted from the start (see
+ * tools/ram-demo.txt). Without one, "<address> <value>" lines are read from stdin and poked
+ * right away. Numbers are decimal or 0x hex.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define FEED_RAM_SIZE 0x800
+
+
+void FEED_Sleep(long ms) {
+#ifdef _WIN32
+    Sleep((DWORD)ms);
+#else
+    struct timespec wait = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&wait, NULL);
+#endif
+}
+
+/********************************************//**
+ * @brief
+ * Writes one byte of the dump and makes sure it's out of our buffers
+ * @return int
+ * 0 on success, -1 on failure
+ ***********************************************/
+int FEED_Poke(FILE *ram, long address, long value) {
+    unsigned char byte = (unsigned char)value;
+
+    if (address < 0 || address >= FEED_RAM_SIZE) {
+        fprintf(stderr, "address 0x%lX is outside of the RAM\n", address);
+        return 0;
+    }
+    if (fseek(ram, address, SEEK_SET) != 0 || fwrite(&byte, 1, 1, ram) != 1 || fflush(ram) != 0)
+        return -1;
+
+    printf("0x%04lX = 0x%02lX\n", address, value & 0xFF);
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned char zeros[FEED_RAM_SIZE];
+    char line[128];
+    long elapsed = 0;
+    FILE *script = stdin;
+    FILE *ram;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: RamFeed <path> [script]\n");
+        return EXIT_FAILURE;
+    }
+
+    // Full size from the start, the tracker won't map anything smaller than it reads
+    memset(zeros, 0, sizeof(zeros));
+    ram = fopen(argv[1], "wb");
+    if (ram == NULL || fwrite(zeros, 1, sizeof(zeros), ram) != sizeof(zeros)) {
+        fprintf(stderr, "unable to write %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    fclose(ram);
+
+    ram = fopen(argv[1], "r+b");
+    if (ram == NULL) {
+        fprintf(stderr, "unable to open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (argc > 2) {
+        script = fopen(argv[2], "r");
+        if (script == NULL) {
+            fprintf(stderr, "unable to open %s\n", argv[2]);
+            fclose(ram);
+            return EXIT_FAILURE;
+        }
+    }
+
+    while (fgets(line, sizeof(line), script) != NULL) {
+        long ms = 0, address, value;
+        char *at = line, *end;
+
+        while (*at == ' ' || *at == '\t')
+            at++;
+        if (*at == '#' || *at == '\n' || *at == '\r' || *at == '\0')
+            continue;
+
+        if (script != stdin) {
+            ms = strtol(at, &end, 0);
+            at = end;
+        }
+        address = strtol(at, &end, 0);
+        if (end == at) {
+            fprintf(stderr, "can't read '%s'\n", line);
+            continue;
+        }
+        at = end;
+        value = strtol(at, &end, 0);
+        if (end == at) {
+            fprintf(stderr, "can't read '%s'\n", line);
+            continue;
+        }
+
+        if (ms > elapsed) {
+            FEED_Sleep(ms - elapsed);
+            elapsed = ms;
+        }
+        if (FEED_Poke(ram, address, value) != 0) {
+            fprintf(stderr, "unable to write %s\n", argv[1]);
+            break;
+        }
+    }
+
+    if (script != stdin)
+        fclose(script);
+    fclose(ram);
+    return 0;
+}
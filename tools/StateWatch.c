@@ -0,0 +1,152 @@
+/*
+ * Minimal client for the tracker's state server (see GameServer.h), prints every message as
+ * it arrives. Handy for checking the protocol and as a starting point for an overlay.
+ *
+ *   StateWatch [port]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET WATCH_Socket;
+#define WATCH_NO_SOCKET INVALID_SOCKET
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int WATCH_Socket;
+#define WATCH_NO_SOCKET (-1)
+#endif
+
+#define WATCH_MAX_SLOTS 4096
+#define WATCH_MSG_FULL 1    // GS_MSG_FULL
+#define WATCH_MSG_DELTA 2   // GS_MSG_DELTA
+
+const int WATCH_DEFAULT_PORT = 8642;
+
+char WATCH_NAMES[WATCH_MAX_SLOTS][32];
+int WATCH_TOTAL_SLOTS = 0;
+
+
+uint32_t WATCH_Get16(const uint8_t *at) {
+    return (uint32_t)at[0] | ((uint32_t)at[1] << 8);
+}
+
+uint32_t WATCH_Get32(const uint8_t *at) {
+    return WATCH_Get16(at) | (WATCH_Get16(at + 2) << 16);
+}
+
+/********************************************//**
+ * @brief
+ * Reads exactly length bytes
+ * @return int
+ * 0 on success, -1 once the server is gone
+ ***********************************************/
+int WATCH_Read(WATCH_Socket socket, uint8_t *into, size_t length) {
+    while (length > 0) {
+        int got = (int)recv(socket, (char *)into, (int)length, 0);
+        if (got <= 0)
+            return -1;
+        into += got;
+        length -= (size_t)got;
+    }
+    return 0;
+}
+
+void WATCH_PrintSlot(int slot, int state, int tag) {
+    printf("  %4d %-24s %s%s", slot, (slot < WATCH_TOTAL_SLOTS) ? WATCH_NAMES[slot] : "?",
+           (state & 0x01) ? "on " : "off", (state & 0x04) ? " disabled" : "");
+    if (tag >= 0)
+        printf(" dungeon %d", tag);
+    printf("\n");
+}
+
+void WATCH_Full(const uint8_t *payload, size_t length) {
+    const uint8_t *at = payload + 4;
+    const uint8_t *end = payload + length;
+    int total = (length >= 4) ? (int)WATCH_Get32(payload) : 0;
+
+    printf("full, %d slots\n", total);
+    WATCH_TOTAL_SLOTS = (total < WATCH_MAX_SLOTS) ? total : WATCH_MAX_SLOTS;
+    for (int i = 0; i < total && at + 3 <= end; i++) {
+        int state = at[0];
+        int tag = (int8_t)at[1];
+        size_t name_length = at[2];
+
+        at += 3;
+        if (at + name_length > end)
+            break;
+        if (i < WATCH_MAX_SLOTS) {
+            size_t copy = (name_length < sizeof(WATCH_NAMES[i])) ? name_length : sizeof(WATCH_NAMES[i]) - 1;
+            memcpy(WATCH_NAMES[i], at, copy);
+            WATCH_NAMES[i][copy] = '\0';
+        }
+        at += name_length;
+        WATCH_PrintSlot(i, state, tag);
+    }
+}
+
+void WATCH_Delta(const uint8_t *payload, size_t length) {
+    int total = (length >= 4) ? (int)WATCH_Get32(payload) : 0;
+
+    printf("delta, %d changes\n", total);
+    for (int i = 0; i < total && 4 + (size_t)(i + 1) * 6 <= length; i++) {
+        const uint8_t *at = payload + 4 + i * 6;
+        WATCH_PrintSlot((int)WATCH_Get32(at), at[4], (int8_t)at[5]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    struct sockaddr_in address;
+    WATCH_Socket server;
+    uint8_t header[5];
+    uint8_t *payload = NULL;
+    int port = (argc > 1) ? atoi(argv[1]) : WATCH_DEFAULT_PORT;
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)port);
+
+    server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server == WATCH_NO_SOCKET || connect(server, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Unable to connect to the tracker on port %d\n", port);
+        return EXIT_FAILURE;
+    }
+
+    while (WATCH_Read(server, header, sizeof(header)) == 0) {
+        size_t length = WATCH_Get32(header);
+        uint8_t *grown;
+
+        // The length covers the type byte we already have
+        if (length < 1)
+            break;
+        length--;
+
+        grown = realloc(payload, length + 1);
+        if (grown == NULL)
+            break;
+        payload = grown;
+        if (WATCH_Read(server, payload, length) != 0)
+            break;
+
+        if (header[4] == WATCH_MSG_FULL)
+            WATCH_Full(payload, length);
+        else if (header[4] == WATCH_MSG_DELTA)
+            WATCH_Delta(payload, length);
+        fflush(stdout);
+    }
+
+    printf("disconnected\n");
+    free(payload);
+    return EXIT_SUCCESS;
+}